@@ -42,7 +42,6 @@
 
 /* Scheduler Related */
 #define configUSE_PREEMPTION                    1
-#define configUSE_TICKLESS_IDLE                 0
 #define configUSE_IDLE_HOOK                     1
 #define configUSE_TICK_HOOK                     0
 #define configTICK_RATE_HZ                      ( ( TickType_t ) 1000 )
@@ -69,10 +68,23 @@
 #define configSTACK_DEPTH_TYPE                  uint32_t
 #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
 
-/* Memory allocation related definitions. */
-#define configSUPPORT_STATIC_ALLOCATION         0
+/* Memory allocation related definitions. FREERTOS_HEAP, FREERTOS_HEAP_SIZE
+ * and STATIC_ALLOCATION are set from CMake. In the static build the kernel
+ * supplies the idle and timer task memory; lwIP, the CYW43 driver and mbedTLS
+ * still allocate dynamically. */
+#ifndef FREERTOS_HEAP
+#define FREERTOS_HEAP                           3
+#endif
+#ifndef FREERTOS_HEAP_SIZE
+#define FREERTOS_HEAP_SIZE                      (128*1024)
+#endif
+#ifndef STATIC_ALLOCATION
+#define STATIC_ALLOCATION                       0
+#endif
+#define configSUPPORT_STATIC_ALLOCATION         STATIC_ALLOCATION
+#define configKERNEL_PROVIDED_STATIC_MEMORY     1
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
-#define configTOTAL_HEAP_SIZE                   (128*1024)
+#define configTOTAL_HEAP_SIZE                   FREERTOS_HEAP_SIZE
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
 /* Hook function related definitions. */
@@ -81,10 +93,19 @@
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+#define configGENERATE_RUN_TIME_STATS           1
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
+/* Run time stats count microseconds from the free running 64-bit timer, so
+ * there is nothing to configure and the counters never wrap. */
+#define configRUN_TIME_COUNTER_TYPE             uint64_t
+#ifndef __ASSEMBLER__
+#include "hardware/timer.h"
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        time_us_64()
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         1
@@ -113,8 +134,24 @@
 #if configNUMBER_OF_CORES > 1
 #define configUSE_CORE_AFFINITY                 1
 #endif
-#define configUSE_PASSIVE_IDLE_HOOK             0
+#define configUSE_PASSIVE_IDLE_HOOK             1
+#endif
+
+/* Low power. With a single core the kernel stops the tick while nothing is
+ * due and sleeps in the port. In the SMP build every core's idle task sits in
+ * the idle ready list, so the kernel never predicts an idle period and the
+ * idle hooks wait for the next interrupt instead. */
+#if !defined( configNUMBER_OF_CORES ) || ( configNUMBER_OF_CORES == 1 )
+#define configUSE_TICKLESS_IDLE                 1
+#else
+#define configUSE_TICKLESS_IDLE                 0
+#endif
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
+#ifndef __ASSEMBLER__
+#include "sleep_stats.h"
 #endif
+#define configPRE_SLEEP_PROCESSING( x )         sleep_stats_pre_sleep()
+#define configPOST_SLEEP_PROCESSING( x )        sleep_stats_post_sleep()
 
 /* RP2040 specific */
 #define configSUPPORT_PICO_SYNC_INTEROP         1
@@ -152,6 +189,7 @@ to exclude the API function. */
 #endif
 
 /* A header file that defines trace macro can be included here. */
+#include "trace_hooks.h"
 
 #endif /* FREERTOS_CONFIG_H */
 
@@ -0,0 +1,48 @@
+#include "boot_timeline.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+#include "pico/stdlib.h"
+
+#include "console.hpp"
+
+static const char *const mark_names[BOOT_MARK_COUNT] = {
+    "tasks started", "cache restored", "Wi-Fi chip ready",
+    "display ready", "first pixel",    "link up",
+    "address bound", "first fetch",    "first live frame",
+};
+
+// 0 until reached. The timer starts counting at reset, and nothing is
+// marked before the scheduler runs, so a real mark is never 0.
+static std::atomic<uint32_t> mark_ms[BOOT_MARK_COUNT];
+
+static void cmd_boot(int argc, char **argv) {
+	(void)argc;
+	(void)argv;
+	boot_timeline_print();
+}
+
+void boot_timeline_init() {
+	console_register("boot", "boot timeline", cmd_boot);
+}
+
+bool boot_timeline_mark(BootMark mark) {
+	uint32_t now = to_ms_since_boot(get_absolute_time());
+	uint32_t unset = 0;
+	return mark_ms[mark].compare_exchange_strong(unset, now ? now : 1);
+}
+
+uint32_t boot_timeline_ms(BootMark mark) { return mark_ms[mark].load(); }
+
+void boot_timeline_print() {
+	printf("Boot timeline, ms since reset:\n");
+	for (int i = 0; i < BOOT_MARK_COUNT; i++) {
+		uint32_t ms = mark_ms[i].load();
+		if (ms == 0) {
+			printf("  %-17s %8s\n", mark_names[i], "-");
+		} else {
+			printf("  %-17s %8lu\n", mark_names[i], (unsigned long)ms);
+		}
+	}
+}
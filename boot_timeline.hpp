@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Milestones of a boot, in the order they usually happen. The network and
+// render cores reach theirs independently, so the order can vary.
+enum BootMark : uint8_t {
+	BOOT_MARK_TASKS_STARTED, // main task running under the scheduler
+	BOOT_MARK_CACHE,         // flash cache read back, hit or miss
+	BOOT_MARK_WIFI_CHIP,     // Wi-Fi chip firmware loaded
+	BOOT_MARK_DISPLAY,       // display driver ready
+	BOOT_MARK_FIRST_PIXEL,   // first frame on the panel
+	BOOT_MARK_LINK_UP,       // associated with the access point
+	BOOT_MARK_IP_BOUND,      // DHCP lease bound
+	BOOT_MARK_FIRST_FETCH,   // first series parsed from the server
+	BOOT_MARK_FIRST_LIVE,    // first frame drawn from fetched data
+	BOOT_MARK_COUNT,
+};
+
+// Register the 'boot' console command
+void boot_timeline_init();
+
+// Note that a milestone has been reached. Only the first call for each
+// counts, and returns true. Safe from either core.
+bool boot_timeline_mark(BootMark mark);
+
+// Milliseconds from reset to the milestone, 0 if it hasn't been reached
+uint32_t boot_timeline_ms(BootMark mark);
+
+// Every milestone with its time since reset
+void boot_timeline_print();
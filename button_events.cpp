@@ -0,0 +1,171 @@
+#include "button_events.hpp"
+
+#include <cstdio>
+
+#include "FreeRTOS.h"
+#include "hardware/gpio.h"
+#include "queue.h"
+#include "timers.h"
+
+#include "display.hpp"
+#include "render_scheduler.hpp"
+#include "trace_buffer.h"
+
+static const uint32_t BUTTON_EDGES = GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE;
+
+struct ButtonState {
+	Button *button;
+	TimerHandle_t debounce_timer; // Fires once the input has settled
+	TimerHandle_t hold_timer;     // Drives repeat and long-press while held
+	bool down;
+	bool long_sent;
+	uint32_t pressed_ms;
+#if STATIC_ALLOCATION
+	StaticTimer_t debounce_timer_buffer;
+	StaticTimer_t hold_timer_buffer;
+#endif
+};
+
+static ButtonState buttons[BUTTON_COUNT] = {
+    {&button_a}, {&button_b}, {&button_x}, {&button_y}};
+
+static QueueHandle_t button_queue = NULL;
+#if STATIC_ALLOCATION
+static StaticQueue_t button_queue_buffer;
+static uint8_t button_queue_storage[BUTTON_EVENT_QUEUE_LENGTH *
+                                    sizeof(ButtonEvent)];
+#endif
+
+static uint32_t now_ms() { return to_ms_since_boot(get_absolute_time()); }
+
+static void emit(ButtonId id, ButtonEventType type) {
+	ButtonEvent event = {id, type};
+	if (xQueueSend(button_queue, &event, 0) != pdTRUE) {
+		printf("Button event queue full, dropping event\n");
+		return;
+	}
+	render_scheduler_notify(RENDER_EVENT_BUTTON);
+}
+
+// Edge interrupt: mask the pin while it bounces and let the debounce timer
+// sample it once it has been quiet for BUTTON_DEBOUNCE_MS
+static void button_gpio_irq(uint gpio, uint32_t events) {
+	(void)events;
+	BaseType_t higher_priority_woken = pdFALSE;
+	for (auto &state : buttons) {
+		if (state.button->get_pin() == gpio) {
+			gpio_set_irq_enabled(gpio, BUTTON_EDGES, false);
+			xTimerResetFromISR(state.debounce_timer, &higher_priority_woken);
+			break;
+		}
+	}
+	portYIELD_FROM_ISR(higher_priority_woken);
+}
+
+static void debounce_callback(TimerHandle_t timer) {
+	ButtonId id = (ButtonId)(uintptr_t)pvTimerGetTimerID(timer);
+	ButtonState &state = buttons[id];
+	Button &button = *state.button;
+
+	bool down = button.raw();
+	if (down != state.down) {
+		state.down = down;
+		if (down) {
+			state.pressed_ms = now_ms();
+			state.long_sent = false;
+			emit(id, BUTTON_EVENT_PRESS);
+			// Same auto-repeat rules as Button::read()
+			if (button.get_repeat_time() > 0) {
+				xTimerChangePeriod(state.hold_timer,
+				                   pdMS_TO_TICKS(button.get_repeat_time()), 0);
+			}
+		} else {
+			xTimerStop(state.hold_timer, 0);
+			emit(id, BUTTON_EVENT_RELEASE);
+		}
+	}
+
+	gpio_acknowledge_irq(button.get_pin(), BUTTON_EDGES);
+	gpio_set_irq_enabled(button.get_pin(), BUTTON_EDGES, true);
+
+	// An edge that landed between the sample and unmasking would be lost
+	if (button.raw() != state.down) {
+		xTimerReset(timer, 0);
+	}
+}
+
+static void hold_callback(TimerHandle_t timer) {
+	ButtonId id = (ButtonId)(uintptr_t)pvTimerGetTimerID(timer);
+	ButtonState &state = buttons[id];
+	Button &button = *state.button;
+
+	if (!state.down) {
+		xTimerStop(timer, 0);
+		return;
+	}
+
+	uint32_t hold_time = button.get_hold_time();
+	if (!state.long_sent && hold_time > 0 &&
+	    now_ms() - state.pressed_ms > hold_time) {
+		state.long_sent = true;
+		emit(id, BUTTON_EVENT_LONG_PRESS);
+		// Button::read() repeats three times faster once held
+		uint32_t repeat_rate = button.get_repeat_time() / 3;
+		xTimerChangePeriod(timer, pdMS_TO_TICKS(repeat_rate ? repeat_rate : 1),
+		                   0);
+	}
+	emit(id, BUTTON_EVENT_REPEAT);
+}
+
+void button_events_init() {
+#if STATIC_ALLOCATION
+	button_queue =
+	    xQueueCreateStatic(BUTTON_EVENT_QUEUE_LENGTH, sizeof(ButtonEvent),
+	                       button_queue_storage, &button_queue_buffer);
+#else
+	button_queue = xQueueCreate(BUTTON_EVENT_QUEUE_LENGTH, sizeof(ButtonEvent));
+#endif
+	if (button_queue == NULL) {
+		printf("Failed to create button event queue\n");
+		return;
+	}
+	trace_buffer_name_object(button_queue, "button_queue");
+
+	for (int i = 0; i < BUTTON_COUNT; i++) {
+		ButtonState &state = buttons[i];
+#if STATIC_ALLOCATION
+		state.debounce_timer = xTimerCreateStatic(
+		    "ButtonDebounce", pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS), pdFALSE,
+		    (void *)(uintptr_t)i, debounce_callback,
+		    &state.debounce_timer_buffer);
+		state.hold_timer =
+		    xTimerCreateStatic("ButtonHold", pdMS_TO_TICKS(1000), pdTRUE,
+		                       (void *)(uintptr_t)i, hold_callback,
+		                       &state.hold_timer_buffer);
+#else
+		state.debounce_timer =
+		    xTimerCreate("ButtonDebounce", pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS),
+		                 pdFALSE, (void *)(uintptr_t)i, debounce_callback);
+		state.hold_timer =
+		    xTimerCreate("ButtonHold", pdMS_TO_TICKS(1000), pdTRUE,
+		                 (void *)(uintptr_t)i, hold_callback);
+#endif
+		if (state.debounce_timer == NULL || state.hold_timer == NULL) {
+			printf("Failed to create button timers\n");
+			return;
+		}
+		state.down = state.button->raw();
+	}
+
+	for (auto &state : buttons) {
+		gpio_set_irq_enabled_with_callback(state.button->get_pin(),
+		                                   BUTTON_EDGES, true,
+		                                   &button_gpio_irq);
+	}
+}
+
+bool button_events_get(ButtonEvent &event) {
+	if (button_queue == NULL)
+		return false;
+	return xQueueReceive(button_queue, &event, 0) == pdTRUE;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// Quiet time an input must hold before an edge is accepted
+#define BUTTON_DEBOUNCE_MS 20
+#define BUTTON_EVENT_QUEUE_LENGTH 16
+
+enum ButtonId : uint8_t {
+	BUTTON_A = 0,
+	BUTTON_B,
+	BUTTON_X,
+	BUTTON_Y,
+	BUTTON_COUNT
+};
+
+enum ButtonEventType : uint8_t {
+	BUTTON_EVENT_PRESS,
+	BUTTON_EVENT_RELEASE,
+	BUTTON_EVENT_LONG_PRESS, // Sent once when a press passes the hold time
+	BUTTON_EVENT_REPEAT,     // Auto-repeat while held, faster after hold time
+};
+
+struct ButtonEvent {
+	ButtonId button;
+	ButtonEventType type;
+};
+
+// Attach edge interrupts to the Pico Display buttons. Each event is queued
+// and also raises RENDER_EVENT_BUTTON, so the render loop wakes to consume it.
+void button_events_init();
+
+// Fetch the next queued event without blocking
+bool button_events_get(ButtonEvent &event);
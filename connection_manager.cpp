@@ -0,0 +1,189 @@
+#include "connection_manager.hpp"
+
+#include <cstdio>
+
+#include "net_stats.h"
+#include "pico/rand.h"
+#include "pico/stdlib.h"
+
+static ServerEndpoint endpoints[CONNECTION_MAX_ENDPOINTS];
+static size_t num_endpoints = 0;
+
+// Endpoint used by the current session, for success/failure reports
+static ServerEndpoint *active_endpoint = nullptr;
+
+// Number of back-to-back failed cycles across all endpoints
+static uint32_t failure_streak = 0;
+
+static uint32_t now_ms() { return to_ms_since_boot(get_absolute_time()); }
+
+// Full backoff window for a given number of failures, capped at the maximum
+static uint32_t backoff_window_ms(uint32_t failures) {
+	if (failures == 0)
+		return 0;
+	uint32_t shift = failures - 1;
+	if (shift > 16)
+		shift = 16;
+	uint64_t window = (uint64_t)CONNECTION_BACKOFF_BASE_MS << shift;
+	if (window > CONNECTION_BACKOFF_MAX_MS)
+		window = CONNECTION_BACKOFF_MAX_MS;
+	return (uint32_t)window;
+}
+
+// "Equal jitter": half the window is fixed, the other half is random, so
+// devices that lost the server together don't reconnect in lockstep
+static uint32_t jittered_backoff_ms(uint32_t failures) {
+	uint32_t window = backoff_window_ms(failures);
+	if (window == 0)
+		return 0;
+	uint32_t half = window / 2;
+	return half + get_rand_32() % (half + 1);
+}
+
+static void record_failure(ServerEndpoint &ep) {
+	ep.health -= CONNECTION_HEALTH_FAILURE_PENALTY;
+	if (ep.health < 0)
+		ep.health = 0;
+	ep.consecutive_failures++;
+	ep.retry_at_ms = now_ms() + jittered_backoff_ms(ep.consecutive_failures);
+	// The address may have moved, so look it up again next time
+	ep.addr_valid = false;
+}
+
+static void record_success(ServerEndpoint &ep) {
+	ep.health += CONNECTION_HEALTH_SUCCESS_BONUS;
+	if (ep.health > CONNECTION_HEALTH_MAX)
+		ep.health = CONNECTION_HEALTH_MAX;
+	ep.consecutive_failures = 0;
+	ep.retry_at_ms = 0;
+}
+
+static bool resolve_endpoint(ServerEndpoint &ep) {
+	uint32_t now = now_ms();
+	if (ep.addr_valid && now - ep.resolved_at_ms < CONNECTION_DNS_TTL_MS) {
+		return true;
+	}
+
+	if (!tls_client_resolve(ep.host, &ep.addr, CONNECTION_DNS_TIMEOUT_MS)) {
+		ep.addr_valid = false;
+		return false;
+	}
+	ep.addr_valid = true;
+	ep.resolved_at_ms = now;
+	return true;
+}
+
+// Pick the healthiest endpoint that hasn't been tried yet this round and
+// isn't cooling down. Falls back to ignoring cooldowns if everything is
+// cooling down, so a lone endpoint still gets retried.
+static ServerEndpoint *next_candidate(const bool *tried, bool honour_cooldown) {
+	uint32_t now = now_ms();
+	ServerEndpoint *best = nullptr;
+	for (size_t i = 0; i < num_endpoints; i++) {
+		ServerEndpoint &ep = endpoints[i];
+		if (tried[i])
+			continue;
+		if (honour_cooldown && ep.retry_at_ms != 0 &&
+		    (int32_t)(ep.retry_at_ms - now) > 0)
+			continue;
+		if (!best || ep.health > best->health)
+			best = &ep;
+	}
+	return best;
+}
+
+bool connection_manager_add_endpoint(const char *host, uint16_t port,
+                                     const char *sni) {
+	if (num_endpoints >= CONNECTION_MAX_ENDPOINTS) {
+		printf("Connection manager: endpoint table full, ignoring %s\n", host);
+		return false;
+	}
+
+	ServerEndpoint &ep = endpoints[num_endpoints++];
+	ep = ServerEndpoint{};
+	ep.host = host;
+	ep.port = port;
+	ep.sni = sni;
+	ep.health = CONNECTION_HEALTH_MAX;
+	return true;
+}
+
+TLS_CLIENT_HANDLE connection_manager_connect(const uint8_t *cert,
+                                             size_t cert_len) {
+	bool tried[CONNECTION_MAX_ENDPOINTS] = {};
+	active_endpoint = nullptr;
+
+	for (size_t attempt = 0; attempt < num_endpoints; attempt++) {
+		ServerEndpoint *ep = next_candidate(tried, true);
+		if (!ep && attempt == 0) {
+			ep = next_candidate(tried, false);
+		}
+		if (!ep)
+			break;
+		tried[ep - endpoints] = true;
+		if (attempt > 0 || failure_streak > 0) {
+			net_stats_add(NET_COUNTER_RETRIES, 1);
+		}
+
+		if (!resolve_endpoint(*ep)) {
+			printf("Connection manager: cannot resolve %s\n", ep->host);
+			record_failure(*ep);
+			continue;
+		}
+
+		TLS_CLIENT_HANDLE handle =
+		    tls_client_connect_addr(&ep->addr, ep->port, ep->sni, cert, cert_len);
+		if (handle) {
+			active_endpoint = ep;
+			return handle;
+		}
+
+		printf("Connection manager: %s:%d failed (health %d)\n", ep->host,
+		       ep->port, ep->health);
+		record_failure(*ep);
+	}
+
+	failure_streak++;
+	return nullptr;
+}
+
+void connection_manager_report_success() {
+	if (active_endpoint)
+		record_success(*active_endpoint);
+	failure_streak = 0;
+}
+
+void connection_manager_report_failure() {
+	if (active_endpoint)
+		record_failure(*active_endpoint);
+	active_endpoint = nullptr;
+	failure_streak++;
+}
+
+void connection_manager_reset_backoff() {
+	for (size_t i = 0; i < num_endpoints; i++) {
+		endpoints[i].consecutive_failures = 0;
+		endpoints[i].retry_at_ms = 0;
+		// The new lease may come with a different DNS server
+		endpoints[i].addr_valid = false;
+	}
+	failure_streak = 0;
+}
+
+uint32_t connection_manager_retry_delay_ms() {
+	return jittered_backoff_ms(failure_streak);
+}
+
+void connection_manager_print_status() {
+	uint32_t now = now_ms();
+	printf("Endpoints (failure streak %lu):\n", (unsigned long)failure_streak);
+	for (size_t i = 0; i < num_endpoints; i++) {
+		const ServerEndpoint &ep = endpoints[i];
+		int32_t cooldown = (int32_t)(ep.retry_at_ms - now);
+		printf("  %s:%d health=%d failures=%lu dns=%s cooldown=%ldms\n",
+		       ep.host, ep.port, ep.health,
+		       (unsigned long)ep.consecutive_failures,
+		       ep.addr_valid ? ipaddr_ntoa(&ep.addr) : "-",
+		       (long)(ep.retry_at_ms != 0 && cooldown > 0 ? cooldown : 0));
+	}
+}
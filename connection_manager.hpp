@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tls_client.h"
+
+// Maximum number of server endpoints the manager can fail over between
+#define CONNECTION_MAX_ENDPOINTS 4
+
+// How long a resolved address is reused before DNS is queried again
+#define CONNECTION_DNS_TTL_MS (10 * 60 * 1000)
+#define CONNECTION_DNS_TIMEOUT_MS 5000
+
+// Exponential backoff bounds for reconnect attempts
+#define CONNECTION_BACKOFF_BASE_MS 2000
+#define CONNECTION_BACKOFF_MAX_MS (5 * 60 * 1000)
+
+// Health score range; every endpoint starts out fully healthy
+#define CONNECTION_HEALTH_MAX 100
+#define CONNECTION_HEALTH_SUCCESS_BONUS 10
+#define CONNECTION_HEALTH_FAILURE_PENALTY 30
+
+struct ServerEndpoint {
+	const char *host;
+	uint16_t port;
+	const char *sni;
+
+	// DNS cache
+	ip_addr_t addr;
+	bool addr_valid;
+	uint32_t resolved_at_ms;
+
+	// Health tracking
+	int health;
+	uint32_t consecutive_failures;
+	uint32_t retry_at_ms;
+};
+
+// Register a server endpoint. Endpoints are tried in order of health score.
+bool connection_manager_add_endpoint(const char *host, uint16_t port,
+                                     const char *sni);
+
+// Connect to the healthiest endpoint that isn't cooling down, failing over to
+// the next one on error. Returns NULL if every candidate failed.
+TLS_CLIENT_HANDLE connection_manager_connect(const uint8_t *cert,
+                                             size_t cert_len);
+
+// Report the outcome of the session on the last connected endpoint
+void connection_manager_report_success();
+void connection_manager_report_failure();
+
+// Forget failures, cooldowns and cached addresses, for when the network
+// itself was the problem. Health scores are kept.
+void connection_manager_reset_backoff();
+
+// Delay before the next connection attempt: exponential backoff with jitter
+// while failing, 0 once the last session succeeded
+uint32_t connection_manager_retry_delay_ms();
+
+// Dump the endpoint table over stdio
+void connection_manager_print_status();
@@ -0,0 +1,112 @@
+#include "console.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "FreeRTOS.h"
+#include "pico/stdlib.h"
+#include "task.h"
+
+#include "task_registry.hpp"
+
+#define CONSOLE_TASK_PRIORITY (tskIDLE_PRIORITY + 1UL)
+#define CONSOLE_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+
+struct ConsoleCommand {
+	const char *name;
+	const char *help;
+	ConsoleHandler handler;
+};
+
+static ConsoleCommand commands[CONSOLE_MAX_COMMANDS];
+static int num_commands = 0;
+static TaskHandle_t console_task_handle = NULL;
+
+static void cmd_help(int argc, char **argv) {
+	(void)argc;
+	(void)argv;
+	for (int i = 0; i < num_commands; i++) {
+		printf("  %-8s %s\n", commands[i].name, commands[i].help);
+	}
+}
+
+bool console_register(const char *name, const char *help,
+                      ConsoleHandler handler) {
+	if (num_commands >= CONSOLE_MAX_COMMANDS) {
+		printf("Console full, cannot register '%s'\n", name);
+		return false;
+	}
+	commands[num_commands++] = {name, help, handler};
+	return true;
+}
+
+static void run_line(char *line) {
+	char *argv[CONSOLE_MAX_ARGS];
+	int argc = 0;
+	char *save = NULL;
+	for (char *tok = strtok_r(line, " \t", &save);
+	     tok && argc < CONSOLE_MAX_ARGS; tok = strtok_r(NULL, " \t", &save)) {
+		argv[argc++] = tok;
+	}
+	if (argc == 0)
+		return;
+
+	for (int i = 0; i < num_commands; i++) {
+		if (strcmp(argv[0], commands[i].name) == 0) {
+			commands[i].handler(argc, argv);
+			return;
+		}
+	}
+	printf("Unknown command '%s', try 'help'\n", argv[0]);
+}
+
+// Called by the USB stdio driver from interrupt context when input arrives
+static void chars_available(void *param) {
+	(void)param;
+	if (console_task_handle == NULL)
+		return;
+	BaseType_t higher_priority_woken = pdFALSE;
+	vTaskNotifyGiveFromISR(console_task_handle, &higher_priority_woken);
+	portYIELD_FROM_ISR(higher_priority_woken);
+}
+
+static void console_task(__unused void *params) {
+	char line[CONSOLE_MAX_LINE];
+	size_t len = 0;
+
+	while (true) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		int c;
+		while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+			if (c == '\r' || c == '\n') {
+				if (len == 0)
+					continue;
+				putchar('\n');
+				line[len] = '\0';
+				run_line(line);
+				len = 0;
+				printf("> ");
+			} else if ((c == '\b' || c == 0x7f) && len > 0) {
+				len--;
+				printf("\b \b");
+			} else if (c >= ' ' && len < sizeof(line) - 1) {
+				line[len++] = (char)c;
+				putchar(c);
+			}
+		}
+	}
+}
+
+void console_init() {
+	console_register("help", "list commands", cmd_help);
+
+	if (task_registry_create(console_task, "ConsoleThread",
+	                         CONSOLE_TASK_STACK_SIZE, CONSOLE_TASK_PRIORITY,
+	                         tskNO_AFFINITY, &console_task_handle) != pdPASS) {
+		return;
+	}
+	stdio_set_chars_available_callback(chars_available, NULL);
+	// Pick up anything typed before the callback was installed
+	xTaskNotifyGive(console_task_handle);
+}
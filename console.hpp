@@ -0,0 +1,17 @@
+#pragma once
+
+// Line-based command console on USB stdio. Type a command name followed by
+// space separated arguments and press enter; "help" lists what is available.
+
+#define CONSOLE_MAX_COMMANDS 16
+#define CONSOLE_MAX_LINE 64
+#define CONSOLE_MAX_ARGS 6
+
+typedef void (*ConsoleHandler)(int argc, char **argv);
+
+// Add a command. name and help must outlive the console (string literals).
+bool console_register(const char *name, const char *help,
+                      ConsoleHandler handler);
+
+// Start the console task. It sleeps until USB stdio reports input.
+void console_init();
@@ -0,0 +1,73 @@
+#include "core_load.h"
+
+#include "FreeRTOS.h"
+#include "pico/stdlib.h"
+#include "task.h"
+
+// Idle tasks aren't pinned, so any of them may run on either core
+static TaskHandle_t idle_tasks[CORE_LOAD_MAX_CORES];
+static volatile bool ready = false;
+
+// Each core only writes its own entries, from inside its context switch
+static volatile uint32_t idle_since_us[CORE_LOAD_MAX_CORES];
+static volatile uint32_t idle_total_us[CORE_LOAD_MAX_CORES];
+static volatile bool in_idle[CORE_LOAD_MAX_CORES];
+
+static bool current_is_idle(void) {
+	TaskHandle_t current = xTaskGetCurrentTaskHandle();
+	for (int i = 0; i < configNUMBER_OF_CORES && i < CORE_LOAD_MAX_CORES; i++) {
+		if (current == idle_tasks[i])
+			return true;
+	}
+	return false;
+}
+
+void core_load_init(void) {
+	for (int i = 0; i < configNUMBER_OF_CORES && i < CORE_LOAD_MAX_CORES; i++) {
+		idle_tasks[i] = xTaskGetIdleTaskHandleForCore(i);
+	}
+	ready = true;
+}
+
+void core_load_task_switched_in(void) {
+	if (!ready)
+		return;
+	uint32_t core = portGET_CORE_ID();
+	if (current_is_idle()) {
+		idle_since_us[core] = time_us_32();
+		in_idle[core] = true;
+	}
+}
+
+void core_load_task_switched_out(void) {
+	if (!ready)
+		return;
+	uint32_t core = portGET_CORE_ID();
+	if (in_idle[core]) {
+		idle_total_us[core] += time_us_32() - idle_since_us[core];
+		in_idle[core] = false;
+	}
+}
+
+void core_load_snapshot(CoreLoadSnapshot *snapshot) {
+	uint32_t now = time_us_32();
+	snapshot->time_us = now;
+	for (int i = 0; i < CORE_LOAD_MAX_CORES; i++) {
+		uint32_t idle = idle_total_us[i];
+		// Count the idle stretch that is still in progress
+		if (in_idle[i])
+			idle += now - idle_since_us[i];
+		snapshot->idle_us[i] = idle;
+	}
+}
+
+uint32_t core_load_busy_percent(const CoreLoadSnapshot *prev,
+                                const CoreLoadSnapshot *cur, uint32_t core) {
+	if (core >= CORE_LOAD_MAX_CORES)
+		return 0;
+	uint32_t elapsed = cur->time_us - prev->time_us;
+	uint32_t idle = cur->idle_us[core] - prev->idle_us[core];
+	if (elapsed == 0 || idle >= elapsed)
+		return 0;
+	return (uint32_t)(((uint64_t)(elapsed - idle) * 100) / elapsed);
+}
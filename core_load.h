@@ -0,0 +1,51 @@
+#ifndef CORE_LOAD_H
+#define CORE_LOAD_H
+
+#include <stdint.h>
+
+#define CORE_LOAD_MAX_CORES 2
+
+// Cumulative idle time per core, in microseconds, as of time_us
+typedef struct {
+	uint32_t time_us;
+	uint32_t idle_us[CORE_LOAD_MAX_CORES];
+} CoreLoadSnapshot;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start accounting. Must be called once the scheduler is running, since it
+ * looks up the idle task handles.
+ */
+void core_load_init(void);
+
+/**
+ * Context switch hooks, called from traceTASK_SWITCHED_IN/OUT on the core
+ * doing the switch
+ */
+void core_load_task_switched_in(void);
+void core_load_task_switched_out(void);
+
+/**
+ * Read the idle time counters
+ * @param snapshot Receives the current totals
+ */
+void core_load_snapshot(CoreLoadSnapshot *snapshot);
+
+/**
+ * Busy percentage of a core between two snapshots
+ * @param prev The earlier snapshot
+ * @param cur The later snapshot
+ * @param core The core to report
+ * @return 0-100
+ */
+uint32_t core_load_busy_percent(const CoreLoadSnapshot *prev,
+                                const CoreLoadSnapshot *cur, uint32_t core);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CORE_LOAD_H
@@ -1,8 +1,10 @@
 #include "display.hpp"
 #include "hardware/rtc.h"
+#include "net_stats.h"
 #include "pico/rand.h"
 #include "pico/util/datetime.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
@@ -43,15 +45,33 @@ static Pen TEXT_WHITE;
 static Pen TEXT_GREEN;
 static Pen LINE_WHITE;
 static Pen FOOTER_BG;
+static Pen BAND_BLUE;
+static Pen EMA_ORANGE;
 
-// --- Stock Data ---
-StockData stock_data;
+// The chart last drawn, reused until the data or the view changes. Only the
+// render loop draws.
+static ChartLayout chart_layout;
+static bool chart_layout_valid = false;
+
+// The series and indicators the chart is drawn from, rebuilt from the
+// candles of a StockData whenever its revision changes. Revision 0 is the
+// empty series they start as.
+static StockHistory chart_history;
+static StockIndicators chart_indicators;
+static uint32_t chart_history_revision = 0;
+
+// Source of StockData revisions. Fills happen on either core.
+static std::atomic<uint32_t> next_revision{1};
 
 // Forward declarations of internal functions
 namespace display_internal {
-void draw_header(const StockData &data);
+void draw_header(const StockData &data, const char *clock);
 void draw_footer(const StockData &data);
-void draw_graph_and_labels(const StockData &data);
+void draw_graph_and_labels(const StockData &data, const ChartView &view);
+void build_chart_layout(const StockData &data, const ChartView &view,
+                        ChartLayout &layout);
+void draw_chart_layout(const ChartLayout &layout);
+void draw_diagnostics();
 float map_value(float value, float from_low, float from_high, float to_low,
                 float to_high);
 float get_nice_step(float range);
@@ -60,10 +80,13 @@ float get_nice_step(float range);
 // --- Function Prototypes ---
 void initialize_display();
 void set_backlight(uint8_t brightness);
-void update_display(const StockData &data);
+void update_display(const StockData &data, const ChartView &view);
+void clamp_chart_view(const StockData &data, ChartView &view);
 void initialize_stock_data(StockData &data);
 void update_stock_data(StockData &data, const char *symbol, float current_price,
                        float price_change, float percent_change);
+void clear_candles(StockData &data);
+void append_candle(StockData &data, const Candle &candle);
 
 // Helper function to format RTC time to 12-hour format
 void format_rtc_time_to_12h(const datetime_t &t, char *output,
@@ -85,11 +108,13 @@ void initialize_display() {
 	TEXT_GREEN = graphics.create_pen(0, 200, 80);
 	LINE_WHITE = graphics.create_pen(220, 220, 230);
 	FOOTER_BG = graphics.create_pen(10, 36, 70);
+	BAND_BLUE = graphics.create_pen(60, 110, 170);
+	EMA_ORANGE = graphics.create_pen(240, 160, 40);
 }
 
 void set_backlight(uint8_t brightness) { st7789.set_backlight(brightness); }
 
-void update_display(StockData &data) {
+void update_display(const StockData &data, const ChartView &view) {
 	// Clear screen with the main background color
 	graphics.set_pen(BG_DARK_BLUE);
 	graphics.clear();
@@ -97,19 +122,27 @@ void update_display(StockData &data) {
 	// Get current time from RTC
 	datetime_t now;
 	rtc_get_datetime(&now);
-	char timestamp[50];
-	format_rtc_time_to_12h(now, timestamp, sizeof(timestamp));
-	strcpy(data.timestamp, timestamp);
+	char clock[16];
+	format_rtc_time_to_12h(now, clock, sizeof(clock));
 
 	// Draw all UI components
-	display_internal::draw_header(data);
-	display_internal::draw_graph_and_labels(data);
+	display_internal::draw_header(data, clock);
+	display_internal::draw_graph_and_labels(data, view);
 	display_internal::draw_footer(data);
 
 	// Push the completed frame to the screen
 	st7789.update(&graphics);
 }
 
+void update_diagnostics_display() {
+	graphics.set_pen(BG_DARK_BLUE);
+	graphics.clear();
+
+	display_internal::draw_diagnostics();
+
+	st7789.update(&graphics);
+}
+
 void initialize_stock_data(StockData &data) {
 	snprintf(data.symbol, sizeof(data.symbol), "NVDA");
 	snprintf(data.duration, sizeof(data.duration), "1h");
@@ -118,12 +151,8 @@ void initialize_stock_data(StockData &data) {
 	datetime_t t;
 	rtc_get_datetime(&t);
 
-	char timestamp[50];
-	format_rtc_time_to_12h(t, timestamp, sizeof(timestamp));
-	strcpy(data.timestamp, timestamp);
-
 	// Generate random price history data
-	data.history_len = 30;
+	clear_candles(data);
 
 	// Create a more sophisticated random seed using multiple sources
 	uint32_t seed = t.sec + t.min + t.hour + t.day + t.month + t.year;
@@ -133,16 +162,19 @@ void initialize_stock_data(StockData &data) {
 	srand(seed); // Seed random number generator with combined entropy
 	float base_price =
 	    850.0f + (rand() % 100); // Random base price between 850-950
+
 	float trend = (rand() % 2) ? 1.0f : -1.0f; // Random up or down trend
 
 	// Generate first period's data
 	float current_price = base_price;
 	float volatility = (rand() % 5) + 1; // Random volatility between 1-5
-	data.history[0].open = current_price;
-	data.history[0].high = current_price + (rand() % (int)volatility);
-	data.history[0].low = current_price - (rand() % (int)volatility);
-	data.history[0].close =
+	Candle candle = {};
+	candle.open = current_price;
+	candle.high = current_price + (rand() % (int)volatility);
+	candle.low = current_price - (rand() % (int)volatility);
+	candle.close =
 	    current_price + ((rand() % 10) - 5); // Random close price near the open
+	append_candle(data, candle);
 
 	// Generate subsequent periods
 	for (int i = 1; i < 30; ++i) {
@@ -152,37 +184,29 @@ void initialize_stock_data(StockData &data) {
 		    trend * (i / 10.0f); // Gradually increasing trend effect
 
 		// Use previous close as current open
-		current_price = data.history[i - 1].close;
+		current_price = candle.close;
 		volatility = (rand() % 5) + 1; // Random volatility between 1-5
 
-		data.history[i].open = current_price;
-		data.history[i].high = current_price + (rand() % (int)volatility);
-		data.history[i].low = current_price - (rand() % (int)volatility);
-		data.history[i].close =
+		candle.open = current_price;
+		candle.high = current_price + (rand() % (int)volatility);
+		candle.low = current_price - (rand() % (int)volatility);
+		candle.close =
 		    current_price +
 		    ((rand() % 10) - 5); // Random close price near the open
+		append_candle(data, candle);
 	}
 
 	// Set initial values from first OHLC data point
-	data.open_price = data.history[0].open;
-	data.high_price = data.history[0].high;
-	data.low_price = data.history[0].low;
-
-	// Find high and low prices from history
-	for (int i = 1; i < data.history_len; i++) {
-		if (data.history[i].high > data.high_price) {
-			data.high_price = data.history[i].high;
-		}
-		if (data.history[i].low < data.low_price) {
-			data.low_price = data.history[i].low;
-		}
-	}
+	data.open_price = data.history.front().open;
+
+	// High and low prices over the history
+	data.high_price = data.history.max_high();
+	data.low_price = data.history.min_low();
 
 	// Calculate price change and percent change using the last close price
-	data.price_change =
-	    data.current_price - data.history[data.history_len - 1].close;
-	data.percent_change =
-	    (data.price_change / data.history[data.history_len - 1].close) * 100.0f;
+	float last_close = data.history.back().close;
+	data.price_change = data.current_price - last_close;
+	data.percent_change = (data.price_change / last_close) * 100.0f;
 }
 
 void update_stock_data(StockData &data, const char *symbol, float current_price,
@@ -193,12 +217,55 @@ void update_stock_data(StockData &data, const char *symbol, float current_price,
 	data.percent_change = percent_change;
 }
 
+void clear_candles(StockData &data) {
+	data.history.clear();
+	data.revision = next_revision++;
+}
+
+void append_candle(StockData &data, const Candle &candle) {
+	data.history.append(candle);
+	data.revision = next_revision++;
+}
+
+// The chart's series for data, built once per revision. The indicators are
+// fed with it so they stay in step with it.
+static const StockHistory &chart_series(const StockData &data) {
+	if (chart_history_revision != data.revision) {
+		chart_history.clear(data.history.oldest_sequence());
+		chart_indicators.clear();
+		for (size_t i = 0; i < data.history.size(); i++) {
+			chart_history.append(data.history.at(i));
+			chart_indicators.append(data.history.at(i));
+		}
+		chart_history_revision = data.revision;
+	}
+	return chart_history;
+}
+
+// The lowest pyramid level whose buckets all fit on the chart
+static int fit_level(const StockHistory &history) {
+	int level = 0;
+	while (history.level_size(level) > CHART_MAX_CANDLES) {
+		level++;
+	}
+	return level;
+}
+
+void clamp_chart_view(const StockData &data, ChartView &view) {
+	const StockHistory &history = chart_series(data);
+	int fit = fit_level(history);
+	view.zoom = std::clamp(view.zoom, 0, fit);
+	int buckets = history.level_size(fit - view.zoom);
+	int max_pan = std::max(buckets - CHART_MAX_CANDLES, 0);
+	view.pan = std::clamp(view.pan, 0, max_pan);
+}
+
 namespace display_internal {
-void draw_header(const StockData &data) {
+void draw_header(const StockData &data, const char *clock) {
 	graphics.set_pen(TEXT_WHITE);
 
-	// Convert and display timestamp in 12-hour format
-	graphics.text(data.timestamp, Point(5, 10), 200, 2);
+	// Display the RTC time in 12-hour format
+	graphics.text(clock, Point(5, 10), 200, 2);
 
 	// Calculate exact text width using the graphics library
 	int symbol_width = graphics.measure_text(data.symbol, 3.0f);
@@ -296,17 +363,65 @@ void draw_footer(const StockData &data) {
 	              Point(right_x + arrow_width + 4, GRAPH_BOTTOM + 8), 100, 2);
 }
 
-void draw_graph_and_labels(const StockData &data) {
-	if (data.history_len == 0)
+// A coordinate as stored in a layout. Values a degenerate scale gives, such
+// as the NaNs of a flat series, land far off the panel.
+static int16_t to_pixel(float value) {
+	if (!(value > ChartLayout::NO_POINT)) {
+		return ChartLayout::NO_POINT + 1;
+	}
+	return value < INT16_MAX ? (int16_t)value : INT16_MAX;
+}
+
+// One indicator line across the candles from first on, in the chart's price
+// scale, clipped to the graph. NO_POINT where it has no value yet.
+static void layout_indicator(const StockData &data, int line, size_t first,
+                             float min_price, float max_price,
+                             ChartLayout &layout, int16_t *ys) {
+	const StockHistory &history = chart_series(data);
+	const StockIndicators &indicators = chart_indicators;
+	// Indicator index of history index first
+	size_t offset = first - (history.size() - indicators.size());
+
+	for (int i = 0; i < layout.count; ++i) {
+		float value =
+		    indicators.value((StockIndicators::Line)line, offset + i);
+		if (std::isnan(value)) {
+			ys[i] = ChartLayout::NO_POINT;
+			continue;
+		}
+		float y = map_value(value, min_price, max_price, GRAPH_BOTTOM,
+		                    GRAPH_TOP);
+		ys[i] = to_pixel(
+		    std::clamp(y, (float)GRAPH_TOP, (float)GRAPH_BOTTOM - 1));
+	}
+}
+
+void build_chart_layout(const StockData &data, const ChartView &view,
+                        ChartLayout &layout) {
+	const StockHistory &history = chart_series(data);
+	layout.revision = data.revision;
+	layout.zoom = view.zoom;
+	layout.pan = view.pan;
+	layout.count = 0;
+	layout.label_count = 0;
+	layout.overlays = false;
+	if (history.empty())
 		return;
 
-	float min_price = data.history[0].low;
-	float max_price = data.history[0].high;
-	for (int i = 1; i < data.history_len; ++i) {
-		if (data.history[i].low < min_price)
-			min_price = data.history[i].low;
-		if (data.history[i].high > max_price)
-			max_price = data.history[i].high;
+	// Read the view's buckets straight from the pyramid, so any zoom costs
+	// the same
+	int level = fit_level(history) - view.zoom;
+	int buckets = history.level_size(level);
+	int count = std::min(buckets, CHART_MAX_CANDLES);
+	int first = buckets - count - view.pan;
+	layout.count = count;
+
+	float min_price = history.bucket(level, first).low;
+	float max_price = history.bucket(level, first).high;
+	for (int i = 1; i < count; ++i) {
+		const Candle candle = history.bucket(level, first + i);
+		min_price = std::min(min_price, candle.low);
+		max_price = std::max(max_price, candle.high);
 	}
 	float price_range = max_price - min_price;
 
@@ -317,69 +432,177 @@ void draw_graph_and_labels(const StockData &data) {
 	if (price_range == 0)
 		price_range = 1; // Avoid division by zero
 
-	// Draw Y-Axis Labels
-	graphics.set_pen(TEXT_WHITE);
+	// Y-Axis Labels
 	float step = get_nice_step(price_range);
 	float first_label = floor(min_price / step) * step;
 
 	for (float val = first_label; val <= max_price; val += step) {
 		if (val < min_price)
 			continue;
-		int y = map_value(val, min_price, max_price, GRAPH_BOTTOM, GRAPH_TOP);
+		int y = to_pixel(
+		    map_value(val, min_price, max_price, GRAPH_BOTTOM, GRAPH_TOP));
 
 		// Skip labels that would overlap with the header area
 		// Add 20 pixels buffer from the top to account for text height
 		if (y < GRAPH_TOP + 20)
 			continue;
 
-		if (y < GRAPH_BOTTOM) {
-			char label_str[10];
-			snprintf(label_str, 10, "%d", (int)roundf(val));
-			graphics.text(label_str, Point(Y_LABELS_X, y - 8), 50, 2);
+		if (y < GRAPH_BOTTOM && layout.label_count < ChartLayout::MAX_LABELS) {
+			int n = layout.label_count++;
+			layout.label_y[n] = y;
+			snprintf(layout.labels[n], sizeof(layout.labels[n]), "%d",
+			         (int)roundf(val));
 		}
 	}
 
 	// Calculate candlestick width and spacing
-	float raw_width =
-	    (GRAPH_RIGHT - GRAPH_LEFT) / (float)data.history_len * 0.8f;
+	float raw_width = (GRAPH_RIGHT - GRAPH_LEFT) / (float)count * 0.8f;
 	int candle_width = (int)raw_width;
 	if (candle_width % 2 == 0) {
 		candle_width--; // Make it odd
 	}
-	float candle_spacing =
-	    (GRAPH_RIGHT - GRAPH_LEFT) / (float)data.history_len * 0.2f;
+	layout.candle_width = candle_width;
 
-	// Draw Candlesticks
-	for (int i = 0; i < data.history_len; ++i) {
-		float x =
-		    map_value(i, 0, data.history_len - 1, GRAPH_LEFT, GRAPH_RIGHT);
+	// Candlesticks
+	for (int i = 0; i < count; ++i) {
+		const Candle candle = history.bucket(level, first + i);
+		float x = map_value(i, 0, count - 1, GRAPH_LEFT, GRAPH_RIGHT);
 
 		// Calculate y positions for OHLC
-		int open_y = map_value(data.history[i].open, min_price, max_price,
-		                       GRAPH_BOTTOM, GRAPH_TOP);
-		int close_y = map_value(data.history[i].close, min_price, max_price,
-		                        GRAPH_BOTTOM, GRAPH_TOP);
-		int high_y = map_value(data.history[i].high, min_price, max_price,
-		                       GRAPH_BOTTOM, GRAPH_TOP);
-		int low_y = map_value(data.history[i].low, min_price, max_price,
-		                      GRAPH_BOTTOM, GRAPH_TOP);
-
-		// Draw the wick (high-low line)
-		graphics.set_pen(LINE_WHITE);
-		graphics.line(Point(x, high_y), Point(x, low_y));
+		int open_y = to_pixel(map_value(candle.open, min_price, max_price,
+		                                GRAPH_BOTTOM, GRAPH_TOP));
+		int close_y = to_pixel(map_value(candle.close, min_price, max_price,
+		                                 GRAPH_BOTTOM, GRAPH_TOP));
+		int high_y = to_pixel(map_value(candle.high, min_price, max_price,
+		                                GRAPH_BOTTOM, GRAPH_TOP));
+		int low_y = to_pixel(map_value(candle.low, min_price, max_price,
+		                               GRAPH_BOTTOM, GRAPH_TOP));
 
-		// Draw the body
-		bool is_bullish = data.history[i].close >= data.history[i].open;
-		graphics.set_pen(is_bullish ? TEXT_GREEN : TEXT_WHITE);
-
-		// Draw filled rectangle for the body
-		int body_top = std::min(open_y, close_y);
 		int body_height = std::abs(close_y - open_y);
 		if (body_height == 0)
 			body_height = 1; // Ensure at least 1px height for doji
 
-		graphics.rectangle(
-		    Rect(x - candle_width / 2, body_top, candle_width, body_height));
+		layout.x[i] = to_pixel(x);
+		layout.high_y[i] = high_y;
+		layout.low_y[i] = low_y;
+		layout.body_x[i] = to_pixel(x - candle_width / 2);
+		layout.body_top[i] = std::min(open_y, close_y);
+		layout.body_height[i] = body_height;
+		layout.bullish[i] = candle.close >= candle.open;
+	}
+
+	// The indicators are per candle and only kept for the latest ones, so
+	// they are left out of other views
+	layout.overlays =
+	    level == 0 && first + chart_indicators.size() >= history.size();
+	if (layout.overlays) {
+		layout_indicator(data, StockIndicators::LINE_BOLLINGER_UPPER, first,
+		                 min_price, max_price, layout,
+		                 layout.line_y[ChartLayout::BAND_UPPER]);
+		layout_indicator(data, StockIndicators::LINE_BOLLINGER_LOWER, first,
+		                 min_price, max_price, layout,
+		                 layout.line_y[ChartLayout::BAND_LOWER]);
+		layout_indicator(data, StockIndicators::LINE_EMA, first, min_price,
+		                 max_price, layout, layout.line_y[ChartLayout::EMA]);
+	}
+}
+
+// Segments join neighbouring points and stop at a gap
+static void draw_layout_line(const ChartLayout &layout, int line, Pen pen) {
+	const int16_t *ys = layout.line_y[line];
+	graphics.set_pen(pen);
+	for (int i = 1; i < layout.count; ++i) {
+		if (ys[i - 1] != ChartLayout::NO_POINT &&
+		    ys[i] != ChartLayout::NO_POINT) {
+			graphics.line(Point(layout.x[i - 1], ys[i - 1]),
+			              Point(layout.x[i], ys[i]));
+		}
+	}
+}
+
+void draw_chart_layout(const ChartLayout &layout) {
+	graphics.set_pen(TEXT_WHITE);
+	for (int i = 0; i < layout.label_count; ++i) {
+		Point at(Y_LABELS_X, layout.label_y[i] - 8);
+		graphics.text(layout.labels[i], at, 50, 2);
+	}
+
+	// Bollinger bands behind the candles
+	if (layout.overlays) {
+		draw_layout_line(layout, ChartLayout::BAND_UPPER, BAND_BLUE);
+		draw_layout_line(layout, ChartLayout::BAND_LOWER, BAND_BLUE);
+	}
+
+	for (int i = 0; i < layout.count; ++i) {
+		// The wick (high-low line)
+		graphics.set_pen(LINE_WHITE);
+		graphics.line(Point(layout.x[i], layout.high_y[i]),
+		              Point(layout.x[i], layout.low_y[i]));
+
+		// The body
+		graphics.set_pen(layout.bullish[i] ? TEXT_GREEN : TEXT_WHITE);
+		graphics.rectangle(Rect(layout.body_x[i], layout.body_top[i],
+		                        layout.candle_width, layout.body_height[i]));
+	}
+
+	// The EMA on top
+	if (layout.overlays) {
+		draw_layout_line(layout, ChartLayout::EMA, EMA_ORANGE);
+	}
+}
+
+// The geometry is only worked out again when the data or the view changes;
+// every other frame, such as a clock tick, just draws it
+void draw_graph_and_labels(const StockData &data, const ChartView &view) {
+	if (data.history.empty())
+		return;
+
+	ChartView clamped = view;
+	clamp_chart_view(data, clamped);
+	if (!chart_layout_valid || chart_layout.revision != data.revision ||
+	    chart_layout.zoom != clamped.zoom || chart_layout.pan != clamped.pan) {
+		build_chart_layout(data, clamped, chart_layout);
+		chart_layout_valid = true;
+	}
+	draw_chart_layout(chart_layout);
+}
+
+void draw_diagnostics() {
+	graphics.set_pen(TEXT_WHITE);
+	graphics.text("NETWORK (ms)  n   p50   p95   max", Point(5, 5), 320, 1);
+
+	// One row per latency histogram
+	int y = 20;
+	for (int m = 0; m < NET_METRIC_COUNT; ++m) {
+		NetHistogram hist;
+		net_stats_get((NetMetric)m, &hist);
+
+		char row[64];
+		snprintf(row, sizeof(row), "%-13s %4lu %5lu %5lu %5lu",
+		         net_stats_metric_name((NetMetric)m),
+		         (unsigned long)hist.count,
+		         (unsigned long)(net_stats_percentile_us(&hist, 50) / 1000),
+		         (unsigned long)(net_stats_percentile_us(&hist, 95) / 1000),
+		         (unsigned long)(hist.max_us / 1000));
+		graphics.text(row, Point(5, y), 320, 1);
+		y += 14;
+	}
+
+	// Counters underneath, two per row
+	y += 6;
+	graphics.set_pen(TEXT_GREEN);
+	for (int c = 0; c < NET_COUNTER_COUNT; c += 2) {
+		char row[64];
+		int len = snprintf(row, sizeof(row), "%-10s %-8lu",
+		                   net_stats_counter_name((NetCounter)c),
+		                   (unsigned long)net_stats_counter((NetCounter)c));
+		if (c + 1 < NET_COUNTER_COUNT) {
+			snprintf(row + len, sizeof(row) - len, " %-10s %lu",
+			         net_stats_counter_name((NetCounter)(c + 1)),
+			         (unsigned long)net_stats_counter((NetCounter)(c + 1)));
+		}
+		graphics.text(row, Point(5, y), 320, 1);
+		y += 14;
 	}
 }
 
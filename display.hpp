@@ -1,54 +1,124 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 // Pimoroni Libraries for Pico Display Pack 2.0
 #include "button.hpp"
 #include "drivers/st7789/st7789.hpp"
+#include "indicators.hpp"
 #include "libraries/pico_display_2/pico_display_2.hpp"
 #include "libraries/pico_graphics/pico_graphics.hpp"
 #include "pico/stdlib.h"
 #include "rgbled.hpp"
+#include "time_series.hpp"
 
 using namespace pimoroni;
 
-// Stock data structure
-struct OHLC {
-	float open;
-	float high;
-	float low;
-	float close;
-};
+// Candles kept per symbol, enough for a day of 2 minute bars
+#ifndef STOCK_HISTORY_CAPACITY
+#define STOCK_HISTORY_CAPACITY 256
+#endif
+
+// The most candles the chart draws. A longer series is shown merged down to
+// at most this many, from its pyramid level with few enough buckets.
+#define CHART_MAX_CANDLES 60
+
+// Buckets a pan button moves the chart by
+#define CHART_PAN_STEP (CHART_MAX_CANDLES / 4)
 
+// Indicator values are kept for the candles the chart can show
+#define CHART_INDICATOR_CAPACITY 64
+static_assert(CHART_INDICATOR_CAPACITY >= CHART_MAX_CANDLES,
+              "Indicators must cover every candle drawn");
+
+// A symbol's candles as fetched and handed to the display, and the series
+// the chart is drawn from. Only the render loop keeps a StockHistory, with
+// its pyramid, extremes and indicators, so the StockData triple buffer holds
+// plain candles.
+using StockCandles = CandleRing<STOCK_HISTORY_CAPACITY>;
+using StockHistory = TimeSeries<STOCK_HISTORY_CAPACITY>;
+using StockIndicators = IndicatorSeries<CHART_INDICATOR_CAPACITY>;
+
+// Stock data structure
 struct StockData {
 	char symbol[8];
 	char duration[8];
-	char timestamp[50];
 	float current_price;
 	float open_price;
 	float high_price;
 	float low_price;
 	float price_change;
 	float percent_change;
-	OHLC history[30];
-	int history_len;
+	StockCandles history;
+	// Renewed whenever the candles change, so what is drawn from them can be
+	// kept until then. 0 for a series that was never filled.
+	uint32_t revision = 0;
+};
+
+// The part of the history the chart shows. zoom counts pyramid levels in
+// from the level that fits the whole series, and pan counts buckets back
+// from the newest. Both are clamped to the data by clamp_chart_view().
+struct ChartView {
+	int zoom = 0;
+	int pan = 0;
+};
+
+// Pixel geometry of the chart for one data revision and view: Y-axis labels,
+// candle coordinates and indicator lines, worked out once in floating point
+// and then drawn frame after frame with integer coordinates only
+struct ChartLayout {
+	static constexpr int MAX_LABELS = 16;
+	static constexpr int16_t NO_POINT = INT16_MIN; // Indicator has no value
+	enum Line { BAND_UPPER, BAND_LOWER, EMA, LINES };
+
+	// What the layout was built from, the view clamped
+	uint32_t revision;
+	int zoom;
+	int pan;
+
+	int label_count;
+	int16_t label_y[MAX_LABELS];
+	char labels[MAX_LABELS][10];
+
+	int count;
+	int16_t candle_width;
+	int16_t x[CHART_MAX_CANDLES];
+	int16_t high_y[CHART_MAX_CANDLES];
+	int16_t low_y[CHART_MAX_CANDLES];
+	int16_t body_x[CHART_MAX_CANDLES];
+	int16_t body_top[CHART_MAX_CANDLES];
+	int16_t body_height[CHART_MAX_CANDLES];
+	bool bullish[CHART_MAX_CANDLES];
+
+	bool overlays; // Whether the indicator lines are drawn
+	int16_t line_y[LINES][CHART_MAX_CANDLES];
 };
 
 // Display initialization and control functions
 void initialize_display();
-void update_display(StockData &data);
+void update_display(const StockData &data,
+                    const ChartView &view = ChartView());
+void update_diagnostics_display();
+void clamp_chart_view(const StockData &data, ChartView &view);
 void set_backlight(uint8_t brightness);
 
 // Data management functions
 void initialize_stock_data(StockData &data);
 void update_stock_data(StockData &data, const char *symbol, float current_price,
                        float price_change, float percent_change);
+void clear_candles(StockData &data);
+void append_candle(StockData &data, const Candle &candle);
 
 // Internal helper functions
 namespace display_internal {
-void draw_header(const StockData &data);
+void draw_header(const StockData &data, const char *clock);
 void draw_footer(const StockData &data);
-void draw_graph_and_labels(const StockData &data);
+void draw_graph_and_labels(const StockData &data, const ChartView &view);
+void build_chart_layout(const StockData &data, const ChartView &view,
+                        ChartLayout &layout);
+void draw_chart_layout(const ChartLayout &layout);
+void draw_diagnostics();
 float map_value(float value, float from_low, float from_high, float to_low,
                 float to_high);
 float get_nice_step(float range);
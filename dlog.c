@@ -0,0 +1,196 @@
+#include "dlog.h"
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "pico/stdlib.h"
+#include "task.h"
+
+#define DLOG_TASK_PRIORITY (tskIDLE_PRIORITY + 1UL)
+#define DLOG_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+#define DLOG_RING_MASK (DLOG_RING_SIZE - 1)
+#define DLOG_LINE_MAX 160
+
+// seq tells whose turn a slot is. For the lap starting at position base
+// (a multiple of DLOG_RING_SIZE) it is base while the slot is free and
+// base + 1 once the record in it is complete. Zero-initialised slots are
+// therefore free for the first lap.
+typedef struct {
+	atomic_uint seq;
+	uint32_t time_us;
+	const char *fmt;
+	uint8_t level;
+	uint8_t nargs;
+	uintptr_t args[DLOG_MAX_ARGS];
+} DlogSlot;
+
+static DlogSlot ring[DLOG_RING_SIZE];
+static atomic_uint write_pos;
+static uint32_t read_pos; // Only touched by the draining task
+static atomic_uint dropped;
+static atomic_flag draining = ATOMIC_FLAG_INIT;
+
+void dlog_write(uint8_t level, const char *fmt, uint32_t nargs, ...) {
+	// Claim a slot
+	DlogSlot *slot;
+	unsigned int pos = atomic_load_explicit(&write_pos, memory_order_relaxed);
+	while (true) {
+		slot = &ring[pos & DLOG_RING_MASK];
+		unsigned int seq =
+		    atomic_load_explicit(&slot->seq, memory_order_acquire);
+		int diff = (int)(seq - (pos & ~DLOG_RING_MASK));
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(
+			        &write_pos, &pos, pos + 1, memory_order_relaxed,
+			        memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			// The drain task hasn't caught up with this lap yet
+			atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+			return;
+		} else {
+			pos = atomic_load_explicit(&write_pos, memory_order_relaxed);
+		}
+	}
+
+	slot->time_us = time_us_32();
+	slot->fmt = fmt;
+	slot->level = level;
+	slot->nargs = nargs < DLOG_MAX_ARGS ? nargs : DLOG_MAX_ARGS;
+	va_list ap;
+	va_start(ap, nargs);
+	for (uint32_t i = 0; i < slot->nargs; i++) {
+		slot->args[i] = va_arg(ap, uintptr_t);
+	}
+	va_end(ap);
+
+	// Hand the slot to the drain task
+	atomic_store_explicit(&slot->seq, (pos & ~DLOG_RING_MASK) + 1,
+	                      memory_order_release);
+}
+
+// Format one record, one conversion at a time so each argument is passed
+// with the type its conversion expects
+static void format_record(const DlogSlot *slot, char *line, size_t size) {
+	static const char level_chars[] = "-EWID";
+	int len = snprintf(line, size, "%c %lu.%03lu ",
+	                   level_chars[slot->level <= DLOG_LEVEL_DEBUG ? slot->level
+	                                                               : 0],
+	                   (unsigned long)(slot->time_us / 1000000),
+	                   (unsigned long)(slot->time_us / 1000 % 1000));
+	uint32_t arg = 0;
+
+	for (const char *p = slot->fmt; *p && len < (int)size - 1; p++) {
+		if (*p != '%') {
+			line[len++] = *p;
+			continue;
+		}
+		if (p[1] == '%') {
+			line[len++] = '%';
+			p++;
+			continue;
+		}
+
+		// Copy the conversion spec, dropping length modifiers since every
+		// integer was stored as 32 bits
+		char spec[16];
+		size_t spec_len = 0;
+		spec[spec_len++] = *p++;
+		while (*p && !strchr("diuxXocspfFeEgG", *p) &&
+		       spec_len < sizeof(spec) - 2) {
+			if (!strchr("hlzjt", *p))
+				spec[spec_len++] = *p;
+			p++;
+		}
+		if (!*p)
+			break;
+		char conv = *p;
+		spec[spec_len++] = conv;
+		spec[spec_len] = '\0';
+
+		uintptr_t value = arg < slot->nargs ? slot->args[arg++] : 0;
+		int written;
+		if (strchr("fFeEgG", conv)) {
+			uint32_t bits = (uint32_t)value;
+			float f;
+			memcpy(&f, &bits, sizeof(f));
+			written = snprintf(line + len, size - len, spec, (double)f);
+		} else if (conv == 's') {
+			const char *str = (const char *)(uintptr_t)value;
+			written = snprintf(line + len, size - len, spec, str ? str : "(null)");
+		} else if (conv == 'p') {
+			written = snprintf(line + len, size - len, spec,
+			                   (void *)(uintptr_t)value);
+		} else if (strchr("di", conv)) {
+			written = snprintf(line + len, size - len, spec, (int)value);
+		} else {
+			written = snprintf(line + len, size - len, spec, (unsigned)value);
+		}
+		if (written > 0)
+			len += written;
+		if (len > (int)size - 1)
+			len = size - 1;
+	}
+	line[len] = '\0';
+}
+
+void dlog_flush(void) {
+	// Only one task may consume at a time
+	if (atomic_flag_test_and_set(&draining))
+		return;
+
+	char line[DLOG_LINE_MAX];
+	while (true) {
+		DlogSlot *slot = &ring[read_pos & DLOG_RING_MASK];
+		unsigned int seq =
+		    atomic_load_explicit(&slot->seq, memory_order_acquire);
+		uint32_t base = read_pos & ~DLOG_RING_MASK;
+		if (seq != base + 1)
+			break;
+
+		format_record(slot, line, sizeof(line));
+		// Free the slot for the writer one lap ahead
+		atomic_store_explicit(&slot->seq, base + DLOG_RING_SIZE,
+		                      memory_order_release);
+		read_pos++;
+		fputs(line, stdout);
+	}
+
+	static uint32_t reported_drops = 0;
+	uint32_t drops = atomic_load_explicit(&dropped, memory_order_relaxed);
+	if (drops != reported_drops) {
+		printf("dlog: %lu records dropped\n",
+		       (unsigned long)(drops - reported_drops));
+		reported_drops = drops;
+	}
+
+	atomic_flag_clear(&draining);
+}
+
+uint32_t dlog_dropped(void) {
+	return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
+
+static void dlog_task(__unused void *params) {
+	while (true) {
+		dlog_flush();
+		vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_PERIOD_MS));
+	}
+}
+
+void dlog_init(void) {
+#if STATIC_ALLOCATION
+	static StackType_t stack[DLOG_TASK_STACK_SIZE];
+	static StaticTask_t tcb;
+	xTaskCreateStatic(dlog_task, "LogThread", DLOG_TASK_STACK_SIZE, NULL,
+	                  DLOG_TASK_PRIORITY, stack, &tcb);
+#else
+	if (xTaskCreate(dlog_task, "LogThread", DLOG_TASK_STACK_SIZE, NULL,
+	                DLOG_TASK_PRIORITY, NULL) != pdPASS) {
+		printf("Failed to create log task\n");
+	}
+#endif
+}
@@ -0,0 +1,152 @@
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Deferred logging. DLOG_INFO("x=%d", x) stores the format string pointer and
+// up to DLOG_MAX_ARGS pointer-sized arguments in a ring buffer; a low
+// priority task formats and prints them later. Because only pointers are
+// stored, format strings and %s arguments must point at storage that outlives
+// the record, such as string literals. Supported conversions are the 32-bit
+// integer ones (d, i, u, x, X, o, c), s and p, and f/e/g for float
+// arguments.
+
+#define DLOG_LEVEL_NONE 0
+#define DLOG_LEVEL_ERROR 1
+#define DLOG_LEVEL_WARN 2
+#define DLOG_LEVEL_INFO 3
+#define DLOG_LEVEL_DEBUG 4
+
+// Records above this level compile to nothing
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+#endif
+
+// Number of records the ring holds, must be a power of two
+#define DLOG_RING_SIZE 128
+#define DLOG_MAX_ARGS 6
+
+// How often the drain task wakes to print pending records
+#define DLOG_DRAIN_PERIOD_MS 50
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start the drain task. Records written before this are kept and printed
+ * once it runs.
+ */
+void dlog_init(void);
+
+/**
+ * Append a record. Use the DLOG_* macros rather than calling this directly.
+ * Safe from any task on either core and from interrupts. Never blocks; if
+ * the ring is full the record is dropped and counted.
+ * @param level One of DLOG_LEVEL_*
+ * @param fmt printf style format string with static storage duration
+ * @param nargs Number of uintptr_t arguments that follow
+ */
+void dlog_write(uint8_t level, const char *fmt, uint32_t nargs, ...);
+
+/**
+ * Print everything pending in the ring now, from the calling task
+ */
+void dlog_flush(void);
+
+/**
+ * @return Records dropped because the ring was full
+ */
+uint32_t dlog_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Each argument is stored in a pointer-sized word: 32 bits on the RP2040,
+// but wide enough on a 64-bit host for the pointers behind %s and %p.
+// Integers are cut to 32 bits and floats keep their bit pattern, so the
+// drain task can turn them back into floats.
+#ifdef __cplusplus
+#include <type_traits>
+
+template <typename T> static inline uintptr_t dlog_arg(T value) {
+	if constexpr (std::is_floating_point_v<T>) {
+		float f = (float)value;
+		uint32_t bits;
+		memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	} else if constexpr (std::is_pointer_v<T>) {
+		return (uintptr_t)value;
+	} else {
+		return (uint32_t)value;
+	}
+}
+#define DLOG_ARG(x) dlog_arg(x)
+#else
+static inline uintptr_t dlog_float_arg(double value) {
+	float f = (float)value;
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+static inline uintptr_t dlog_pointer_arg(const void *value) {
+	return (uintptr_t)value;
+}
+static inline uintptr_t dlog_int_arg(uint32_t value) { return value; }
+
+// Other pointer types need a cast to void * first
+#define DLOG_ARG(x)                                                            \
+	_Generic((x),                                                              \
+	    float: dlog_float_arg,                                                 \
+	    double: dlog_float_arg,                                                \
+	    char *: dlog_pointer_arg,                                              \
+	    const char *: dlog_pointer_arg,                                        \
+	    void *: dlog_pointer_arg,                                              \
+	    const void *: dlog_pointer_arg,                                        \
+	    default: dlog_int_arg)(x)
+#endif
+
+// Argument counting and per-argument conversion, up to DLOG_MAX_ARGS
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+#define DLOG_NARGS(...) DLOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_CAT_(a, b) a##b
+#define DLOG_CAT(a, b) DLOG_CAT_(a, b)
+#define DLOG_MAP0()
+#define DLOG_MAP1(a) , DLOG_ARG(a)
+#define DLOG_MAP2(a, b) DLOG_MAP1(a), DLOG_ARG(b)
+#define DLOG_MAP3(a, b, c) DLOG_MAP2(a, b), DLOG_ARG(c)
+#define DLOG_MAP4(a, b, c, d) DLOG_MAP3(a, b, c), DLOG_ARG(d)
+#define DLOG_MAP5(a, b, c, d, e) DLOG_MAP4(a, b, c, d), DLOG_ARG(e)
+#define DLOG_MAP6(a, b, c, d, e, f) DLOG_MAP5(a, b, c, d, e), DLOG_ARG(f)
+#define DLOG_MAP(...) DLOG_CAT(DLOG_MAP, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+#define DLOG_AT(level, fmt, ...)                                               \
+	dlog_write((level), (fmt), DLOG_NARGS(__VA_ARGS__) DLOG_MAP(__VA_ARGS__))
+
+#if DLOG_LEVEL >= DLOG_LEVEL_ERROR
+#define DLOG_ERROR(fmt, ...) DLOG_AT(DLOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_ERROR(fmt, ...) ((void)0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_WARN
+#define DLOG_WARN(fmt, ...) DLOG_AT(DLOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_WARN(fmt, ...) ((void)0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_INFO
+#define DLOG_INFO(fmt, ...) DLOG_AT(DLOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_INFO(fmt, ...) ((void)0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_DEBUG
+#define DLOG_DEBUG(fmt, ...) DLOG_AT(DLOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_DEBUG(fmt, ...) ((void)0)
+#endif
+
+#endif // DLOG_H
@@ -21,6 +21,9 @@ namespace pimoroni {
     };
     bool raw();
     bool read();
+    uint get_pin() const { return pin; }
+    uint32_t get_repeat_time() const { return repeat_time; }
+    uint32_t get_hold_time() const { return hold_time; }
   private:
     uint pin;
     Polarity polarity;
@@ -0,0 +1,381 @@
+#include "flash_cache.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "pico/stdlib.h"
+
+#include "display.hpp"
+#include "watchlist.hpp"
+
+#define FLASH_CACHE_MAGIC 0x32434b54u // "TKC2"
+#define FLASH_CACHE_SIZE (FLASH_CACHE_SECTORS * FLASH_SECTOR_SIZE)
+#define FLASH_CACHE_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_CACHE_SIZE)
+#define FLASH_CACHE_CANDLES WATCHLIST_SERIES_CAPACITY
+
+// One symbol's series. Records start on a page and are padded to whole
+// pages, the unit flash is programmed in, and never cross a sector.
+struct CacheRecord {
+	uint32_t magic;
+	uint32_t sequence; // One more than the record written before
+	uint32_t crc;      // CRC-32 of all but itself, up to the last candle held
+	char symbol[8];
+	char duration[8];
+	float open_price;
+	float high_price;
+	float low_price;
+	float current_price;
+	float price_change;
+	float percent_change;
+	uint16_t count;
+	uint16_t reserved;
+	Candle candles[FLASH_CACHE_CANDLES];
+};
+
+static constexpr size_t record_size(size_t count) {
+	return (offsetof(CacheRecord, candles) + count * sizeof(Candle) +
+	        FLASH_PAGE_SIZE - 1) &
+	       ~(size_t)(FLASH_PAGE_SIZE - 1);
+}
+
+static_assert(FLASH_CACHE_SECTORS >= 3,
+              "The head's sector, the erased one ahead and one to reclaim");
+static_assert(sizeof(CacheRecord) <= FLASH_SECTOR_SIZE,
+              "A record must fit in a sector");
+static_assert(WATCHLIST_MAX_SYMBOLS <=
+                  (FLASH_SECTOR_SIZE / record_size(FLASH_CACHE_CANDLES)) *
+                      (FLASH_CACHE_SECTORS - 2),
+              "Every symbol's newest record must fit outside the two "
+              "sectors being turned over");
+
+// Where the newest record of each watchlist symbol is, in watchlist order
+struct LiveRecord {
+	char symbol[8];
+	bool valid;
+	uint32_t offset;   // In the region
+	uint32_t sequence;
+	bool saved;        // Written since boot
+	uint32_t saved_ms;
+};
+
+static LiveRecord live[WATCHLIST_MAX_SYMBOLS];
+static size_t num_live = 0;
+
+// Where the next record goes: head, in head_sector, which may be full
+static uint32_t head_sector = 0;
+static uint32_t head = 0;
+static uint32_t next_sequence = 1;
+static bool cache_ready = false;
+
+// Staging for programming, as flash can't be read while it is written,
+// padded to whole pages
+static union {
+	CacheRecord record;
+	uint8_t bytes[record_size(FLASH_CACHE_CANDLES)];
+} staging;
+static CacheRecord &record_buffer = staging.record;
+
+static uint32_t now_ms() { return to_ms_since_boot(get_absolute_time()); }
+
+// Pass the CRC of the bytes before to carry on from them
+static uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = 0) {
+	// Reflected IEEE polynomial, a nibble at a time
+	static const uint32_t table[16] = {
+	    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+	    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+	    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+	    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
+	crc = ~crc;
+	for (size_t i = 0; i < len; i++) {
+		crc ^= data[i];
+		crc = (crc >> 4) ^ table[crc & 0xf];
+		crc = (crc >> 4) ^ table[crc & 0xf];
+	}
+	return ~crc;
+}
+
+// The magic and sequence, then from the symbol on, so a flipped bit in the
+// sequence can't make a stale record look like the newest
+static uint32_t record_crc(const CacheRecord &record) {
+	const uint8_t *bytes = (const uint8_t *)&record;
+	uint32_t crc = crc32(bytes, offsetof(CacheRecord, crc));
+	size_t len = offsetof(CacheRecord, candles) -
+	             offsetof(CacheRecord, symbol) + record.count * sizeof(Candle);
+	return crc32(bytes + offsetof(CacheRecord, symbol), len, crc);
+}
+
+// Flash is read through the XIP window
+static const uint8_t *flash_at(uint32_t offset) {
+	return (const uint8_t *)(XIP_BASE + FLASH_CACHE_OFFSET + offset);
+}
+
+static const CacheRecord *record_at(uint32_t offset) {
+	return (const CacheRecord *)flash_at(offset);
+}
+
+static bool record_valid(const CacheRecord *record) {
+	return record->magic == FLASH_CACHE_MAGIC &&
+	       record->count <= FLASH_CACHE_CANDLES &&
+	       record->crc == record_crc(*record);
+}
+
+static bool blank(uint32_t offset, size_t len) {
+	const uint8_t *bytes = flash_at(offset);
+	for (size_t i = 0; i < len; i++) {
+		if (bytes[i] != 0xff) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static uint32_t sector_of(uint32_t offset) {
+	return offset - offset % FLASH_SECTOR_SIZE;
+}
+
+static uint32_t next_sector(uint32_t offset) {
+	return (sector_of(offset) + FLASH_SECTOR_SIZE) % FLASH_CACHE_SIZE;
+}
+
+static bool head_has_room(size_t size) {
+	return head + size <= head_sector + FLASH_SECTOR_SIZE;
+}
+
+static LiveRecord *find_live(const char *symbol) {
+	for (size_t i = 0; i < num_live; i++) {
+		if (strncmp(live[i].symbol, symbol, sizeof(live[i].symbol)) == 0) {
+			return &live[i];
+		}
+	}
+	return nullptr;
+}
+
+struct FlashOp {
+	uint32_t offset;
+	const uint8_t *data;
+	size_t len;
+};
+
+static void erase_op(void *param) {
+	const FlashOp *op = (const FlashOp *)param;
+	flash_range_erase(FLASH_CACHE_OFFSET + op->offset, FLASH_SECTOR_SIZE);
+}
+
+static void program_op(void *param) {
+	const FlashOp *op = (const FlashOp *)param;
+	flash_range_program(FLASH_CACHE_OFFSET + op->offset, op->data, op->len);
+}
+
+static bool erase_sector(uint32_t offset) {
+	FlashOp op = {offset, nullptr, 0};
+	int err = flash_safe_execute(erase_op, &op, FLASH_CACHE_LOCKOUT_MS);
+	if (err != PICO_OK) {
+		printf("Flash cache: erase at %lu failed (%d)\n", (unsigned long)offset,
+		       err);
+		return false;
+	}
+	return true;
+}
+
+// Stamp record_buffer with the next sequence number and write it at the head,
+// which must have room for it in its sector
+static bool program_record(LiveRecord &entry) {
+	record_buffer.magic = FLASH_CACHE_MAGIC;
+	record_buffer.sequence = next_sequence;
+	record_buffer.crc = record_crc(record_buffer);
+
+	size_t size = record_size(record_buffer.count);
+	FlashOp op = {head, (const uint8_t *)&record_buffer, size};
+	int err = flash_safe_execute(program_op, &op, FLASH_CACHE_LOCKOUT_MS);
+	if (err != PICO_OK) {
+		printf("Flash cache: program at %lu failed (%d)\n",
+		       (unsigned long)head, err);
+		return false;
+	}
+
+	entry.valid = true;
+	entry.offset = head;
+	entry.sequence = next_sequence++;
+	head += size;
+	return true;
+}
+
+// Copy the newest records held in a sector to the head, then erase it. One
+// that doesn't fit beside the head is dropped.
+static bool reclaim(uint32_t sector) {
+	for (size_t i = 0; i < num_live; i++) {
+		LiveRecord &entry = live[i];
+		if (!entry.valid || sector_of(entry.offset) != sector) {
+			continue;
+		}
+		entry.valid = false;
+		const CacheRecord *record = record_at(entry.offset);
+		if (!record_valid(record) ||
+		    !head_has_room(record_size(record->count))) {
+			continue;
+		}
+		memset(staging.bytes, 0xff, sizeof(staging.bytes));
+		memcpy(&record_buffer, record,
+		       offsetof(CacheRecord, candles) +
+		           record->count * sizeof(Candle));
+		program_record(entry);
+	}
+	return blank(sector, FLASH_SECTOR_SIZE) || erase_sector(sector);
+}
+
+// Move the head to the start of the next sector, which is normally erased
+// already, and turn over the one after it so it is next time
+static bool open_next_sector() {
+	uint32_t next = next_sector(head_sector);
+	if (!blank(next, FLASH_SECTOR_SIZE)) {
+		// Only after power loss mid-erase, or on first use of the region
+		for (size_t i = 0; i < num_live; i++) {
+			if (live[i].valid && sector_of(live[i].offset) == next) {
+				live[i].valid = false;
+			}
+		}
+		if (!erase_sector(next)) {
+			return false;
+		}
+	}
+	head_sector = next;
+	head = next;
+	return reclaim(next_sector(next));
+}
+
+// Move the head on a sector at a time until size bytes fit. This may copy
+// records through record_buffer, so fill it afterwards.
+static bool make_room(size_t size) {
+	for (int turns = 0; !head_has_room(size); turns++) {
+		if (turns == FLASH_CACHE_SECTORS || !open_next_sector()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Find each watchlist symbol's newest valid record, and the head after the
+// newest record of all. Records start on page boundaries, so check each.
+static void scan() {
+	uint32_t newest = 0;
+	head_sector = 0;
+	head = 0;
+	for (uint32_t offset = 0; offset < FLASH_CACHE_SIZE;) {
+		const CacheRecord *record = record_at(offset);
+		if (!record_valid(record)) {
+			offset += FLASH_PAGE_SIZE;
+			continue;
+		}
+		LiveRecord *entry = find_live(record->symbol);
+		if (entry &&
+		    (!entry->valid || record->sequence > entry->sequence)) {
+			entry->valid = true;
+			entry->offset = offset;
+			entry->sequence = record->sequence;
+		}
+		size_t size = record_size(record->count);
+		if (record->sequence >= newest) {
+			newest = record->sequence;
+			head_sector = sector_of(offset);
+			head = offset + size;
+		}
+		offset += size;
+	}
+	next_sequence = newest + 1;
+}
+
+// Fill data from a record, as a fetch would have
+static void load(const CacheRecord *record, StockData &data) {
+	memcpy(data.symbol, record->symbol, sizeof(record->symbol));
+	data.symbol[sizeof(data.symbol) - 1] = '\0';
+	memcpy(data.duration, record->duration, sizeof(record->duration));
+	data.duration[sizeof(data.duration) - 1] = '\0';
+	clear_candles(data);
+	for (size_t i = 0; i < record->count; i++) {
+		append_candle(data, record->candles[i]);
+	}
+	data.open_price = record->open_price;
+	data.high_price = record->high_price;
+	data.low_price = record->low_price;
+	data.current_price = record->current_price;
+	data.price_change = record->price_change;
+	data.percent_change = record->percent_change;
+}
+
+bool flash_cache_init(StockData &shown) {
+	num_live = watchlist_size();
+	for (size_t i = 0; i < num_live; i++) {
+		memset(&live[i], 0, sizeof(live[i]));
+		watchlist_symbol(i, live[i].symbol, sizeof(live[i].symbol));
+	}
+
+	uint32_t start_us = time_us_32();
+	scan();
+
+	// A write cut short leaves junk after the newest record; carry on past
+	// it. Then make sure of an erased sector ahead of the head, as a cut
+	// may have come while it was being turned over.
+	while (!blank(head, head_sector + FLASH_SECTOR_SIZE - head)) {
+		head += FLASH_PAGE_SIZE;
+	}
+	cache_ready = reclaim(next_sector(head_sector));
+
+	// The first symbol last, so it is what shown ends up with
+	size_t restored = 0;
+	for (size_t i = num_live; i-- > 0;) {
+		if (!live[i].valid) {
+			continue;
+		}
+		load(record_at(live[i].offset), shown);
+		watchlist_record(shown, false);
+		restored++;
+	}
+	printf("Flash cache: %u of %u symbols restored in %lu us, head %lu\n",
+	       (unsigned)restored, (unsigned)num_live,
+	       (unsigned long)(time_us_32() - start_us), (unsigned long)head);
+	return num_live > 0 && live[0].valid;
+}
+
+bool flash_cache_save(const StockData &data) {
+	LiveRecord *entry = find_live(data.symbol);
+	if (!cache_ready || !entry) {
+		return false;
+	}
+	uint32_t now = now_ms();
+	if (entry->saved && now - entry->saved_ms < FLASH_CACHE_SAVE_INTERVAL_MS) {
+		return false;
+	}
+
+	// The newest candles, as many as a record holds
+	const StockCandles &history = data.history;
+	size_t first = history.recent_start(FLASH_CACHE_CANDLES);
+	entry->saved = true;
+	entry->saved_ms = now;
+	if (!make_room(record_size(history.size() - first))) {
+		return false;
+	}
+
+	memset(staging.bytes, 0xff, sizeof(staging.bytes));
+	memset(record_buffer.symbol, 0, sizeof(record_buffer.symbol));
+	strncpy(record_buffer.symbol, data.symbol,
+	        sizeof(record_buffer.symbol) - 1);
+	memset(record_buffer.duration, 0, sizeof(record_buffer.duration));
+	strncpy(record_buffer.duration, data.duration,
+	        sizeof(record_buffer.duration) - 1);
+	record_buffer.open_price = data.open_price;
+	record_buffer.high_price = data.high_price;
+	record_buffer.low_price = data.low_price;
+	record_buffer.current_price = data.current_price;
+	record_buffer.price_change = data.price_change;
+	record_buffer.percent_change = data.percent_change;
+	record_buffer.count = (uint16_t)(history.size() - first);
+	record_buffer.reserved = 0;
+	for (size_t i = first; i < history.size(); i++) {
+		record_buffer.candles[i - first] = history.at(i);
+	}
+
+	return program_record(*entry);
+}
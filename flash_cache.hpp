@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct StockData;
+
+// Flash reserved at the end of the chip for the cache, in 4 KiB sectors
+#ifndef FLASH_CACHE_SECTORS
+#define FLASH_CACHE_SECTORS 16
+#endif
+
+// A symbol's series is written at most this often. With the default
+// watchlist that is about one erase per sector an hour, so the flash's
+// 100k erase cycles last for years.
+#define FLASH_CACHE_SAVE_INTERVAL_MS (15 * 60 * 1000)
+
+// How long a flash operation may wait for the other core to stand aside
+#define FLASH_CACHE_LOCKOUT_MS 100
+
+// Last-known series of the watchlist symbols, kept in flash so a reboot can
+// show real data before the network is up.
+//
+// The region is a log: records are only ever appended, each carrying a
+// sequence number and a CRC-32, and a record that fails its check is
+// skipped, so a write cut short by power loss is never read back. The head
+// runs around the region a sector at a time, erasing the sector ahead of it,
+// which spreads erases evenly. The newest record of each symbol is copied
+// forward before its sector is erased. Power loss mid-write can at worst
+// cost a symbol its cached series, which the next fetch puts back.
+
+// Scan the log and load the watchlist with what it holds. shown gets the
+// first watchlist symbol's series, and true is returned, if there was one.
+// Call after watchlist_init, before the network task starts.
+bool flash_cache_init(StockData &shown);
+
+// Write a fetched series to the log, unless its symbol was saved less than
+// FLASH_CACHE_SAVE_INTERVAL_MS ago or isn't on the watchlist. Stalls both
+// cores for a few ms, longer when a sector has to be erased.
+bool flash_cache_save(const StockData &data);
@@ -0,0 +1,37 @@
+#include <cstddef>
+#include <new>
+
+#include "FreeRTOS.h"
+#include "pico/stdlib.h"
+
+// With heap_4/heap_5, C++ new comes from the FreeRTOS heap too, so objects
+// show up in its statistics and share its fragmentation behaviour. The SDK's
+// own malloc based operators are disabled with
+// PICO_CXX_DISABLE_ALLOCATION_OVERRIDES.
+#if FREERTOS_HEAP != 3
+
+static void *heap_new(std::size_t size) {
+	void *ptr = pvPortMalloc(size ? size : 1);
+	// Exceptions are off, so running out is fatal. The malloc failed hook
+	// has already reported it.
+	if (!ptr)
+		panic("operator new(%u) failed", (unsigned)size);
+	return ptr;
+}
+
+void *operator new(std::size_t size) { return heap_new(size); }
+void *operator new[](std::size_t size) { return heap_new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+	return pvPortMalloc(size ? size : 1);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+	return pvPortMalloc(size ? size : 1);
+}
+
+void operator delete(void *ptr) noexcept { vPortFree(ptr); }
+void operator delete[](void *ptr) noexcept { vPortFree(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { vPortFree(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { vPortFree(ptr); }
+
+#endif
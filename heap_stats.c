@@ -0,0 +1,97 @@
+#include "heap_stats.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Updated with the scheduler suspended, which serialises both cores
+static uint32_t live_blocks[HEAP_STATS_BUCKETS];
+
+#if FREERTOS_HEAP == 5
+// heap_5 can span several disjoint regions, lowest address first. Boards
+// with spare memory elsewhere add it here.
+static uint8_t heap_region[configTOTAL_HEAP_SIZE] __attribute__((aligned(8)));
+static const HeapRegion_t heap_regions[] = {
+    {heap_region, sizeof(heap_region)},
+    {NULL, 0},
+};
+
+// Static constructors already allocate (the display's frame buffer), so the
+// regions must be defined before any of them run
+static void __attribute__((constructor(101))) heap_stats_define_regions(void) {
+	vPortDefineHeapRegions(heap_regions);
+}
+#endif
+
+static uint32_t bucket_for(size_t size) {
+	uint32_t bucket = 0;
+	size >>= 5;
+	while (size && bucket < HEAP_STATS_BUCKETS - 1) {
+		size >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+// heap_3 doesn't report the size of freed blocks, so only count with 4 and 5
+void heap_stats_malloc(void *ptr, size_t size) {
+#if FREERTOS_HEAP == 4 || FREERTOS_HEAP == 5
+	if (ptr && size)
+		live_blocks[bucket_for(size)]++;
+#else
+	(void)ptr;
+	(void)size;
+#endif
+}
+
+void heap_stats_free(void *ptr, size_t size) {
+	uint32_t bucket = bucket_for(size);
+	if (ptr && size && live_blocks[bucket])
+		live_blocks[bucket]--;
+}
+
+void heap_stats_print(void) {
+#if FREERTOS_HEAP == 4 || FREERTOS_HEAP == 5
+	HeapStats_t stats;
+	vPortGetHeapStats(&stats);
+
+	printf("FreeRTOS heap_%d: %u of %u bytes free, minimum ever %u\n",
+	       FREERTOS_HEAP, (unsigned)stats.xAvailableHeapSpaceInBytes,
+	       (unsigned)configTOTAL_HEAP_SIZE,
+	       (unsigned)stats.xMinimumEverFreeBytesRemaining);
+	printf("  %u free blocks, largest %u, smallest %u\n",
+	       (unsigned)stats.xNumberOfFreeBlocks,
+	       (unsigned)stats.xSizeOfLargestFreeBlockInBytes,
+	       (unsigned)stats.xSizeOfSmallestFreeBlockInBytes);
+	// How much of the free space can't be handed out as one block
+	if (stats.xAvailableHeapSpaceInBytes) {
+		printf("  fragmentation %u%%\n",
+		       (unsigned)(100 - (uint64_t)stats.xSizeOfLargestFreeBlockInBytes *
+		                            100 / stats.xAvailableHeapSpaceInBytes));
+	}
+	printf("  %u allocations, %u frees\n",
+	       (unsigned)stats.xNumberOfSuccessfulAllocations,
+	       (unsigned)stats.xNumberOfSuccessfulFrees);
+
+	uint32_t live[HEAP_STATS_BUCKETS];
+	vTaskSuspendAll();
+	memcpy(live, live_blocks, sizeof(live));
+	(void)xTaskResumeAll();
+
+	printf("  live blocks by size:\n");
+	for (uint32_t i = 0; i < HEAP_STATS_BUCKETS; i++) {
+		if (live[i] == 0)
+			continue;
+		if (i == HEAP_STATS_BUCKETS - 1) {
+			printf("    >=%6u: %lu\n", 16u << i, (unsigned long)live[i]);
+		} else {
+			printf("    <%7u: %lu\n", 32u << i, (unsigned long)live[i]);
+		}
+	}
+#else
+	printf("FreeRTOS heap_%d: kernel objects come from newlib malloc\n",
+	       FREERTOS_HEAP);
+#endif
+}
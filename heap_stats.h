@@ -0,0 +1,35 @@
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Live allocations of the FreeRTOS heap by block size, in log2 buckets:
+// bucket i holds blocks of [16 << i, 32 << i) bytes and the last bucket
+// everything larger. Only heap_4 and heap_5 report block sizes.
+#define HEAP_STATS_BUCKETS 13
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocation hooks, called from traceMALLOC/traceFREE with the scheduler
+ * suspended
+ * @param ptr The block handed out or returned
+ * @param size The block size including the heap's header
+ */
+void heap_stats_malloc(void *ptr, size_t size);
+void heap_stats_free(void *ptr, size_t size);
+
+/**
+ * Print the FreeRTOS heap state: free space, minimum ever free, free block
+ * count and sizes, fragmentation and the live allocation histogram
+ */
+void heap_stats_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEAP_STATS_H
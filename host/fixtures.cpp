@@ -0,0 +1,85 @@
+#include "fixtures.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Fill in the summary fields the server would send alongside the candles
+static void finish(StockData &data, const char *symbol) {
+	snprintf(data.symbol, sizeof(data.symbol), "%s", symbol);
+	snprintf(data.duration, sizeof(data.duration), "1d");
+	const StockCandles &history = data.history;
+	data.open_price = history.front().open;
+	data.high_price = history.max_high();
+	data.low_price = history.min_low();
+	data.current_price = history.back().close;
+	data.price_change = data.current_price - data.open_price;
+	data.percent_change = data.price_change / data.open_price * 100.0f;
+}
+
+// A candle per step of a smooth price path, with a little wobble
+static void build_path(StockData &data, int len, float start, float slope,
+                       float wobble) {
+	data = StockData();
+	float price = start;
+	for (int i = 0; i < len; i++) {
+		float next = start + slope * (i + 1) + wobble * sinf(i * 0.7f);
+		Candle c = {};
+		c.open = price;
+		c.close = next;
+		c.high = fmaxf(price, next) + fabsf(wobble) * 0.3f;
+		c.low = fminf(price, next) - fabsf(wobble) * 0.3f;
+		c.volume = 1000.0f + 400.0f * fabsf(sinf(i * 0.3f));
+		append_candle(data, c);
+		price = next;
+	}
+}
+
+static void build_placeholder(StockData &data) { initialize_stock_data(data); }
+
+static void build_uptrend(StockData &data) {
+	build_path(data, 30, 180.0f, 0.8f, 1.5f);
+	finish(data, "AAPL");
+}
+
+static void build_downtrend(StockData &data) {
+	build_path(data, 30, 420.0f, -2.5f, 4.0f);
+	finish(data, "TSLA");
+}
+
+// Every price equal: the graph's range collapses to zero
+static void build_flat(StockData &data) {
+	build_path(data, 30, 100.0f, 0.0f, 0.0f);
+	finish(data, "FLAT");
+}
+
+static void build_sparse(StockData &data) {
+	build_path(data, 3, 52.0f, 1.0f, 0.5f);
+	finish(data, "NEW");
+}
+
+// Six digit prices stress the label widths
+static void build_expensive(StockData &data) {
+	build_path(data, 30, 612000.0f, 150.0f, 900.0f);
+	finish(data, "BRK.A");
+}
+
+// A trading day of 2 minute bars, more than the chart shows at once
+static void build_intraday(StockData &data) {
+	build_path(data, 195, 130.0f, 0.05f, 2.0f);
+	finish(data, "MSFT");
+}
+
+// A week of 2 minute bars, more than the series holds
+static void build_week(StockData &data) {
+	build_path(data, 975, 410.0f, -0.04f, 3.0f);
+	finish(data, "META");
+}
+
+const Fixture fixtures[] = {
+    {"placeholder", build_placeholder}, {"uptrend", build_uptrend},
+    {"downtrend", build_downtrend},     {"flat", build_flat},
+    {"sparse", build_sparse},           {"expensive", build_expensive},
+    {"intraday", build_intraday},       {"week", build_week},
+};
+const size_t num_fixtures = sizeof(fixtures) / sizeof(fixtures[0]);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+#include "display.hpp"
+
+// Named StockData inputs for the host renderer and benchmarks
+struct Fixture {
+	const char *name;
+	void (*build)(StockData &data);
+};
+
+extern const Fixture fixtures[];
+extern const size_t num_fixtures;
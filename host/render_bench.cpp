@@ -0,0 +1,82 @@
+// Microbenchmarks for the drawing code. Host timings don't predict the
+// RP2040's, but relative changes between runs do carry over.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#include "display.hpp"
+#include "fixtures.hpp"
+#include "hardware/rtc.h"
+#include "net_stats.h"
+
+// Run fn iterations times after a short warm-up and print mean and best
+static void bench(const char *name, int iterations,
+                  const std::function<void()> &fn) {
+	for (int i = 0; i < iterations / 10 + 1; i++) {
+		fn();
+	}
+
+	double total_us = 0;
+	double best_us = 1e12;
+	for (int i = 0; i < iterations; i++) {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		std::chrono::duration<double, std::micro> elapsed =
+		    std::chrono::steady_clock::now() - start;
+		total_us += elapsed.count();
+		best_us = std::min(best_us, elapsed.count());
+	}
+	printf("%-32s %10.1f %10.1f\n", name, total_us / iterations, best_us);
+}
+
+int main(int argc, char **argv) {
+	int iterations = argc > 1 ? atoi(argv[1]) : 200;
+	if (iterations <= 0) {
+		printf("usage: %s [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	datetime_t t = {2024, 1, 2, 2, 10, 30, 0};
+	rtc_set_datetime(&t);
+	net_stats_init();
+	initialize_display();
+
+	printf("%-32s %10s %10s\n", "benchmark (us)", "mean", "best");
+
+	// Whole frames: clear, draw, and the RGB565 conversion the panel needs
+	for (size_t i = 0; i < num_fixtures; i++) {
+		StockData data;
+		fixtures[i].build(data);
+		char name[48];
+		snprintf(name, sizeof(name), "update_display/%s", fixtures[i].name);
+		bench(name, iterations, [&] { update_display(data); });
+	}
+	bench("update_diagnostics_display", iterations,
+	      [] { update_diagnostics_display(); });
+
+	// The pieces of a frame, on the busiest fixture
+	StockData data;
+	fixtures[0].build(data);
+	bench("draw_header", iterations,
+	      [&] { display_internal::draw_header(data, "10:30 AM"); });
+	// Drawn from the cached layout, and the layout being worked out, as it
+	// is once per fetch or view change
+	bench("draw_graph_and_labels", iterations, [&] {
+		display_internal::draw_graph_and_labels(data, ChartView());
+	});
+	static ChartLayout layout;
+	bench("build_chart_layout", iterations, [&] {
+		display_internal::build_chart_layout(data, ChartView(), layout);
+	});
+	bench("draw_footer", iterations,
+	      [&] { display_internal::draw_footer(data); });
+	bench("get_nice_step", iterations * 100, [] {
+		volatile float step = display_internal::get_nice_step(123.4f);
+		(void)step;
+	});
+
+	return 0;
+}
@@ -0,0 +1,72 @@
+// Render every fixture, and the diagnostics page, to PPM files
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "display.hpp"
+#include "fixtures.hpp"
+#include "hardware/rtc.h"
+#include "host_display.hpp"
+#include "net_stats.h"
+
+// Some traffic so the diagnostics page has rows to show
+static void fake_network_stats() {
+	for (uint32_t i = 1; i <= 50; i++) {
+		net_stats_record(NET_METRIC_RTT_AUTH, 40000 + i * 900);
+		net_stats_record(NET_METRIC_RTT_GET_STOCK_DATA, 90000 + i * 2500);
+	}
+	net_stats_add(NET_COUNTER_RETRIES, 3);
+}
+
+// The longest fixture zoomed all the way in, showing the newest candles and
+// panned back into the history
+static const struct {
+	const char *name;
+	ChartView view;
+} zoomed_views[] = {
+    {"week_zoomed", {8, 0}},
+    {"week_panned", {8, 100}},
+};
+
+static bool write_frame(const std::string &dir, const char *name) {
+	std::string path = dir + "/" + name + ".ppm";
+	if (!host_display_write_ppm(host_display_frame(), path.c_str())) {
+		return false;
+	}
+	printf("%s\n", path.c_str());
+	return true;
+}
+
+int main(int argc, char **argv) {
+	std::string dir = argc > 1 ? argv[1] : ".";
+
+	datetime_t t = {2024, 1, 2, 2, 10, 30, 0};
+	rtc_set_datetime(&t);
+	net_stats_init();
+	initialize_display();
+
+	bool ok = true;
+	for (size_t i = 0; i < num_fixtures; i++) {
+		StockData data;
+		fixtures[i].build(data);
+		update_display(data);
+		ok &= write_frame(dir, fixtures[i].name);
+
+		if (strcmp(fixtures[i].name, "week") != 0) {
+			continue;
+		}
+		for (const auto &zoomed : zoomed_views) {
+			ChartView view = zoomed.view;
+			clamp_chart_view(data, view);
+			update_display(data, view);
+			ok &= write_frame(dir, zoomed.name);
+		}
+	}
+
+	fake_network_stats();
+	update_diagnostics_display();
+	ok &= write_frame(dir, "diagnostics");
+
+	return ok ? 0 : 1;
+}
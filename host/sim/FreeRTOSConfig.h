@@ -0,0 +1,113 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*-----------------------------------------------------------
+ * Simulator configuration for the FreeRTOS POSIX port. Application settings
+ * follow the firmware's FreeRTOSConfig.h; the RP2040 specifics are replaced
+ * by their host equivalents.
+ *
+ * Each task runs on its own pthread with its own host stack, so the FreeRTOS
+ * stacks only hold the port's thread record. Stack sizes are still in words,
+ * which are 8 bytes here: task stacks take twice the heap they do on the
+ * device and the stack high water marks say nothing about real usage.
+ *----------------------------------------------------------*/
+
+/* Scheduler Related */
+#define configUSE_PREEMPTION                    1
+#define configUSE_IDLE_HOOK                     1
+#define configUSE_TICK_HOOK                     1 /* sim_irq.cpp */
+#define configTICK_RATE_HZ                      ( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES                    32
+#define configMINIMAL_STACK_SIZE                ( configSTACK_DEPTH_TYPE ) 512
+#define configUSE_16_BIT_TICKS                  0
+
+#define configIDLE_SHOULD_YIELD                 1
+
+/* The POSIX port runs one task at a time */
+#define configNUMBER_OF_CORES                   1
+
+/* Synchronization Related */
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             1
+#define configUSE_APPLICATION_TASK_TAG          0
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configQUEUE_REGISTRY_SIZE               8
+#define configUSE_QUEUE_SETS                    1
+#define configUSE_TIME_SLICING                  1
+#define configUSE_NEWLIB_REENTRANT              0
+#define configENABLE_BACKWARD_COMPATIBILITY     1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
+
+/* System */
+#define configSTACK_DEPTH_TYPE                  uint32_t
+#define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
+
+/* Memory allocation related definitions, set from CMake as for the
+ * firmware */
+#ifndef FREERTOS_HEAP
+#define FREERTOS_HEAP                           3
+#endif
+#ifndef FREERTOS_HEAP_SIZE
+#define FREERTOS_HEAP_SIZE                      (256*1024)
+#endif
+#ifndef STATIC_ALLOCATION
+#define STATIC_ALLOCATION                       0
+#endif
+#define configSUPPORT_STATIC_ALLOCATION         STATIC_ALLOCATION
+#define configKERNEL_PROVIDED_STATIC_MEMORY     1
+#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configTOTAL_HEAP_SIZE                   FREERTOS_HEAP_SIZE
+#define configAPPLICATION_ALLOCATED_HEAP        0
+
+/* Hook function related definitions. */
+#define configCHECK_FOR_STACK_OVERFLOW          0 /* see above */
+#define configUSE_MALLOC_FAILED_HOOK            1
+#define configUSE_DAEMON_TASK_STARTUP_HOOK      0
+
+/* Run time and task stats gathering related definitions. The port counts
+ * process CPU time; the simulator build links in a microsecond counter in
+ * its place, as the firmware's tools expect. */
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                1
+#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+
+/* Co-routine related definitions. */
+#define configUSE_CO_ROUTINES                   0
+#define configMAX_CO_ROUTINE_PRIORITIES         1
+
+/* Software timer related definitions. */
+#define configUSE_TIMERS                        1
+#define configTIMER_TASK_PRIORITY               ( configMAX_PRIORITIES - 1 )
+#define configTIMER_QUEUE_LENGTH                10
+#define configTIMER_TASK_STACK_DEPTH            1024
+
+/* The port can't stop its tick, so the idle hook waits for it instead */
+#define configUSE_TICKLESS_IDLE                 0
+
+#include <assert.h>
+/* Define to trap errors during development. */
+#define configASSERT(x)                         assert(x)
+
+/* Set the following definitions to 1 to include the API function, or zero
+to exclude the API function. */
+#define INCLUDE_vTaskPrioritySet                1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_vTaskDelete                     1
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+#define INCLUDE_xTaskGetIdleTaskHandle          1
+#define INCLUDE_eTaskGetState                   1
+#define INCLUDE_xTimerPendFunctionCall          1
+#define INCLUDE_xTaskAbortDelay                 1
+#define INCLUDE_xTaskGetHandle                  1
+#define INCLUDE_xTaskResumeFromISR              1
+#define INCLUDE_xQueueGetMutexHolder            1
+
+/* The firmware's trace hooks work unchanged */
+#include "trace_hooks.h"
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,129 @@
+"""End-to-end check of pico_stock_ticker_sim against fixture_server.py.
+
+Makes a throwaway certificate for server.local, the name the firmware
+checks, starts the fixture server on the simulator's port, and runs the
+simulator until it has fetched the first watchlist symbol and drawn a frame
+from it. A button press wakes the display in case the server's clock says
+the market is closed. Fails if the simulator exits or the cycle doesn't
+finish within --timeout seconds.
+
+    python3 cycle_test.py --sim ./pico_stock_ticker_sim --port 8443
+"""
+
+import argparse
+import os
+import queue
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def make_cert(workdir, openssl):
+    cert = os.path.join(workdir, "server.crt")
+    key = os.path.join(workdir, "server.key")
+    subprocess.run(
+        [openssl, "req", "-x509", "-newkey", "rsa:2048", "-nodes",
+         "-keyout", key, "-out", cert, "-days", "1",
+         "-subj", "/CN=server.local",
+         "-addext", "subjectAltName=DNS:server.local"],
+        check=True, capture_output=True)
+    return cert, key
+
+
+def wait_for_port(port, timeout):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            socket.create_connection(("127.0.0.1", port), 0.2).close()
+            return True
+        except OSError:
+            time.sleep(0.1)
+    return False
+
+
+def read_lines(stream, lines):
+    for line in iter(stream.readline, ""):
+        sys.stdout.write(line)
+        lines.put(line)
+    lines.put(None)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--sim", required=True)
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--openssl", default="openssl")
+    parser.add_argument("--timeout", type=float, default=30)
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as workdir:
+        cert, key = make_cert(workdir, args.openssl)
+        frames = os.path.join(workdir, "frames")
+        os.mkdir(frames)
+
+        server = subprocess.Popen(
+            [sys.executable, os.path.join(HERE, "fixture_server.py"),
+             "--port", str(args.port), "--cert", cert, "--key", key],
+            stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        sim = None
+        try:
+            if not wait_for_port(args.port, 5):
+                print("FAIL: fixture server did not start")
+                return 1
+
+            env = dict(os.environ, SIM_CA_FILE=cert, SIM_FRAMES_DIR=frames,
+                       SIM_FLASH_FILE=os.path.join(workdir, "flash.bin"))
+            sim = subprocess.Popen(
+                [args.sim], env=env, stdin=subprocess.PIPE,
+                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+            lines = queue.Queue()
+            threading.Thread(target=read_lines, args=(sim.stdout, lines),
+                             daemon=True).start()
+
+            # Fetched, then drawn: the boot timeline is printed with the
+            # first frame drawn from fetched data
+            deadline = time.time() + args.timeout
+            fetched = False
+            while True:
+                left = deadline - time.time()
+                if left <= 0:
+                    print("FAIL: no live frame within %g s" % args.timeout)
+                    return 1
+                try:
+                    line = lines.get(timeout=left)
+                except queue.Empty:
+                    continue
+                if line is None:
+                    print("FAIL: simulator exited with %s" % sim.wait())
+                    return 1
+                if not fetched and line.startswith("I ") and \
+                        "data points" in line:
+                    fetched = True
+                    sim.stdin.write("press a\n")
+                    sim.stdin.flush()
+                if fetched and line.strip().startswith("first live frame"):
+                    break
+
+            # Let the frame reach the panel model
+            time.sleep(0.5)
+            dumped = [f for f in os.listdir(frames) if f.endswith(".ppm")]
+            if not dumped:
+                print("FAIL: no frames written")
+                return 1
+            print("PASS: fetched and drew live data, %d frames" % len(dumped))
+            return 0
+        finally:
+            if sim:
+                sim.kill()
+                sim.wait()
+            server.kill()
+            server.wait()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
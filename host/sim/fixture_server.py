@@ -0,0 +1,168 @@
+"""Stand-in for stock-ticker-tcp-server/server.py for the simulator.
+
+Speaks the same msgpack protocol over TLS but answers get_stock_data with
+a made-up price path instead of asking yfinance, so runs are repeatable and
+need no internet. --delay-ms holds every reply back to model a slow server.
+The certificate must be for server.local, the name the firmware checks;
+cycle_test.py makes one.
+
+    python3 fixture_server.py --cert server.crt --key server.key
+"""
+
+import argparse
+import logging
+import math
+import os
+import socket
+import ssl
+import threading
+import time
+
+import msgpack
+
+# The firmware's own token, so the simulator needs no extra setup
+DEFAULT_TOKEN = "supersecretclienttoken12345abcdef"
+
+# The firmware reads responses into a 1 KiB buffer
+MAX_CANDLES = 8
+
+PICO_COMPATIBLE_RSA_CIPHERS = [
+    "AES256-GCM-SHA384",
+    "AES128-GCM-SHA256",
+    "AES256-SHA256",
+    "AES128-SHA256",
+    "AES256-SHA",
+    "AES128-SHA",
+]
+
+logging.basicConfig(
+    level=logging.INFO,
+    format="%(asctime)s - %(levelname)s - %(threadName)s - %(message)s",
+)
+
+
+def candles(ticker, count):
+    """A smooth walk with some wobble, seeded by the ticker and the hour."""
+    seed = sum(ord(c) for c in ticker) + int(time.time() // 3600)
+    price = 50.0 + seed % 200
+    now = time.time()
+    data = []
+    for i in range(count):
+        close = price * (1.0 + 0.01 * math.sin(seed + i * 0.7))
+        data.append({
+            "Open": round(price, 2),
+            "High": round(max(price, close) * 1.002, 2),
+            "Low": round(min(price, close) * 0.998, 2),
+            "Close": round(close, 2),
+            "Volume": 1000 + (seed * (i + 1)) % 5000,
+            "Date": int(now) - (count - 1 - i) * 3600,
+        })
+        price = close
+    return data
+
+
+def respond(message):
+    command = message["command"]
+    payload = message.get("payload") or {}
+    response = {
+        "status": "received",
+        "original_command": command,
+        "timestamp": time.time(),
+    }
+    if command == "get_time":
+        response["server_time"] = time.strftime("%Y-%m-%d %H:%M:%S %Z")
+    elif command == "ping":
+        response["payload"] = "pong"
+    elif command == "get_stock_data":
+        ticker = payload.get("ticker")
+        if not ticker:
+            return {"status": "error", "message": "Missing ticker parameter"}
+        duration = payload.get("duration", "1d")
+        interval = payload.get("interval", "2m")
+        response = {
+            "status": "success",
+            "stock_data": {
+                "ticker": ticker,
+                "duration": duration,
+                "interval": interval,
+                "data": candles(ticker, MAX_CANDLES),
+            },
+        }
+    else:
+        response = {"status": "error", "message": "Unknown command"}
+    return response
+
+
+def handle_client(conn, address, args):
+    unpacker = msgpack.Unpacker(raw=False)
+    packer = msgpack.Packer(use_single_float=True)
+    authenticated = False
+    try:
+        while True:
+            data = conn.recv(4096)
+            if not data:
+                logging.info(f"[{address}] Client disconnected.")
+                break
+            unpacker.feed(data)
+            for message in unpacker:
+                if not isinstance(message, dict):
+                    reply = {"status": "error", "message": "Malformed message"}
+                elif not authenticated:
+                    if message.get("token") != args.token:
+                        logging.warning(f"[{address}] Invalid token.")
+                        conn.sendall(packer.pack(
+                            {"status": "error", "message": "Invalid token"}))
+                        return
+                    authenticated = True
+                    reply = {"status": "ok", "message": "Authenticated"}
+                elif "command" in message:
+                    reply = respond(message)
+                else:
+                    reply = {"status": "error", "message": "Unknown command"}
+                if args.delay_ms:
+                    time.sleep(args.delay_ms / 1000.0)
+                logging.info(f"[{address}] Sending {reply}")
+                conn.sendall(packer.pack(reply))
+    except (ssl.SSLError, OSError, msgpack.exceptions.UnpackException) as e:
+        logging.error(f"[{address}] {e}")
+    finally:
+        conn.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert", default="./certs/server/server.crt")
+    parser.add_argument("--key", default="./certs/server/server.key")
+    parser.add_argument("--token",
+                        default=os.environ.get("CLIENT_AUTH_TOKEN",
+                                               DEFAULT_TOKEN))
+    parser.add_argument("--delay-ms", type=int, default=0,
+                        help="hold every reply back this long")
+    args = parser.parse_args()
+
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(certfile=args.cert, keyfile=args.key)
+    context.set_ciphers(":".join(PICO_COMPATIBLE_RSA_CIPHERS))
+
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as sock:
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        sock.bind((args.host, args.port))
+        sock.listen(5)
+        logging.info(f"Listening on {args.host}:{args.port}")
+        while True:
+            conn, address = sock.accept()
+            try:
+                secure_conn = context.wrap_socket(conn, server_side=True)
+            except ssl.SSLError as e:
+                logging.error(f"[{address}] Handshake failed: {e}")
+                conn.close()
+                continue
+            threading.Thread(target=handle_client,
+                             args=(secure_conn, address, args),
+                             daemon=True).start()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+// Flash for the simulator, saved to SIM_FLASH_FILE after every change so the
+// next run boots with what this one wrote
+
+#include <cstdio>
+#include <cstring>
+
+#include "hardware/flash.h"
+#include "pico/stdlib.h"
+#include "sim_platform.hpp"
+
+uint8_t sim_flash_memory[PICO_FLASH_SIZE_BYTES];
+
+static FILE *flash_file = nullptr;
+
+static void save(uint32_t offset, size_t count) {
+	if (!flash_file) {
+		return;
+	}
+	if (fseek(flash_file, offset, SEEK_SET) != 0 ||
+	    fwrite(sim_flash_memory + offset, 1, count, flash_file) != count ||
+	    fflush(flash_file) != 0) {
+		printf("Cannot write flash file %s\n", sim_config().flash_file);
+	}
+}
+
+void sim_flash_init() {
+	memset(sim_flash_memory, 0xff, sizeof(sim_flash_memory));
+	const char *path = sim_config().flash_file;
+	if (!path) {
+		return;
+	}
+
+	// A missing or short file reads as erased flash
+	flash_file = fopen(path, "r+b");
+	if (flash_file) {
+		size_t got = fread(sim_flash_memory, 1, sizeof(sim_flash_memory),
+		                   flash_file);
+		printf("Read %u bytes of flash from %s\n", (unsigned)got, path);
+	} else {
+		flash_file = fopen(path, "w+b");
+	}
+	if (!flash_file) {
+		printf("Cannot open flash file %s\n", path);
+	}
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+	if (flash_offs % FLASH_SECTOR_SIZE != 0 || count % FLASH_SECTOR_SIZE != 0 ||
+	    flash_offs + count > sizeof(sim_flash_memory)) {
+		panic("flash_range_erase(%lu, %u) not sector aligned or out of range",
+		      (unsigned long)flash_offs, (unsigned)count);
+	}
+	memset(sim_flash_memory + flash_offs, 0xff, count);
+	save(flash_offs, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data,
+                         size_t count) {
+	if (flash_offs % FLASH_PAGE_SIZE != 0 || count % FLASH_PAGE_SIZE != 0 ||
+	    flash_offs + count > sizeof(sim_flash_memory)) {
+		panic("flash_range_program(%lu, %u) not page aligned or out of range",
+		      (unsigned long)flash_offs, (unsigned)count);
+	}
+	for (size_t i = 0; i < count; i++) {
+		sim_flash_memory[flash_offs + i] &= data[i];
+	}
+	save(flash_offs, count);
+}
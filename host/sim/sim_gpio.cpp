@@ -0,0 +1,128 @@
+// GPIO edge interrupts for the simulator, and a console command that
+// presses the display's buttons
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "console.hpp"
+#include "display.hpp"
+#include "hardware/gpio.h"
+#include "sim_platform.hpp"
+
+#define SIM_GPIO_COUNT 30
+#define SIM_PRESS_DEFAULT_MS 100
+
+// As on the RP2040, edges latch whether or not their interrupt is enabled
+// and stay latched until acknowledged. Only touched with interrupts masked.
+static gpio_irq_callback_t irq_callback = nullptr;
+static uint32_t irq_enabled[SIM_GPIO_COUNT];
+static uint32_t irq_latched[SIM_GPIO_COUNT];
+static uint64_t release_at_us[SIM_GPIO_COUNT];
+
+static void set_input(uint gpio, bool value) {
+	bool was = gpio_get(gpio);
+	host_gpio_set_input(gpio, value);
+	if (value && !was) {
+		irq_latched[gpio] |= GPIO_IRQ_EDGE_RISE;
+	} else if (!value && was) {
+		irq_latched[gpio] |= GPIO_IRQ_EDGE_FALL;
+	}
+}
+
+static void gpio_irq() {
+	uint64_t now = time_us_64();
+	for (uint gpio = 0; gpio < SIM_GPIO_COUNT; gpio++) {
+		if (release_at_us[gpio] != 0) {
+			if (now >= release_at_us[gpio]) {
+				release_at_us[gpio] = 0;
+				set_input(gpio, true);
+			} else {
+				sim_irq_raise_at(release_at_us[gpio]);
+			}
+		}
+
+		// The SDK's dispatcher acknowledges the edges before the callback
+		uint32_t events = irq_latched[gpio] & irq_enabled[gpio];
+		if (events != 0 && irq_callback != nullptr) {
+			irq_latched[gpio] &= ~events;
+			irq_callback(gpio, events);
+		}
+	}
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+	if (gpio >= SIM_GPIO_COUNT) {
+		return;
+	}
+	taskENTER_CRITICAL();
+	if (enabled) {
+		irq_enabled[gpio] |= event_mask;
+	} else {
+		irq_enabled[gpio] &= ~event_mask;
+	}
+	taskEXIT_CRITICAL();
+	// Edges latched while masked fire as soon as they are unmasked
+	sim_irq_raise();
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask,
+                                        bool enabled,
+                                        gpio_irq_callback_t callback) {
+	irq_callback = callback;
+	gpio_set_irq_enabled(gpio, event_mask, enabled);
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask) {
+	if (gpio >= SIM_GPIO_COUNT) {
+		return;
+	}
+	taskENTER_CRITICAL();
+	irq_latched[gpio] &= ~event_mask;
+	taskEXIT_CRITICAL();
+}
+
+static Button *button_by_name(const char *name) {
+	switch (name[0]) {
+	case 'a':
+		return &button_a;
+	case 'b':
+		return &button_b;
+	case 'x':
+		return &button_x;
+	case 'y':
+		return &button_y;
+	default:
+		return nullptr;
+	}
+}
+
+// Console command: hold a button down for a while, 100 ms unless given. A
+// hold past the button's hold time makes a long press.
+static void cmd_press(int argc, char **argv) {
+	Button *button = argc > 1 ? button_by_name(argv[1]) : nullptr;
+	if (button == nullptr || strlen(argv[1]) != 1) {
+		printf("usage: press <a|b|x|y> [ms]\n");
+		return;
+	}
+	uint32_t ms = argc > 2 ? strtoul(argv[2], nullptr, 10) : 0;
+	if (ms == 0) {
+		ms = SIM_PRESS_DEFAULT_MS;
+	}
+
+	uint gpio = button->get_pin();
+	taskENTER_CRITICAL();
+	set_input(gpio, false);
+	release_at_us[gpio] = time_us_64() + (uint64_t)ms * 1000;
+	taskEXIT_CRITICAL();
+	sim_irq_raise();
+}
+
+void sim_gpio_init() {
+	sim_irq_register(gpio_irq);
+	console_register("press", "press a button: press <a|b|x|y> [ms]",
+	                 cmd_press);
+}
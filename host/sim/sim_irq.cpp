@@ -0,0 +1,84 @@
+// Simulated interrupts, see sim_platform.hpp
+
+#include <atomic>
+#include <cstdio>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "pico/stdlib.h"
+#include "sim_platform.hpp"
+
+#define SIM_IRQ_TASK_PRIORITY (configMAX_PRIORITIES - 1)
+#define SIM_IRQ_TASK_STACK_SIZE configMINIMAL_STACK_SIZE
+
+static SimIrqHandler handlers[SIM_IRQ_MAX_HANDLERS];
+static std::atomic<size_t> num_handlers{0};
+static TaskHandle_t irq_task_handle = NULL;
+
+// Written from host threads and read in the tick interrupt, hence lock-free
+static std::atomic<bool> irq_pending{false};
+static std::atomic<uint64_t> irq_deadline_us{UINT64_MAX};
+
+static void irq_task(__unused void *params) {
+	while (true) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		portDISABLE_INTERRUPTS();
+		size_t count = num_handlers.load();
+		for (size_t i = 0; i < count; i++) {
+			handlers[i]();
+		}
+		portENABLE_INTERRUPTS();
+	}
+}
+
+void sim_irq_init() {
+	if (xTaskCreate(irq_task, "SimIrq", SIM_IRQ_TASK_STACK_SIZE, NULL,
+	                SIM_IRQ_TASK_PRIORITY, &irq_task_handle) != pdPASS) {
+		printf("Failed to create the interrupt task\n");
+	}
+}
+
+bool sim_irq_register(SimIrqHandler handler) {
+	bool added = false;
+	taskENTER_CRITICAL();
+	size_t count = num_handlers.load();
+	if (count < SIM_IRQ_MAX_HANDLERS) {
+		handlers[count] = handler;
+		num_handlers = count + 1;
+		added = true;
+	}
+	taskEXIT_CRITICAL();
+
+	if (!added) {
+		printf("Interrupt handler table full\n");
+	}
+	return added;
+}
+
+void sim_irq_raise() { irq_pending = true; }
+
+void sim_irq_raise_at(uint64_t when_us) {
+	uint64_t deadline = irq_deadline_us.load();
+	while (when_us < deadline &&
+	       !irq_deadline_us.compare_exchange_weak(deadline, when_us)) {
+	}
+}
+
+// Runs in the port's SIGALRM handler. Waking the task here, rather than
+// calling the handlers, keeps them out of the tick and lets the kernel
+// switch to the task when the tick returns.
+void vApplicationTickHook(void) {
+	if (irq_task_handle == NULL) {
+		return;
+	}
+	bool fire = irq_pending.exchange(false);
+	uint64_t deadline = irq_deadline_us.load();
+	if (time_us_64() >= deadline &&
+	    irq_deadline_us.compare_exchange_strong(deadline, UINT64_MAX)) {
+		fire = true;
+	}
+	if (fire) {
+		vTaskNotifyGiveFromISR(irq_task_handle, NULL);
+	}
+}
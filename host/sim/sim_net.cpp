@@ -0,0 +1,691 @@
+// The simulator's network stack: tls_client.h over host sockets and OpenSSL,
+// in place of tls_common.c on lwIP, altcp_tls and mbedTLS. The sockets are
+// driven by a task named after lwIP's tcpip thread, so the firmware pins and
+// profiles it as it would the real one. Callers block on semaphores as they
+// do with tls_common.c, and the same network statistics are recorded at the
+// same points.
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "dlog.h"
+#include "lwip/opt.h"
+#include "net_stats.h"
+#include "pico/stdlib.h"
+#include "sim_platform.hpp"
+#include "tls_client.h"
+
+// Error codes, as in tls_common.c
+#define TLS_ERROR_TIMEOUT -1
+#define TLS_ERROR_GENERIC -2
+#define TLS_ERROR_MEMORY -3
+#define TLS_ERROR_CONNECTION -4
+
+#define TLS_CLIENT_DEFAULT_SNI "server.local"
+
+#define SIM_NET_QUEUE_LENGTH 8
+#define SIM_NET_MAX_CLIENTS 4
+#define SIM_NET_MAX_SNI 64
+// Largest write the client accepts at once, standing in for lwIP's send
+// buffer
+#define SIM_NET_MAX_WRITE 4096
+// One TLS record
+#define SIM_NET_READ_CHUNK 16384
+// tls_common.c polls its pcb every 20 x 500 ms and closes it on the first
+// poll, so no connection lives longer than this
+#define SIM_NET_POLL_TIMEOUT_US (20 * 500 * 1000)
+
+enum SimNetState : uint8_t {
+	NET_STATE_TCP_CONNECTING,
+	NET_STATE_HANDSHAKING,
+	NET_STATE_CONNECTED,
+	NET_STATE_CLOSED,
+};
+
+enum SimNetRequestType : uint8_t {
+	NET_REQUEST_RESOLVE,
+	NET_REQUEST_OPEN,
+	NET_REQUEST_SEND,
+	NET_REQUEST_CLOSE,
+};
+
+typedef struct TLS_CLIENT_T_ {
+	// Set by the caller before it opens the connection
+	struct sockaddr_in addr;
+	char sni[SIM_NET_MAX_SNI];
+	const uint8_t *cert;
+	size_t cert_len;
+	SemaphoreHandle_t complete_sem;
+	SemaphoreHandle_t recv_sem;
+	SemaphoreHandle_t close_sem;
+
+	// Only touched by the tcpip thread
+	SimNetState state;
+	int fd;
+	SSL_CTX *ctx;
+	SSL *ssl;
+	uint32_t connect_start_us;
+	uint32_t tcp_connected_us;
+
+	// Handed between the caller and the tcpip thread in critical sections
+	int error;
+	bool is_connected;
+	size_t write_len; // bytes waiting in write_buffer, 0 once sent
+	uint8_t write_buffer[SIM_NET_MAX_WRITE];
+	uint8_t *recv_buffer;
+	size_t recv_buffer_size;
+	size_t recv_len;
+	bool recv_wanted; // cleared when the caller stops waiting
+} TLS_CLIENT_T;
+
+struct SimNetRequest {
+	SimNetRequestType type;
+	TLS_CLIENT_T *client;
+};
+
+// A blocking lookup, as in tls_common.c: one at a time, and a late answer
+// after the caller has given up is dropped
+struct SimDnsRequest {
+	SemaphoreHandle_t done_sem;
+	char hostname[256];
+	struct in_addr addr;
+	bool pending;
+	bool found;
+	uint32_t start_us;
+};
+
+static QueueHandle_t request_queue = NULL;
+static SimDnsRequest dns_request;
+
+// Only touched by the tcpip thread
+static TLS_CLIENT_T *clients[SIM_NET_MAX_CLIENTS];
+static uint8_t read_chunk[SIM_NET_READ_CHUNK];
+
+static bool post(SimNetRequestType type, TLS_CLIENT_T *client) {
+	SimNetRequest request = {type, client};
+	if (xQueueSend(request_queue, &request, portMAX_DELAY) != pdTRUE) {
+		printf("Failed to queue network request\n");
+		return false;
+	}
+	return true;
+}
+
+static void print_ssl_error(const char *what) {
+	unsigned long err = ERR_get_error();
+	char text[160];
+	ERR_error_string_n(err, text, sizeof(text));
+	printf("%s: %s\n", what, err ? text : strerror(errno));
+	ERR_clear_error();
+}
+
+// The rest runs in the tcpip thread. Host library calls are made with the
+// scheduler suspended, as the port switches tasks from a signal handler and
+// must not park this one inside OpenSSL or the C library.
+
+static void release_socket(TLS_CLIENT_T *state) {
+	if (state->ssl) {
+		SSL_free(state->ssl);
+		state->ssl = NULL;
+	}
+	if (state->ctx) {
+		SSL_CTX_free(state->ctx);
+		state->ctx = NULL;
+	}
+	if (state->fd >= 0) {
+		close(state->fd);
+		state->fd = -1;
+	}
+}
+
+// End the connection and wake whoever is waiting on it
+static void close_internal(TLS_CLIENT_T *state, int error) {
+	release_socket(state);
+	state->state = NET_STATE_CLOSED;
+	taskENTER_CRITICAL();
+	if (error != 0) {
+		state->error = error;
+	}
+	state->is_connected = false;
+	state->recv_wanted = false;
+	taskEXIT_CRITICAL();
+	xSemaphoreGive(state->complete_sem);
+	xSemaphoreGive(state->recv_sem);
+}
+
+static void fail(TLS_CLIENT_T *state, const char *what) {
+	print_ssl_error(what);
+	net_stats_add(NET_COUNTER_ERRORS, 1);
+	close_internal(state, TLS_ERROR_GENERIC);
+}
+
+// Trust the given PEM certificates, or SIM_CA_FILE in their place
+static bool load_trust(TLS_CLIENT_T *state) {
+	const char *ca_file = sim_config().ca_file;
+	if (ca_file) {
+		return SSL_CTX_load_verify_locations(state->ctx, ca_file, NULL) == 1;
+	}
+	if (state->cert == NULL) {
+		SSL_CTX_set_verify(state->ctx, SSL_VERIFY_NONE, NULL);
+		return true;
+	}
+
+	BIO *bio = BIO_new_mem_buf(state->cert, (int)state->cert_len);
+	X509_STORE *store = SSL_CTX_get_cert_store(state->ctx);
+	int loaded = 0;
+	X509 *cert;
+	while (bio && (cert = PEM_read_bio_X509(bio, NULL, NULL, NULL)) != NULL) {
+		loaded += X509_STORE_add_cert(store, cert) == 1;
+		X509_free(cert);
+	}
+	BIO_free(bio);
+	ERR_clear_error(); // the read past the last certificate
+	return loaded > 0;
+}
+
+static bool start_tls(TLS_CLIENT_T *state) {
+	state->ctx = SSL_CTX_new(TLS_client_method());
+	if (!state->ctx) {
+		return false;
+	}
+	SSL_CTX_set_verify(state->ctx, SSL_VERIFY_PEER, NULL);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+	// server.py closes without a close_notify, which lwIP takes as a close
+	SSL_CTX_set_options(state->ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+	if (!load_trust(state)) {
+		printf("no usable CA certificate\n");
+		return false;
+	}
+
+	state->ssl = SSL_new(state->ctx);
+	if (!state->ssl || SSL_set_fd(state->ssl, state->fd) != 1) {
+		return false;
+	}
+	// The server name goes out for SNI and the certificate must match it,
+	// as with mbedtls_ssl_set_hostname
+	SSL_set_tlsext_host_name(state->ssl, state->sni);
+	SSL_set1_host(state->ssl, state->sni);
+	return true;
+}
+
+static void open_connection(TLS_CLIENT_T *state) {
+	uint32_t ip = ntohl(state->addr.sin_addr.s_addr);
+	DLOG_INFO("connecting to server IP %d.%d.%d.%d port %d\n",
+	          (int)(ip >> 24), (int)(ip >> 16 & 0xff), (int)(ip >> 8 & 0xff),
+	          (int)(ip & 0xff), ntohs(state->addr.sin_port));
+	state->connect_start_us = time_us_32();
+
+	vTaskSuspendAll();
+	state->fd = socket(AF_INET, SOCK_STREAM, 0);
+	bool started = state->fd >= 0 &&
+	               fcntl(state->fd, F_SETFL, O_NONBLOCK) == 0 &&
+	               (connect(state->fd, (struct sockaddr *)&state->addr,
+	                        sizeof(state->addr)) == 0 ||
+	                errno == EINPROGRESS || errno == EINTR);
+	xTaskResumeAll();
+
+	if (!started) {
+		printf("error initiating connect: %s\n", strerror(errno));
+		close_internal(state, TLS_ERROR_CONNECTION);
+		return;
+	}
+	state->state = NET_STATE_TCP_CONNECTING;
+}
+
+static void poll_connecting(TLS_CLIENT_T *state) {
+	struct pollfd pfd = {state->fd, POLLOUT, 0};
+	if (poll(&pfd, 1, 0) <= 0) {
+		return;
+	}
+	int err = 0;
+	socklen_t len = sizeof(err);
+	getsockopt(state->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+	if (err != 0) {
+		errno = err;
+		fail(state, "connect failed");
+		return;
+	}
+
+	state->tcp_connected_us = time_us_32();
+	net_stats_record(NET_METRIC_TCP_CONNECT,
+	                 state->tcp_connected_us - state->connect_start_us);
+
+	vTaskSuspendAll();
+	bool tls_ready = start_tls(state);
+	xTaskResumeAll();
+	if (!tls_ready) {
+		fail(state, "TLS setup failed");
+		return;
+	}
+	state->state = NET_STATE_HANDSHAKING;
+}
+
+static void poll_handshake(TLS_CLIENT_T *state) {
+	vTaskSuspendAll();
+	int ret = SSL_connect(state->ssl);
+	int err = ret == 1 ? SSL_ERROR_NONE : SSL_get_error(state->ssl, ret);
+	long verify = SSL_get_verify_result(state->ssl);
+	xTaskResumeAll();
+
+	if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+		return;
+	}
+	if (err != SSL_ERROR_NONE) {
+		if (verify != X509_V_OK) {
+			printf("certificate verification failed: %s\n",
+			       X509_verify_cert_error_string(verify));
+		}
+		fail(state, "TLS handshake failed");
+		return;
+	}
+
+	net_stats_record(NET_METRIC_TLS_HANDSHAKE,
+	                 time_us_32() - state->tcp_connected_us);
+	net_stats_add(NET_COUNTER_CONNECTS, 1);
+	state->state = NET_STATE_CONNECTED;
+	taskENTER_CRITICAL();
+	state->is_connected = true;
+	taskEXIT_CRITICAL();
+	xSemaphoreGive(state->complete_sem);
+}
+
+static void poll_connected(TLS_CLIENT_T *state) {
+	taskENTER_CRITICAL();
+	size_t write_len = state->write_len;
+	bool recv_wanted = state->recv_wanted;
+	taskEXIT_CRITICAL();
+
+	if (write_len > 0) {
+		vTaskSuspendAll();
+		int ret = SSL_write(state->ssl, state->write_buffer, (int)write_len);
+		int err = ret > 0 ? SSL_ERROR_NONE : SSL_get_error(state->ssl, ret);
+		xTaskResumeAll();
+		if (err == SSL_ERROR_NONE) {
+			taskENTER_CRITICAL();
+			state->write_len = 0;
+			taskEXIT_CRITICAL();
+		} else if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+			fail(state, "error writing data");
+			return;
+		}
+	}
+
+	// Like a closed TCP window, data is left in the socket until wanted
+	if (!recv_wanted) {
+		return;
+	}
+	vTaskSuspendAll();
+	int ret = SSL_read(state->ssl, read_chunk, sizeof(read_chunk));
+	int err = ret > 0 ? SSL_ERROR_NONE : SSL_get_error(state->ssl, ret);
+	xTaskResumeAll();
+
+	if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+		return;
+	}
+	if (err == SSL_ERROR_ZERO_RETURN ||
+	    (err == SSL_ERROR_SYSCALL && ERR_peek_error() == 0 && errno == 0)) {
+		DLOG_DEBUG("connection closed\n");
+		close_internal(state, TLS_ERROR_CONNECTION);
+		return;
+	}
+	if (err != SSL_ERROR_NONE) {
+		fail(state, "error reading data");
+		return;
+	}
+
+	// Hand over the first chunk, as tls_common.c does with the first pbuf
+	net_stats_add(NET_COUNTER_BYTES_IN, ret);
+	bool delivered = false;
+	taskENTER_CRITICAL();
+	if (state->recv_wanted) {
+		size_t copy_len = (size_t)ret > state->recv_buffer_size
+		                      ? state->recv_buffer_size
+		                      : (size_t)ret;
+		memcpy(state->recv_buffer, read_chunk, copy_len);
+		state->recv_len = copy_len;
+		state->recv_wanted = false;
+		delivered = true;
+	}
+	taskEXIT_CRITICAL();
+	if (delivered) {
+		xSemaphoreGive(state->recv_sem);
+	}
+}
+
+static bool any_open() {
+	for (TLS_CLIENT_T *state : clients) {
+		if (state && state->state != NET_STATE_CLOSED) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void poll_clients() {
+	for (TLS_CLIENT_T *state : clients) {
+		if (state == NULL || state->state == NET_STATE_CLOSED) {
+			continue;
+		}
+		if (time_us_32() - state->connect_start_us >= SIM_NET_POLL_TIMEOUT_US) {
+			printf("timed out\n");
+			net_stats_add(NET_COUNTER_TIMEOUTS, 1);
+			close_internal(state, TLS_ERROR_TIMEOUT);
+			continue;
+		}
+		switch (state->state) {
+		case NET_STATE_TCP_CONNECTING:
+			poll_connecting(state);
+			break;
+		case NET_STATE_HANDSHAKING:
+			poll_handshake(state);
+			break;
+		case NET_STATE_CONNECTED:
+			poll_connected(state);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+// getaddrinfo blocks, so a slow lookup stalls every task. Dotted addresses
+// never get here.
+static void resolve() {
+	struct addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	struct addrinfo *result = NULL;
+
+	vTaskSuspendAll();
+	int err = getaddrinfo(dns_request.hostname, NULL, &hints, &result);
+	struct in_addr addr = {};
+	if (err == 0) {
+		addr = ((struct sockaddr_in *)result->ai_addr)->sin_addr;
+		freeaddrinfo(result);
+	}
+	xTaskResumeAll();
+
+	taskENTER_CRITICAL();
+	bool pending = dns_request.pending;
+	if (pending) {
+		dns_request.pending = false;
+		dns_request.found = err == 0;
+		dns_request.addr = addr;
+	}
+	taskEXIT_CRITICAL();
+	if (!pending) {
+		return; // The caller already gave up on this lookup
+	}
+
+	net_stats_record(NET_METRIC_DNS, time_us_32() - dns_request.start_us);
+	if (err != 0) {
+		printf("error resolving hostname %s\n", dns_request.hostname);
+	}
+	xSemaphoreGive(dns_request.done_sem);
+}
+
+static void add_client(TLS_CLIENT_T *state) {
+	for (TLS_CLIENT_T *&slot : clients) {
+		if (slot == NULL) {
+			slot = state;
+			open_connection(state);
+			return;
+		}
+	}
+	printf("too many open connections\n");
+	close_internal(state, TLS_ERROR_MEMORY);
+}
+
+static void remove_client(TLS_CLIENT_T *state) {
+	release_socket(state);
+	state->state = NET_STATE_CLOSED;
+	for (TLS_CLIENT_T *&slot : clients) {
+		if (slot == state) {
+			slot = NULL;
+		}
+	}
+	xSemaphoreGive(state->close_sem);
+}
+
+static void tcpip_thread(__unused void *params) {
+	while (true) {
+		// Sockets have no interrupt to wake the task, so poll them every
+		// tick while a connection is open
+		TickType_t wait = any_open() ? 1 : portMAX_DELAY;
+		SimNetRequest request;
+		if (xQueueReceive(request_queue, &request, wait) == pdTRUE) {
+			switch (request.type) {
+			case NET_REQUEST_RESOLVE:
+				resolve();
+				break;
+			case NET_REQUEST_OPEN:
+				add_client(request.client);
+				break;
+			case NET_REQUEST_SEND:
+				break; // picked up by the poll below
+			case NET_REQUEST_CLOSE:
+				remove_client(request.client);
+				break;
+			}
+		}
+		poll_clients();
+	}
+}
+
+bool sim_net_init() {
+	// A write to a socket the server has closed must fail, not kill us
+	signal(SIGPIPE, SIG_IGN);
+
+	vTaskSuspendAll();
+	OPENSSL_init_ssl(0, NULL);
+	xTaskResumeAll();
+
+	request_queue = xQueueCreate(SIM_NET_QUEUE_LENGTH, sizeof(SimNetRequest));
+	dns_request.done_sem = xSemaphoreCreateBinary();
+	if (request_queue == NULL || dns_request.done_sem == NULL) {
+		printf("Failed to create the network queues\n");
+		return false;
+	}
+	return xTaskCreate(tcpip_thread, TCPIP_THREAD_NAME, TCPIP_THREAD_STACKSIZE,
+	                   NULL, TCPIP_THREAD_PRIO, NULL) == pdPASS;
+}
+
+char *ipaddr_ntoa(const ip_addr_t *addr) {
+	static char text[16];
+	struct in_addr in = {addr->addr};
+	inet_ntop(AF_INET, &in, text, sizeof(text));
+	return text;
+}
+
+// Caller side, mirroring tls_common.c
+
+bool tls_client_resolve(const char *hostname, ip_addr_t *out_addr,
+                        uint32_t timeout_ms) {
+	// Dotted addresses are answered on the spot, as by dns_gethostbyname
+	struct in_addr literal;
+	if (inet_pton(AF_INET, hostname, &literal) == 1) {
+		out_addr->addr = literal.s_addr;
+		return true;
+	}
+	if (strlen(hostname) >= sizeof(dns_request.hostname)) {
+		return false;
+	}
+
+	// Drop any stale completion left over from a timed out lookup
+	xSemaphoreTake(dns_request.done_sem, 0);
+
+	printf("resolving %s\n", hostname);
+
+	taskENTER_CRITICAL();
+	strcpy(dns_request.hostname, hostname);
+	dns_request.pending = true;
+	dns_request.found = false;
+	dns_request.start_us = time_us_32();
+	taskEXIT_CRITICAL();
+
+	if (!post(NET_REQUEST_RESOLVE, NULL) ||
+	    xSemaphoreTake(dns_request.done_sem, pdMS_TO_TICKS(timeout_ms)) !=
+	        pdTRUE) {
+		taskENTER_CRITICAL();
+		dns_request.pending = false;
+		taskEXIT_CRITICAL();
+		printf("DNS lookup for %s timed out\n", hostname);
+		net_stats_add(NET_COUNTER_TIMEOUTS, 1);
+		return false;
+	}
+
+	if (!dns_request.found) {
+		return false;
+	}
+	out_addr->addr = dns_request.addr.s_addr;
+	return true;
+}
+
+static TLS_CLIENT_T *tls_client_alloc(uint16_t server_port,
+                                      const uint8_t *cert, size_t cert_len) {
+	TLS_CLIENT_T *state = (TLS_CLIENT_T *)calloc(1, sizeof(TLS_CLIENT_T));
+	if (!state) {
+		printf("failed to allocate state\n");
+		return NULL;
+	}
+	state->complete_sem = xSemaphoreCreateBinary();
+	state->recv_sem = xSemaphoreCreateBinary();
+	state->close_sem = xSemaphoreCreateBinary();
+	if (!state->complete_sem || !state->recv_sem || !state->close_sem) {
+		printf("failed to create semaphores\n");
+		if (state->complete_sem)
+			vSemaphoreDelete(state->complete_sem);
+		if (state->recv_sem)
+			vSemaphoreDelete(state->recv_sem);
+		if (state->close_sem)
+			vSemaphoreDelete(state->close_sem);
+		free(state);
+		return NULL;
+	}
+	state->fd = -1;
+	state->addr.sin_family = AF_INET;
+	state->addr.sin_port = htons(server_port);
+	state->cert = cert;
+	state->cert_len = cert_len;
+	return state;
+}
+
+TLS_CLIENT_HANDLE tls_client_connect_addr(const ip_addr_t *server_addr,
+                                          uint16_t server_port,
+                                          const char *sni,
+                                          const uint8_t *cert,
+                                          size_t cert_len) {
+	TLS_CLIENT_T *state = tls_client_alloc(server_port, cert, cert_len);
+	if (!state) {
+		return NULL;
+	}
+	state->addr.sin_addr.s_addr = server_addr->addr;
+	snprintf(state->sni, sizeof(state->sni), "%s",
+	         sni ? sni : TLS_CLIENT_DEFAULT_SNI);
+
+	if (!post(NET_REQUEST_OPEN, state)) {
+		tls_client_close((TLS_CLIENT_HANDLE)state);
+		return NULL;
+	}
+
+	if (xSemaphoreTake(state->complete_sem, pdMS_TO_TICKS(10000)) != pdTRUE) {
+		printf("Connection timed out\n");
+		net_stats_add(NET_COUNTER_TIMEOUTS, 1);
+		tls_client_close((TLS_CLIENT_HANDLE)state);
+		return NULL;
+	}
+	if (state->error != 0) {
+		tls_client_close((TLS_CLIENT_HANDLE)state);
+		return NULL;
+	}
+	return (TLS_CLIENT_HANDLE)state;
+}
+
+TLS_CLIENT_HANDLE tls_client_init_and_connect(const char *server_hostname,
+                                              uint16_t server_port,
+                                              const uint8_t *cert,
+                                              size_t cert_len) {
+	ip_addr_t addr;
+	if (!tls_client_resolve(server_hostname, &addr, 10000)) {
+		return NULL;
+	}
+	return tls_client_connect_addr(&addr, server_port, NULL, cert, cert_len);
+}
+
+int tls_client_send_and_recv(TLS_CLIENT_HANDLE handle,
+                             const uint8_t *send_buffer, size_t send_len,
+                             uint8_t *recv_buffer, size_t recv_buffer_size,
+                             uint32_t timeout_ms) {
+	TLS_CLIENT_T *state = (TLS_CLIENT_T *)handle;
+	if (!state || !state->is_connected) {
+		return TLS_ERROR_CONNECTION;
+	}
+
+	// Drop a wake-up left by a previous receive that gave up
+	xSemaphoreTake(state->recv_sem, 0);
+
+	bool queued = false;
+	taskENTER_CRITICAL();
+	if (state->write_len == 0 && send_len <= sizeof(state->write_buffer)) {
+		memcpy(state->write_buffer, send_buffer, send_len);
+		state->write_len = send_len;
+		state->recv_buffer = recv_buffer;
+		state->recv_buffer_size = recv_buffer_size;
+		state->recv_len = 0;
+		state->recv_wanted = true;
+		queued = true;
+	}
+	taskEXIT_CRITICAL();
+	if (!queued) {
+		printf("error writing data, send buffer full\n");
+		net_stats_add(NET_COUNTER_ERRORS, 1);
+		return TLS_ERROR_GENERIC;
+	}
+	post(NET_REQUEST_SEND, state);
+	net_stats_add(NET_COUNTER_BYTES_OUT, send_len);
+
+	if (xSemaphoreTake(state->recv_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+		taskENTER_CRITICAL();
+		state->recv_wanted = false;
+		taskEXIT_CRITICAL();
+		printf("Receive timed out\n");
+		net_stats_add(NET_COUNTER_TIMEOUTS, 1);
+		return TLS_ERROR_TIMEOUT;
+	}
+	return state->recv_len;
+}
+
+void tls_client_close(TLS_CLIENT_HANDLE handle) {
+	if (!handle)
+		return;
+
+	TLS_CLIENT_T *state = (TLS_CLIENT_T *)handle;
+	// The tcpip thread lets go of it before it is freed
+	if (post(NET_REQUEST_CLOSE, state)) {
+		xSemaphoreTake(state->close_sem, portMAX_DELAY);
+	}
+	vSemaphoreDelete(state->complete_sem);
+	vSemaphoreDelete(state->recv_sem);
+	vSemaphoreDelete(state->close_sem);
+	free(state);
+}
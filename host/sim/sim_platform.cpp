@@ -0,0 +1,444 @@
+// Pico SDK services for the firmware simulator: the clock, a running RTC
+// with its alarm, stdio on the terminal and frame dumps from the panel model
+
+#include "sim_platform.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <pthread.h>
+#include <termios.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <stdio_ext.h>
+#endif
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "hardware/rtc.h"
+#include "host_display.hpp"
+#include "pico/rand.h"
+#include "pico/stdlib.h"
+
+#define SIM_STDIN_BUFFER_SIZE 256
+#define SIM_DEFAULT_WIFI_JOIN_MS 2000
+
+static SimConfig config = {nullptr, nullptr, SIM_DEFAULT_WIFI_JOIN_MS,
+                           nullptr};
+
+const SimConfig &sim_config() { return config; }
+
+// Unset and empty both mean "not given"
+static const char *env_or_null(const char *name) {
+	const char *value = getenv(name);
+	return value && *value ? value : nullptr;
+}
+
+static void read_config() {
+	config.frames_dir = env_or_null("SIM_FRAMES_DIR");
+	config.ca_file = env_or_null("SIM_CA_FILE");
+	if (const char *join_ms = env_or_null("SIM_WIFI_JOIN_MS")) {
+		config.wifi_join_ms = strtoul(join_ms, nullptr, 10);
+	}
+	config.flash_file = env_or_null("SIM_FLASH_FILE");
+}
+
+// Time
+
+static const auto boot_time = std::chrono::steady_clock::now();
+
+uint64_t time_us_64(void) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+	           std::chrono::steady_clock::now() - boot_time)
+	    .count();
+}
+
+// A task gives up the CPU as it would on the device. Before the scheduler
+// starts, such as in the display driver's constructor, the process sleeps.
+void sleep_ms(uint32_t ms) {
+	if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+		vTaskDelay(pdMS_TO_TICKS(ms));
+		return;
+	}
+	struct timespec delay = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000};
+	nanosleep(&delay, nullptr);
+}
+
+// xorshift64, seeded from the wall clock so backoff jitter varies per run
+static uint64_t rand_state = 0x9e3779b97f4a7c15ull;
+
+uint32_t get_rand_32(void) {
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return (uint32_t)(rand_state >> 32);
+}
+
+static void seed_rand() {
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	rand_state ^= (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+	rand_state ^= (uint64_t)getpid() << 32;
+	if (rand_state == 0) {
+		rand_state = 1;
+	}
+}
+
+void panic(const char *fmt, ...) {
+	fputs("\n*** PANIC ***\n\n", stderr);
+	va_list args;
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fputs("\n", stderr);
+	abort();
+}
+
+// RTC. Kept as the offset from time_us_64 to microseconds since 1970, so it
+// runs between reads and setting it is a single store.
+
+static std::atomic<bool> rtc_is_set{false};
+static std::atomic<int64_t> rtc_offset_us{0};
+
+static datetime_t alarm_time;
+static rtc_callback_t alarm_callback = nullptr;
+static int64_t alarm_checked_s = -1;
+
+// Days since 1970-01-01 for a proleptic Gregorian date, and back
+static int64_t days_from_civil(int64_t y, int m, int d) {
+	y -= m <= 2;
+	int64_t era = (y >= 0 ? y : y - 399) / 400;
+	int64_t yoe = y - era * 400;
+	int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int64_t &y, int &m, int &d) {
+	z += 719468;
+	int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+	int64_t doe = z - era * 146097;
+	int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	int64_t mp = (5 * doy + 2) / 153;
+	d = (int)(doy - (153 * mp + 2) / 5 + 1);
+	m = (int)(mp < 10 ? mp + 3 : mp - 9);
+	y = yoe + era * 400 + (m <= 2);
+}
+
+static datetime_t datetime_from_seconds(int64_t seconds) {
+	int64_t days = seconds / 86400;
+	int64_t in_day = seconds % 86400;
+	int64_t year;
+	int month, day;
+	civil_from_days(days, year, month, day);
+	datetime_t t;
+	t.year = (int16_t)year;
+	t.month = (int8_t)month;
+	t.day = (int8_t)day;
+	t.dotw = (int8_t)((days + 4) % 7); // 1970-01-01 was a Thursday
+	t.hour = (int8_t)(in_day / 3600);
+	t.min = (int8_t)(in_day / 60 % 60);
+	t.sec = (int8_t)(in_day % 60);
+	return t;
+}
+
+static int64_t rtc_now_us() { return (int64_t)time_us_64() + rtc_offset_us; }
+
+void rtc_init(void) {}
+
+// Same range checks as the SDK. The weekday follows from the date rather
+// than being stored.
+bool rtc_set_datetime(const datetime_t *t) {
+	if (t->year < 0 || t->year > 4095 || t->month < 1 || t->month > 12 ||
+	    t->day < 1 || t->day > 31 || t->hour < 0 || t->hour > 23 ||
+	    t->min < 0 || t->min > 59 || t->sec < 0 || t->sec > 59) {
+		return false;
+	}
+	int64_t seconds = days_from_civil(t->year, t->month, t->day) * 86400 +
+	                  t->hour * 3600 + t->min * 60 + t->sec;
+	rtc_offset_us = seconds * 1000000 - (int64_t)time_us_64();
+	rtc_is_set = true;
+	sim_irq_raise();
+	return true;
+}
+
+bool rtc_get_datetime(datetime_t *t) {
+	if (!rtc_is_set) {
+		return false;
+	}
+	*t = datetime_from_seconds(rtc_now_us() / 1000000);
+	return true;
+}
+
+bool rtc_running(void) { return rtc_is_set; }
+
+static bool alarm_field_matches(int8_t want, int8_t have) {
+	return want < 0 || want == have;
+}
+
+// Checks the alarm once per RTC second, like the hardware's matcher. Fields
+// set to -1 match anything.
+static void rtc_irq() {
+	if (alarm_callback == nullptr || !rtc_is_set) {
+		return;
+	}
+	int64_t now_us = rtc_now_us();
+	int64_t now_s = now_us / 1000000;
+	if (now_s != alarm_checked_s) {
+		alarm_checked_s = now_s;
+		datetime_t now = datetime_from_seconds(now_s);
+		if ((alarm_time.year < 0 || alarm_time.year == now.year) &&
+		    alarm_field_matches(alarm_time.month, now.month) &&
+		    alarm_field_matches(alarm_time.day, now.day) &&
+		    alarm_field_matches(alarm_time.dotw, now.dotw) &&
+		    alarm_field_matches(alarm_time.hour, now.hour) &&
+		    alarm_field_matches(alarm_time.min, now.min) &&
+		    alarm_field_matches(alarm_time.sec, now.sec)) {
+			alarm_callback();
+		}
+	}
+	sim_irq_raise_at(time_us_64() + (1000000 - now_us % 1000000));
+}
+
+void rtc_set_alarm(const datetime_t *t, rtc_callback_t user_callback) {
+	static bool registered = false;
+	taskENTER_CRITICAL();
+	alarm_time = *t;
+	alarm_callback = user_callback;
+	alarm_checked_s = -1;
+	taskEXIT_CRITICAL();
+	if (!registered) {
+		registered = sim_irq_register(rtc_irq);
+	}
+	sim_irq_raise();
+}
+
+// stdio. Output goes straight to stdout. Input is read by a host thread into
+// a ring buffer, and the chars available callback runs as an interrupt.
+
+static char stdin_ring[SIM_STDIN_BUFFER_SIZE];
+static std::atomic<uint32_t> stdin_head{0}; // written by the reader thread
+static std::atomic<uint32_t> stdin_tail{0}; // written by getchar_timeout_us
+static std::atomic<bool> stdin_arrived{false};
+
+static void (*chars_available)(void *) = nullptr;
+static void *chars_available_param = nullptr;
+
+static struct termios saved_termios;
+static bool terminal_changed = false;
+
+static void restore_terminal() {
+	if (terminal_changed) {
+		tcsetattr(STDIN_FILENO, TCSANOW, &saved_termios);
+	}
+}
+
+static void exit_on_signal(int sig) {
+	restore_terminal();
+	_exit(128 + sig);
+}
+
+// Keys reach the console one at a time and unechoed, as they do over USB
+static void setup_terminal() {
+	if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &saved_termios)) {
+		return;
+	}
+	struct termios raw = saved_termios;
+	raw.c_lflag &= ~(ICANON | ECHO);
+	raw.c_cc[VMIN] = 1;
+	raw.c_cc[VTIME] = 0;
+	if (tcsetattr(STDIN_FILENO, TCSANOW, &raw)) {
+		return;
+	}
+	terminal_changed = true;
+	atexit(restore_terminal);
+	signal(SIGINT, exit_on_signal);
+	signal(SIGTERM, exit_on_signal);
+}
+
+// Drops input while the ring is full, like a UART overrun
+static void *stdin_reader(void *arg) {
+	(void)arg;
+	char c;
+	while (read(STDIN_FILENO, &c, 1) == 1) {
+		uint32_t head = stdin_head.load();
+		if (head - stdin_tail.load() < SIM_STDIN_BUFFER_SIZE) {
+			stdin_ring[head % SIM_STDIN_BUFFER_SIZE] = c;
+			stdin_head = head + 1;
+		}
+		stdin_arrived = true;
+		sim_irq_raise();
+	}
+	return nullptr;
+}
+
+static void start_stdin_reader() {
+	// The kernel's signals must only ever land on task threads
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	pthread_t thread;
+	if (pthread_create(&thread, nullptr, stdin_reader, nullptr) == 0) {
+		pthread_detach(thread);
+	} else {
+		printf("Failed to start the stdin reader\n");
+	}
+	pthread_sigmask(SIG_SETMASK, &old, nullptr);
+}
+
+static void stdio_irq() {
+	if (stdin_arrived.exchange(false) && chars_available != nullptr) {
+		chars_available(chars_available_param);
+	}
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+	uint64_t deadline = time_us_64() + timeout_us;
+	while (true) {
+		uint32_t tail = stdin_tail.load();
+		if (tail != stdin_head.load()) {
+			char c = stdin_ring[tail % SIM_STDIN_BUFFER_SIZE];
+			stdin_tail = tail + 1;
+			return (unsigned char)c;
+		}
+		if (time_us_64() >= deadline) {
+			return PICO_ERROR_TIMEOUT;
+		}
+		sleep_ms(1);
+	}
+}
+
+void stdio_set_chars_available_callback(void (*fn)(void *), void *param) {
+	taskENTER_CRITICAL();
+	chars_available = fn;
+	chars_available_param = param;
+	taskEXIT_CRITICAL();
+}
+
+// Frame dumps, numbered by panel update, with their times in frames.log so
+// they can be lined up against the trace and dlog timestamps
+static void dump_frame(const HostFrame &frame) {
+	char path[512];
+	snprintf(path, sizeof(path), "%s/frame_%05lu.ppm", config.frames_dir,
+	         (unsigned long)frame.updates);
+	uint32_t now_us = time_us_32();
+
+	vTaskSuspendAll();
+	bool written = host_display_write_ppm(frame, path);
+	snprintf(path, sizeof(path), "%s/frames.log", config.frames_dir);
+	FILE *log = fopen(path, "a");
+	if (log) {
+		fprintf(log, "%lu %lu\n", (unsigned long)frame.updates,
+		        (unsigned long)now_us);
+		fclose(log);
+	}
+	xTaskResumeAll();
+
+	if (!written) {
+		printf("Cannot write frame to %s\n", config.frames_dir);
+	}
+}
+
+bool stdio_init_all(void) {
+	read_config();
+	seed_rand();
+
+	// Unbuffered, as USB stdio is. The port switches tasks from a signal
+	// handler, so a task could be parked holding stdout's lock and hang the
+	// next one to print. Only one task runs at a time, so go without it.
+	setvbuf(stdout, nullptr, _IONBF, 0);
+#ifdef __GLIBC__
+	__fsetlocking(stdout, FSETLOCKING_BYCALLER);
+#endif
+
+	setup_terminal();
+	start_stdin_reader();
+
+	sim_irq_init();
+	sim_irq_register(stdio_irq);
+	sim_gpio_init();
+	sim_flash_init();
+
+	if (config.frames_dir) {
+		host_display_frame().on_update = dump_frame;
+		printf("Writing frames to %s\n", config.frames_dir);
+	}
+	return true;
+}
+
+// The same goes for the C library allocator, which ArduinoJson uses: the
+// build wraps it in the firmware's objects (-Wl,--wrap=malloc and so on) to
+// run with the scheduler suspended, so no task is parked inside it. Without
+// that sys_monitor's mallinfo, which locks every arena, could hang.
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size) {
+	vTaskSuspendAll();
+	void *ptr = __real_malloc(size);
+	xTaskResumeAll();
+	return ptr;
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+	vTaskSuspendAll();
+	void *ptr = __real_calloc(count, size);
+	xTaskResumeAll();
+	return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+	vTaskSuspendAll();
+	void *moved = __real_realloc(ptr, size);
+	xTaskResumeAll();
+	return moved;
+}
+
+void __wrap_free(void *ptr) {
+	vTaskSuspendAll();
+	__real_free(ptr);
+	xTaskResumeAll();
+}
+}
+
+// With heap_3 C++ new goes to malloc, as with the SDK's operators, so it
+// needs the wrapper too. heap_new.cpp covers the other heaps.
+#if FREERTOS_HEAP == 3
+void *operator new(size_t size) {
+	void *ptr = __wrap_malloc(size ? size : 1);
+	if (!ptr)
+		panic("operator new(%u) failed", (unsigned)size);
+	return ptr;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { __wrap_free(ptr); }
+void operator delete[](void *ptr) noexcept { __wrap_free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { __wrap_free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { __wrap_free(ptr); }
+#endif
+
+// The port's run time counter is process CPU time in clock ticks. It is
+// wrapped too (-Wl,--wrap=ulPortGetRunTime) with microseconds since boot,
+// the unit the CPU load figures and trace timestamps assume.
+extern "C" uint32_t __wrap_ulPortGetRunTime(void) { return time_us_32(); }
+
+// sys_monitor sizes the C heap from the gap between these RP2040 linker
+// symbols. Space them as the device's 256 KiB of SRAM would be; the usage it
+// reports against them is the host allocator's.
+extern "C" {
+__attribute__((used)) char sim_sram[256 * 1024];
+}
+
+__asm__(".globl __bss_end__\n"
+        ".set __bss_end__, sim_sram\n"
+        ".globl __StackLimit\n"
+        ".set __StackLimit, sim_sram + 262144\n");
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+// Run-time settings of the simulator, read from the environment by
+// stdio_init_all, which main calls before anything else
+struct SimConfig {
+	const char *frames_dir; // SIM_FRAMES_DIR: write each frame here as PPM
+	const char *ca_file;    // SIM_CA_FILE: trust this PEM instead of ROOT_CERT
+	uint32_t wifi_join_ms;  // SIM_WIFI_JOIN_MS: how long a join takes
+	const char *flash_file; // SIM_FLASH_FILE: keep the flash here
+};
+
+const SimConfig &sim_config();
+
+// Simulated interrupts. The FreeRTOS POSIX port only has the tick, so other
+// interrupt sources register a handler here. When one is raised, the tick
+// hook wakes a task at the top priority that calls every handler with
+// interrupts masked, where each checks its own source. Handlers may use the
+// FromISR API as real ones do.
+#define SIM_IRQ_MAX_HANDLERS 4
+
+typedef void (*SimIrqHandler)(void);
+
+// Create the interrupt task. Call before the scheduler starts.
+void sim_irq_init();
+
+bool sim_irq_register(SimIrqHandler handler);
+
+// Run the handlers at the next tick. Safe from any thread, including ones
+// the kernel doesn't know about.
+void sim_irq_raise();
+
+// Run the handlers at the first tick at or after time_us_64() == when_us.
+// The earliest pending request wins.
+void sim_irq_raise_at(uint64_t when_us);
+
+// Connect the GPIO interrupt model and its "press" console command
+void sim_gpio_init();
+
+// Load the flash from SIM_FLASH_FILE, or start it erased
+void sim_flash_init();
+
+// Start the simulated network stack's tcpip thread
+bool sim_net_init();
@@ -0,0 +1,51 @@
+#include "sleep_stats.h"
+
+#include <pthread.h>
+#include <signal.h>
+
+#include "FreeRTOS.h"
+#include "pico/stdlib.h"
+
+// The simulator's sleep_stats: the same counters, with the idle task's
+// thread blocked in sigwait instead of a core waiting for an interrupt. The
+// only interrupt the POSIX port has is its SIGALRM tick, which also carries
+// the simulated ones.
+
+static volatile uint32_t sleep_since_us[SLEEP_STATS_MAX_CORES];
+static volatile uint32_t sleep_total_us[SLEEP_STATS_MAX_CORES];
+static volatile uint32_t wakeup_count[SLEEP_STATS_MAX_CORES];
+
+void sleep_stats_pre_sleep(void) {
+	sleep_since_us[portGET_CORE_ID()] = time_us_32();
+}
+
+void sleep_stats_post_sleep(void) {
+	uint32_t core = portGET_CORE_ID();
+	sleep_total_us[core] += time_us_32() - sleep_since_us[core];
+	wakeup_count[core]++;
+}
+
+void sleep_stats_idle(void) {
+	sigset_t tick;
+	sigemptyset(&tick);
+	sigaddset(&tick, SIGALRM);
+	int sig;
+
+	// With the tick masked it stays pending until sigwait takes it, so it
+	// can't slip in between the timestamps and the wait
+	portDISABLE_INTERRUPTS();
+	sleep_stats_pre_sleep();
+	sigwait(&tick, &sig);
+	sleep_stats_post_sleep();
+	// sigwait consumed the tick; pend it again for the port's handler
+	pthread_kill(pthread_self(), SIGALRM);
+	portENABLE_INTERRUPTS();
+}
+
+void sleep_stats_snapshot(SleepStatsSnapshot *snapshot) {
+	snapshot->time_us = time_us_32();
+	for (int i = 0; i < SLEEP_STATS_MAX_CORES; i++) {
+		snapshot->sleep_us[i] = sleep_total_us[i];
+		snapshot->wakeups[i] = wakeup_count[i];
+	}
+}
@@ -0,0 +1,195 @@
+// The Wi-Fi chip and wifi_supervisor for the simulator. There is no radio:
+// traffic uses the host's network and a join just takes SIM_WIFI_JOIN_MS.
+// The supervisor keeps the firmware's event group, events and task, so
+// whoever waits on it behaves as on the device, and the "wifi" console
+// command drops and restores the link to exercise them.
+
+#include "wifi_supervisor.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include "pico/cyw43_arch.h"
+#include "task.h"
+
+#include "console.hpp"
+#include "dlog.h"
+#include "sim_platform.hpp"
+#include "task_registry.hpp"
+#include "trace_buffer.h"
+
+#define WIFI_SUPERVISOR_TASK_PRIORITY (tskIDLE_PRIORITY + 3UL)
+#define WIFI_SUPERVISOR_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+
+static EventGroupHandle_t wifi_events = NULL;
+static TaskHandle_t supervisor_task_handle = NULL;
+
+static WifiEventHandler subscribers[WIFI_SUPERVISOR_MAX_SUBSCRIBERS];
+static volatile size_t num_subscribers = 0;
+
+// Set from the console
+static std::atomic<bool> link_enabled{true};
+
+// Only touched by the supervisor task, apart from the status report
+static bool joining = false;
+static TickType_t join_started = 0;
+static uint32_t link_drops = 0;
+static uint32_t joins = 0;
+
+static bool led_on = false;
+
+int cyw43_arch_init(void) { return sim_net_init() ? 0 : -1; }
+
+void cyw43_arch_deinit(void) {}
+
+void cyw43_arch_gpio_put(uint wl_gpio, bool value) {
+	if (wl_gpio == CYW43_WL_GPIO_LED_PIN) {
+		led_on = value;
+	}
+}
+
+static void publish(WifiEvent event) {
+	for (size_t i = 0; i < num_subscribers; i++) {
+		subscribers[i](event);
+	}
+}
+
+static void start_join() {
+	joins++;
+	joining = true;
+	join_started = xTaskGetTickCount();
+}
+
+static void update_state() {
+	EventBits_t bits = xEventGroupGetBits(wifi_events);
+
+	if (!link_enabled) {
+		joining = false;
+		if (bits & WIFI_BIT_CONNECTED) {
+			xEventGroupClearBits(wifi_events, WIFI_BIT_CONNECTED);
+			DLOG_WARN("Wi-Fi address lost\n");
+			publish(WIFI_EVENT_IP_LOST);
+		}
+		if (bits & WIFI_BIT_LINK_UP) {
+			xEventGroupClearBits(wifi_events, WIFI_BIT_LINK_UP);
+			link_drops++;
+			DLOG_WARN("Wi-Fi link down, rejoining\n");
+			publish(WIFI_EVENT_LINK_DOWN);
+		}
+		return;
+	}
+
+	if (bits & WIFI_BIT_LINK_UP) {
+		return;
+	}
+	if (!joining) {
+		start_join();
+	}
+	if (xTaskGetTickCount() - join_started >=
+	    pdMS_TO_TICKS(sim_config().wifi_join_ms)) {
+		joining = false;
+		xEventGroupSetBits(wifi_events, WIFI_BIT_LINK_UP);
+		DLOG_INFO("Wi-Fi link up\n");
+		publish(WIFI_EVENT_LINK_UP);
+		xEventGroupSetBits(wifi_events, WIFI_BIT_CONNECTED);
+		DLOG_INFO("Wi-Fi connected, IP 127.0.0.1\n");
+		publish(WIFI_EVENT_IP_BOUND);
+	}
+}
+
+static void supervisor_task(__unused void *params) {
+	supervisor_task_handle = xTaskGetCurrentTaskHandle();
+
+	while (true) {
+		update_state();
+
+		TickType_t wait = portMAX_DELAY;
+		if (joining) {
+			TickType_t join_ticks = pdMS_TO_TICKS(sim_config().wifi_join_ms);
+			TickType_t elapsed = xTaskGetTickCount() - join_started;
+			wait = elapsed < join_ticks ? join_ticks - elapsed : 0;
+		}
+		ulTaskNotifyTake(pdTRUE, wait);
+	}
+}
+
+// Console command: show the link, or take it down and up
+static void cmd_wifi(int argc, char **argv) {
+	if (argc < 2) {
+		wifi_supervisor_print_status();
+		return;
+	}
+	if (strcmp(argv[1], "up") == 0) {
+		link_enabled = true;
+	} else if (strcmp(argv[1], "down") == 0) {
+		link_enabled = false;
+	} else {
+		printf("usage: wifi [up|down]\n");
+		return;
+	}
+	if (supervisor_task_handle != NULL) {
+		xTaskNotifyGive(supervisor_task_handle);
+	}
+}
+
+void wifi_supervisor_init(const char *ssid, const char *password,
+                          UBaseType_t core_mask) {
+	(void)password;
+	printf("Simulating Wi-Fi network %s\n", ssid);
+
+	wifi_events = xEventGroupCreate();
+	if (wifi_events == NULL) {
+		printf("Failed to create Wi-Fi event group\n");
+		return;
+	}
+	trace_buffer_name_object(wifi_events, "wifi_events");
+	console_register("wifi", "Wi-Fi link: wifi [up|down]", cmd_wifi);
+
+	task_registry_create(supervisor_task, "WiFiThread",
+	                     WIFI_SUPERVISOR_TASK_STACK_SIZE,
+	                     WIFI_SUPERVISOR_TASK_PRIORITY, core_mask,
+	                     &supervisor_task_handle);
+}
+
+bool wifi_supervisor_subscribe(WifiEventHandler handler) {
+	bool added = false;
+	taskENTER_CRITICAL();
+	if (num_subscribers < WIFI_SUPERVISOR_MAX_SUBSCRIBERS) {
+		subscribers[num_subscribers] = handler;
+		num_subscribers = num_subscribers + 1;
+		added = true;
+	}
+	taskEXIT_CRITICAL();
+
+	if (!added) {
+		printf("Wi-Fi subscriber table full\n");
+	}
+	return added;
+}
+
+bool wifi_supervisor_wait_connected(TickType_t timeout) {
+	if (wifi_events == NULL) {
+		return false;
+	}
+	EventBits_t bits = xEventGroupWaitBits(wifi_events, WIFI_BIT_CONNECTED,
+	                                       pdFALSE, pdTRUE, timeout);
+	return bits & WIFI_BIT_CONNECTED;
+}
+
+bool wifi_supervisor_connected() {
+	return wifi_events != NULL &&
+	       (xEventGroupGetBits(wifi_events) & WIFI_BIT_CONNECTED);
+}
+
+void wifi_supervisor_print_status() {
+	EventBits_t bits = wifi_events ? xEventGroupGetBits(wifi_events) : 0;
+	if (bits & WIFI_BIT_CONNECTED) {
+		printf("Wi-Fi: connected, IP 127.0.0.1 (simulated)\n");
+	} else {
+		printf("Wi-Fi: %s (simulated)\n",
+		       link_enabled ? "joining" : "link down");
+	}
+	printf("  %lu joins, %lu link drops, LED %s\n", (unsigned long)joins,
+	       (unsigned long)link_drops, led_on ? "on" : "off");
+}
@@ -0,0 +1,8 @@
+#ifndef SIM_CYW43_H
+#define SIM_CYW43_H
+
+// Nothing from the driver itself is used outside pico/cyw43_arch.h
+
+#include "pico/cyw43_arch.h"
+
+#endif // SIM_CYW43_H
@@ -0,0 +1,8 @@
+#ifndef SIM_LWIP_ALTCP_TLS_H
+#define SIM_LWIP_ALTCP_TLS_H
+
+// TLS goes through the simulator's tls_client.h implementation instead
+
+#include "lwip/ip_addr.h"
+
+#endif // SIM_LWIP_ALTCP_TLS_H
@@ -0,0 +1,26 @@
+#ifndef SIM_LWIP_IP_ADDR_H
+#define SIM_LWIP_IP_ADDR_H
+
+#include <stdint.h>
+
+#include "lwip/opt.h"
+
+// IPv4 only, in network byte order as lwIP keeps it
+typedef struct {
+	uint32_t addr;
+} ip_addr_t;
+
+#define ip_addr_copy(dest, src) ((dest).addr = (src).addr)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Dotted form in a static buffer, overwritten by the next call
+char *ipaddr_ntoa(const ip_addr_t *addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_LWIP_IP_ADDR_H
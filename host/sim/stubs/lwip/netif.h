@@ -0,0 +1,8 @@
+#ifndef SIM_LWIP_NETIF_H
+#define SIM_LWIP_NETIF_H
+
+// The simulator has no netif: link state comes from its wifi_supervisor
+
+#include "lwip/ip_addr.h"
+
+#endif // SIM_LWIP_NETIF_H
@@ -0,0 +1,18 @@
+#ifndef SIM_LWIP_OPT_H
+#define SIM_LWIP_OPT_H
+
+// The firmware's lwIP options, for the tcpip thread's name and stack size
+
+#ifndef NO_SYS
+#define NO_SYS 0
+#endif
+#include "lwipopts.h"
+
+#ifndef TCPIP_THREAD_NAME
+#define TCPIP_THREAD_NAME "tcpip_thread"
+#endif
+#ifndef TCPIP_THREAD_PRIO
+#define TCPIP_THREAD_PRIO 1
+#endif
+
+#endif // SIM_LWIP_OPT_H
@@ -0,0 +1,23 @@
+#ifndef SIM_PICO_CYW43_ARCH_H
+#define SIM_PICO_CYW43_ARCH_H
+
+#include "pico/stdlib.h"
+
+#define CYW43_WL_GPIO_LED_PIN 0
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Starts the simulated network stack's tcpip thread, as the real call starts
+// lwIP's. The Wi-Fi side lives in the simulator's wifi_supervisor.
+int cyw43_arch_init(void);
+void cyw43_arch_deinit(void);
+
+void cyw43_arch_gpio_put(uint wl_gpio, bool value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_PICO_CYW43_ARCH_H
@@ -0,0 +1,23 @@
+#ifndef SIM_PICO_FLASH_H
+#define SIM_PICO_FLASH_H
+
+// On the device this parks the other core and masks interrupts around func.
+// The simulator only has to keep other tasks out.
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define PICO_OK 0
+
+static inline int flash_safe_execute(void (*func)(void *), void *param,
+                                     uint32_t enter_exit_timeout_ms) {
+	(void)enter_exit_timeout_ms;
+	taskENTER_CRITICAL();
+	func(param);
+	taskEXIT_CRITICAL();
+	return PICO_OK;
+}
+
+#endif // SIM_PICO_FLASH_H
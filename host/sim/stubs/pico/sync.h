@@ -0,0 +1,26 @@
+#ifndef SIM_PICO_SYNC_H
+#define SIM_PICO_SYNC_H
+
+// In the simulator tasks preempt each other, so critical sections are the
+// kernel's
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef struct {
+	int unused;
+} critical_section_t;
+
+static inline void critical_section_init(critical_section_t *crit) {
+	(void)crit;
+}
+static inline void critical_section_enter_blocking(critical_section_t *crit) {
+	(void)crit;
+	taskENTER_CRITICAL();
+}
+static inline void critical_section_exit(critical_section_t *crit) {
+	(void)crit;
+	taskEXIT_CRITICAL();
+}
+
+#endif // SIM_PICO_SYNC_H
@@ -0,0 +1,76 @@
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+// One channel whose transfers complete as soon as they are triggered: the
+// bytes go to the panel model, as if written to the SPI data register
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16, DMA_SIZE_32 };
+
+typedef struct {
+	uint32_t ctrl;
+} dma_channel_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr,
+                               bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t count, bool trigger);
+
+static inline int dma_claim_unused_channel(bool required) {
+	(void)required;
+	return 0;
+}
+static inline dma_channel_config dma_channel_get_default_config(uint channel) {
+	(void)channel;
+	dma_channel_config c = {0};
+	return c;
+}
+static inline void
+channel_config_set_transfer_data_size(dma_channel_config *c,
+                                      enum dma_channel_transfer_size size) {
+	(void)c;
+	(void)size;
+}
+static inline void channel_config_set_bswap(dma_channel_config *c, bool bswap) {
+	(void)c;
+	(void)bswap;
+}
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+	(void)c;
+	(void)dreq;
+}
+static inline void dma_channel_configure(uint channel,
+                                         const dma_channel_config *config,
+                                         volatile void *write_addr,
+                                         const volatile void *read_addr,
+                                         uint transfer_count, bool trigger) {
+	(void)channel;
+	(void)config;
+	(void)write_addr;
+	(void)read_addr;
+	(void)transfer_count;
+	(void)trigger;
+}
+static inline bool dma_channel_is_busy(uint channel) {
+	(void)channel;
+	return false;
+}
+static inline void dma_channel_wait_for_finish_blocking(uint channel) {
+	(void)channel;
+}
+static inline bool dma_channel_is_claimed(uint channel) {
+	(void)channel;
+	return true;
+}
+static inline void dma_channel_abort(uint channel) { (void)channel; }
+static inline void dma_channel_unclaim(uint channel) { (void)channel; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_DMA_H
@@ -0,0 +1,61 @@
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include "pico/stdlib.h"
+
+enum gpio_function {
+	GPIO_FUNC_SPI = 1,
+	GPIO_FUNC_PWM = 4,
+	GPIO_FUNC_SIO = 5,
+	GPIO_FUNC_PIO0 = 6,
+	GPIO_FUNC_PIO1 = 7,
+	GPIO_FUNC_NULL = 0x1f,
+};
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+enum gpio_irq_level {
+	GPIO_IRQ_LEVEL_LOW = 0x1u,
+	GPIO_IRQ_LEVEL_HIGH = 0x2u,
+	GPIO_IRQ_EDGE_FALL = 0x4u,
+	GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fed to the panel model, which follows the display's CS and DC lines
+void gpio_put(uint gpio, bool value);
+
+static inline void gpio_set_function(uint gpio, enum gpio_function fn) {
+	(void)gpio;
+	(void)fn;
+}
+static inline void gpio_set_dir(uint gpio, bool out) {
+	(void)gpio;
+	(void)out;
+}
+static inline void gpio_pull_up(uint gpio) { (void)gpio; }
+static inline void gpio_pull_down(uint gpio) { (void)gpio; }
+
+// Inputs read high, as the buttons' pull-ups leave them, unless set
+// otherwise with host_gpio_set_input
+bool gpio_get(uint gpio);
+void host_gpio_set_input(uint gpio, bool value);
+
+// Edge interrupts are only provided by the simulator
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask,
+                                        bool enabled,
+                                        gpio_irq_callback_t callback);
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled);
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_GPIO_H
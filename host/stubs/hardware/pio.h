@@ -0,0 +1,84 @@
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+// The Pico Display uses SPI, so the parallel bus setup is only declared.
+// The state machine queries the driver makes on every path report an idle,
+// unclaimed state machine.
+
+typedef struct {
+	volatile uint32_t txf[4];
+} pio_hw_t;
+typedef pio_hw_t *PIO;
+
+typedef struct {
+	uint32_t clkdiv;
+	uint32_t execctrl;
+	uint32_t shiftctrl;
+	uint32_t pinctrl;
+} pio_sm_config;
+
+typedef struct {
+	const uint16_t *instructions;
+	uint8_t length;
+	int8_t origin;
+} pio_program_t;
+
+enum pio_fifo_join {
+	PIO_FIFO_JOIN_NONE = 0,
+	PIO_FIFO_JOIN_TX,
+	PIO_FIFO_JOIN_RX
+};
+
+extern pio_hw_t host_pio1;
+#define pio1 (&host_pio1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int pio_set_gpio_base(PIO pio, uint gpio_base);
+int pio_claim_unused_sm(PIO pio, bool required);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_gpio_init(PIO pio, uint pin);
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base,
+                                   uint pin_count, bool is_out);
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count);
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base);
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join);
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right,
+                             bool autopull, uint pull_threshold);
+void sm_config_set_clkdiv(pio_sm_config *c, float div);
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *c);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+
+static inline void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+	(void)pio;
+	(void)sm;
+	(void)enabled;
+}
+static inline bool pio_sm_is_claimed(PIO pio, uint sm) {
+	(void)pio;
+	(void)sm;
+	return false;
+}
+static inline void pio_sm_drain_tx_fifo(PIO pio, uint sm) {
+	(void)pio;
+	(void)sm;
+}
+static inline void pio_sm_unclaim(PIO pio, uint sm) {
+	(void)pio;
+	(void)sm;
+}
+static inline bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) {
+	(void)pio;
+	(void)sm;
+	return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_PIO_H
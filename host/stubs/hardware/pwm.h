@@ -0,0 +1,41 @@
+#ifndef HOST_HARDWARE_PWM_H
+#define HOST_HARDWARE_PWM_H
+
+#include "pico/stdlib.h"
+
+typedef struct {
+	uint32_t csr;
+	uint32_t div;
+	uint32_t top;
+} pwm_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Records the backlight level in the host frame
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+
+static inline pwm_config pwm_get_default_config(void) {
+	pwm_config c = {0, 0, 0xffff};
+	return c;
+}
+static inline void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) {
+	c->top = wrap;
+}
+static inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1) & 7; }
+static inline void pwm_set_wrap(uint slice, uint16_t wrap) {
+	(void)slice;
+	(void)wrap;
+}
+static inline void pwm_init(uint slice, pwm_config *c, bool start) {
+	(void)slice;
+	(void)c;
+	(void)start;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_PWM_H
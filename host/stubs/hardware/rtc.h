@@ -0,0 +1,28 @@
+#ifndef HOST_HARDWARE_RTC_H
+#define HOST_HARDWARE_RTC_H
+
+#include <stdbool.h>
+
+#include "pico/util/datetime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*rtc_callback_t)(void);
+
+// The render tools hold the clock still so frames are reproducible; the
+// simulator's runs
+void rtc_init(void);
+bool rtc_set_datetime(const datetime_t *t);
+bool rtc_get_datetime(datetime_t *t);
+bool rtc_running(void);
+
+// Only provided by the simulator
+void rtc_set_alarm(const datetime_t *t, rtc_callback_t user_callback);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_RTC_H
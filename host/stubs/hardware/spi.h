@@ -0,0 +1,39 @@
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+#include "pico/stdlib.h"
+
+typedef struct {
+	volatile uint32_t dr;
+} spi_hw_t;
+
+typedef struct spi_inst spi_inst_t;
+
+#define spi0 ((spi_inst_t *)1)
+#define spi1 ((spi_inst_t *)2)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline uint spi_init(spi_inst_t *spi, uint baudrate) {
+	(void)spi;
+	return baudrate;
+}
+
+// Bytes go straight to the panel model
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+
+spi_hw_t *spi_get_hw(spi_inst_t *spi);
+
+static inline uint spi_get_dreq(spi_inst_t *spi, bool is_tx) {
+	(void)spi;
+	(void)is_tx;
+	return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HARDWARE_SPI_H
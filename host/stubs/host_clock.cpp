@@ -0,0 +1,46 @@
+// Time, RTC and random numbers for the render tools. The RTC holds still and
+// the random numbers repeat, so every run draws the same frames.
+
+#include <chrono>
+
+#include "hardware/rtc.h"
+#include "pico/rand.h"
+#include "pico/stdlib.h"
+
+static const auto boot_time = std::chrono::steady_clock::now();
+
+uint64_t time_us_64(void) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+	           std::chrono::steady_clock::now() - boot_time)
+	    .count();
+}
+
+// Nothing on the host needs settling time, such as the panel's reset
+void sleep_ms(uint32_t ms) { (void)ms; }
+
+// xorshift32 from a fixed seed
+uint32_t get_rand_32(void) {
+	static uint32_t state = 0x2545f491;
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static datetime_t rtc_time = {2024, 1, 2, 2, 10, 30, 0};
+static bool rtc_set = false;
+
+void rtc_init(void) {}
+
+bool rtc_set_datetime(const datetime_t *t) {
+	rtc_time = *t;
+	rtc_set = true;
+	return true;
+}
+
+bool rtc_get_datetime(datetime_t *t) {
+	*t = rtc_time;
+	return true;
+}
+
+bool rtc_running(void) { return rtc_set; }
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Largest RAMWR the model keeps: one full 320x240 frame
+#define HOST_FRAME_MAX_BYTES (320 * 240 * 2)
+
+// What the panel model has received from the real ST7789 driver: the window
+// from CASET/RASET and the pixel bytes of the last RAMWR, in wire order
+// (big-endian RGB565). Held in place rather than allocated, so the model
+// stays out of the simulator's heap statistics.
+struct HostFrame {
+	uint16_t width = 0;
+	uint16_t height = 0;
+	uint8_t rgb565[HOST_FRAME_MAX_BYTES];
+	size_t rgb565_len = 0;
+	uint32_t updates = 0;
+	uint16_t backlight_level = 0; // PWM level, 0-65535
+	// Called from the drawing task each time a RAMWR completes
+	void (*on_update)(const HostFrame &frame) = nullptr;
+};
+
+HostFrame &host_display_frame();
+
+// Write the frame as a binary PPM. Returns false if the file can't be written.
+bool host_display_write_ppm(const HostFrame &frame, const char *path);
@@ -0,0 +1,158 @@
+// Display hardware behind the host stubs: a model of the ST7789 panel that
+// decodes the command stream the real driver sends, and the button inputs
+
+#include <cstdio>
+#include <cstring>
+
+#include "common/pimoroni_bus.hpp"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "hardware/spi.h"
+#include "host_display.hpp"
+
+// Pico Display Pack pins in the front Breakout Garden slot
+namespace pimoroni {
+SPIPins get_spi_pins(BG_SPI_SLOT slot) {
+	(void)slot;
+	return {PIMORONI_SPI_DEFAULT_INSTANCE, SPI_BG_FRONT_CS, SPI_DEFAULT_SCK,
+	        SPI_DEFAULT_MOSI, PIN_UNUSED, SPI_DEFAULT_DC, SPI_BG_FRONT_PWM};
+}
+} // namespace pimoroni
+
+HostFrame &host_display_frame() {
+	static HostFrame frame;
+	return frame;
+}
+
+// Panel model. DC low marks a command byte, DC high its parameters; CS
+// rising ends the transaction.
+enum PanelCommand : uint8_t {
+	PANEL_CASET = 0x2a,
+	PANEL_RASET = 0x2b,
+	PANEL_RAMWR = 0x2c,
+};
+
+static bool panel_dc = false;
+static uint8_t panel_command = 0;
+static uint8_t panel_params[4];
+static size_t panel_param_count = 0;
+
+// Window size from a CASET/RASET start and end pair
+static uint16_t panel_window_size() {
+	uint16_t start = panel_params[0] << 8 | panel_params[1];
+	uint16_t end = panel_params[2] << 8 | panel_params[3];
+	return end >= start ? end - start + 1 : 0;
+}
+
+static void panel_write(const uint8_t *src, size_t len) {
+	HostFrame &frame = host_display_frame();
+	if (!panel_dc) {
+		for (size_t i = 0; i < len; i++) {
+			panel_command = src[i];
+			panel_param_count = 0;
+			if (panel_command == PANEL_RAMWR) {
+				frame.rgb565_len = 0;
+			}
+		}
+		return;
+	}
+
+	if (panel_command == PANEL_RAMWR) {
+		size_t room = sizeof(frame.rgb565) - frame.rgb565_len;
+		size_t n = len < room ? len : room;
+		memcpy(frame.rgb565 + frame.rgb565_len, src, n);
+		frame.rgb565_len += n;
+		return;
+	}
+	for (size_t i = 0; i < len && panel_param_count < 4; i++) {
+		panel_params[panel_param_count++] = src[i];
+	}
+	if (panel_param_count == 4 && panel_command == PANEL_CASET) {
+		frame.width = panel_window_size();
+	} else if (panel_param_count == 4 && panel_command == PANEL_RASET) {
+		frame.height = panel_window_size();
+	}
+}
+
+void gpio_put(uint gpio, bool value) {
+	if (gpio == pimoroni::SPI_DEFAULT_DC) {
+		panel_dc = value;
+	} else if (gpio == pimoroni::SPI_BG_FRONT_CS && value &&
+	           panel_command == PANEL_RAMWR) {
+		HostFrame &frame = host_display_frame();
+		frame.updates++;
+		if (frame.on_update) {
+			frame.on_update(frame);
+		}
+	}
+}
+
+// Input levels, high until pulled low
+static uint32_t gpio_low_inputs = 0;
+
+bool gpio_get(uint gpio) { return !(gpio_low_inputs & (1u << gpio)); }
+
+void host_gpio_set_input(uint gpio, bool value) {
+	if (value) {
+		gpio_low_inputs &= ~(1u << gpio);
+	} else {
+		gpio_low_inputs |= 1u << gpio;
+	}
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+	(void)spi;
+	panel_write(src, len);
+	return (int)len;
+}
+
+spi_hw_t *spi_get_hw(spi_inst_t *spi) {
+	(void)spi;
+	static spi_hw_t hw;
+	return &hw;
+}
+
+// The driver sets the count, then triggers by setting the read address
+static uint32_t dma_count = 0;
+
+void dma_channel_set_trans_count(uint channel, uint32_t count, bool trigger) {
+	(void)channel;
+	(void)trigger;
+	dma_count = count;
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr,
+                               bool trigger) {
+	(void)channel;
+	if (trigger) {
+		panel_write((const uint8_t *)read_addr, dma_count);
+	}
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+	if (gpio == pimoroni::SPI_BG_FRONT_PWM) {
+		host_display_frame().backlight_level = level;
+	}
+}
+
+pio_hw_t host_pio1;
+
+bool host_display_write_ppm(const HostFrame &frame, const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		printf("Cannot write %s\n", path);
+		return false;
+	}
+	fprintf(file, "P6\n%u %u\n255\n", frame.width, frame.height);
+	for (size_t i = 0; i + 1 < frame.rgb565_len; i += 2) {
+		uint16_t p = (frame.rgb565[i] << 8) | frame.rgb565[i + 1];
+		// Widen each channel, replicating its top bits into the gap
+		uint8_t r = (p >> 11) & 0x1f, g = (p >> 5) & 0x3f, b = p & 0x1f;
+		uint8_t rgb[3] = {(uint8_t)(r << 3 | r >> 2), (uint8_t)(g << 2 | g >> 4),
+		                  (uint8_t)(b << 3 | b >> 2)};
+		fwrite(rgb, 1, sizeof(rgb), file);
+	}
+	return fclose(file) == 0;
+}
@@ -0,0 +1,17 @@
+#ifndef HOST_PICO_RAND_H
+#define HOST_PICO_RAND_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Deterministic in the render tools, so fixtures render the same every run
+uint32_t get_rand_32(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_PICO_RAND_H
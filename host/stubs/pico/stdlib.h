@@ -0,0 +1,48 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// Host stand-in for the Pico SDK's stdlib: the types and timing calls the
+// rendering code uses, backed by the host's monotonic clock
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define PICO_ERROR_TIMEOUT -1
+
+#ifndef __unused
+#define __unused __attribute__((unused))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t time_us_64(void);
+
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+	return (uint32_t)(t / 1000);
+}
+
+void sleep_ms(uint32_t ms);
+
+// stdio and panic are only provided by the simulator
+bool stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+void stdio_set_chars_available_callback(void (*fn)(void *), void *param);
+void panic(const char *fmt, ...) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
+
+// The SDK's stdlib brings in GPIO too, and the drivers rely on that
+#include "hardware/gpio.h"
+
+#endif // HOST_PICO_STDLIB_H
@@ -0,0 +1,21 @@
+#ifndef HOST_PICO_SYNC_H
+#define HOST_PICO_SYNC_H
+
+// The render tools are single threaded, so critical sections do nothing. The
+// simulator has its own.
+
+typedef struct {
+	int unused;
+} critical_section_t;
+
+static inline void critical_section_init(critical_section_t *crit) {
+	(void)crit;
+}
+static inline void critical_section_enter_blocking(critical_section_t *crit) {
+	(void)crit;
+}
+static inline void critical_section_exit(critical_section_t *crit) {
+	(void)crit;
+}
+
+#endif // HOST_PICO_SYNC_H
@@ -0,0 +1,20 @@
+#ifndef HOST_ST7789_PARALLEL_PIO_H
+#define HOST_ST7789_PARALLEL_PIO_H
+
+// Normally generated by pioasm; only the parallel bus uses it
+
+#include "hardware/pio.h"
+
+extern const pio_program_t st7789_parallel_program;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+pio_sm_config st7789_parallel_program_get_default_config(uint offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ST7789_PARALLEL_PIO_H
@@ -0,0 +1,91 @@
+// Check the boot timeline on a clock the test sets: only the first mark of
+// each milestone counts, milestones can arrive in any order, and when both
+// cores race to mark the same milestones exactly one wins each.
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "boot_timeline.hpp"
+#include "console.hpp"
+#include "pico/stdlib.h"
+
+static std::atomic<uint64_t> clock_us{0};
+uint64_t time_us_64(void) { return clock_us.load(); }
+
+bool console_register(const char *name, const char *help,
+                      void (*handler)(int argc, char **argv)) {
+	(void)name;
+	(void)help;
+	(void)handler;
+	return true;
+}
+
+static int failures = 0;
+
+static void expect(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+int main() {
+	boot_timeline_init();
+
+	// Before anything is marked, and a mark at time 0 still reads as set
+	expect(boot_timeline_ms(BOOT_MARK_TASKS_STARTED) == 0,
+	       "set before marking");
+	expect(boot_timeline_mark(BOOT_MARK_TASKS_STARTED), "first mark refused");
+	expect(boot_timeline_ms(BOOT_MARK_TASKS_STARTED) == 1,
+	       "mark at reset reads as unset");
+
+	// The Wi-Fi chip comes up after the display, as it can with both
+	// started in parallel
+	clock_us = 300 * 1000;
+	expect(boot_timeline_mark(BOOT_MARK_DISPLAY), "display mark refused");
+	clock_us = 600 * 1000;
+	expect(boot_timeline_mark(BOOT_MARK_WIFI_CHIP), "Wi-Fi mark refused");
+	expect(boot_timeline_ms(BOOT_MARK_DISPLAY) == 300, "wrong display time");
+	expect(boot_timeline_ms(BOOT_MARK_WIFI_CHIP) == 600, "wrong Wi-Fi time");
+
+	// Only the first frame counts as the first pixel
+	clock_us = 650 * 1000;
+	expect(boot_timeline_mark(BOOT_MARK_FIRST_PIXEL), "first pixel refused");
+	clock_us = 700 * 1000;
+	expect(!boot_timeline_mark(BOOT_MARK_FIRST_PIXEL), "second mark counted");
+	expect(boot_timeline_ms(BOOT_MARK_FIRST_PIXEL) == 650,
+	       "second mark moved the time");
+
+	// Both cores mark the network milestones at once. Marks can't be
+	// cleared, so this race is run once.
+	clock_us = 4000 * 1000;
+	const BootMark raced[] = {BOOT_MARK_LINK_UP, BOOT_MARK_IP_BOUND,
+	                          BOOT_MARK_FIRST_FETCH, BOOT_MARK_FIRST_LIVE};
+	std::atomic<bool> go{false};
+	int wins[2] = {0, 0};
+	auto mark_all = [&](int core) {
+		while (!go.load()) {
+		}
+		for (BootMark mark : raced) {
+			wins[core] += boot_timeline_mark(mark);
+		}
+	};
+	std::thread other(mark_all, 1);
+	go = true;
+	mark_all(0);
+	other.join();
+	expect(wins[0] + wins[1] == 4, "a raced mark counted twice or never");
+	for (BootMark mark : raced) {
+		expect(boot_timeline_ms(mark) == 4000, "wrong raced time");
+	}
+
+	expect(boot_timeline_ms(BOOT_MARK_CACHE) == 0, "unmarked milestone set");
+	boot_timeline_print();
+
+	if (failures) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,85 @@
+// Log records whose %s and %p arguments are pointers above 4 GiB, as any
+// heap or stack pointer is on a 64-bit host, from C++ and C, and check the
+// drained lines. Each argument must survive the ring whole.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "dlog.h"
+#include "pico/stdlib.h"
+#include "task.h"
+
+extern "C" void test_dlog_from_c(const char *text, const void *pointer,
+                                 int number, float value);
+
+uint64_t time_us_64(void) { return 2500000; }
+
+// dlog_init() isn't called, so the drain task is never created
+extern "C" {
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name,
+                       const configSTACK_DEPTH_TYPE stack_depth,
+                       void *parameters, UBaseType_t priority,
+                       TaskHandle_t *created) {
+	(void)code;
+	(void)name;
+	(void)stack_depth;
+	(void)parameters;
+	(void)priority;
+	(void)created;
+	return pdFAIL;
+}
+void vTaskDelay(const TickType_t ticks) { (void)ticks; }
+}
+
+// Run dlog_flush() with stdout sent to a file, and return what it printed
+static std::string flush_to_string() {
+	fflush(stdout);
+	FILE *capture = tmpfile();
+	int saved = dup(fileno(stdout));
+	dup2(fileno(capture), fileno(stdout));
+	dlog_flush();
+	fflush(stdout);
+	dup2(saved, fileno(stdout));
+	close(saved);
+
+	std::string text;
+	char buffer[256];
+	rewind(capture);
+	size_t got;
+	while ((got = fread(buffer, 1, sizeof(buffer), capture)) > 0) {
+		text.append(buffer, got);
+	}
+	fclose(capture);
+	return text;
+}
+
+int main() {
+	char *market = (char *)malloc(16);
+	strcpy(market, "closed");
+	static const char power[] = "low";
+	void *pointer = (void *)(uintptr_t)0x7ffd12345678ull;
+
+	DLOG_INFO("Market %s, %s power\n", market, power);
+	DLOG_ERROR("at %p, %d %u %x %.1f\n", pointer, -5, 7u, 255, 1.5f);
+	test_dlog_from_c(market, pointer, -12, 0.25f);
+
+	char pointer_text[32];
+	snprintf(pointer_text, sizeof(pointer_text), "%p", pointer);
+	std::string expected = std::string("I 2.500 Market closed, low power\n") +
+	                       "E 2.500 at " + pointer_text +
+	                       ", -5 7 ff 1.5\n" + "W 2.500 C closed " +
+	                       pointer_text + " -12 0.25\n";
+
+	std::string got = flush_to_string();
+	free(market);
+	if (got != expected) {
+		printf("FAIL: logged\n%sexpected\n%s", got.c_str(), expected.c_str());
+		return 1;
+	}
+	printf("%s", got.c_str());
+	return 0;
+}
@@ -0,0 +1,9 @@
+// The C side of test_dlog: C callers convert arguments with _Generic rather
+// than the C++ template
+
+#include "dlog.h"
+
+void test_dlog_from_c(const char *text, const void *pointer, int number,
+                      float value) {
+	DLOG_WARN("C %s %p %d %.2f\n", text, pointer, number, value);
+}
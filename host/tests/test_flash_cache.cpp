@@ -0,0 +1,306 @@
+// Drive the flash cache through thousands of saves on a model of the flash
+// that loses power at random points: part way through programming a record,
+// or through erasing a sector, which leaves it half erased. The log runs
+// round its sectors many times over, so every save may wrap the head and
+// reclaim the sector ahead of it.
+//
+// After every save, a scan of the flash must find what the cache holds in
+// memory. After every reboot, each symbol must come back with its newest
+// completed save or a later one. A save cut short may still have landed,
+// if the power went while programming the padding after the record.
+//
+// The cache is included whole, so its internal state can be compared.
+
+#include "flash_cache.cpp"
+
+#include <algorithm>
+#include <csetjmp>
+#include <map>
+#include <random>
+#include <string>
+
+#include "FreeRTOS.h"
+#include "console.hpp"
+#include "hardware/rtc.h"
+#include "pico/rand.h"
+#include "semphr.h"
+
+uint8_t sim_flash_memory[PICO_FLASH_SIZE_BYTES];
+
+static std::mt19937 rng(47);
+
+// Flash operations left before the power goes, -1 for never
+static long power_budget = -1;
+static jmp_buf power_cut;
+static uint32_t erases[FLASH_CACHE_SECTORS];
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+	if (flash_offs % FLASH_SECTOR_SIZE != 0 || count != FLASH_SECTOR_SIZE ||
+	    flash_offs < FLASH_CACHE_OFFSET) {
+		printf("FAIL: erase of %u bytes at %u\n", (unsigned)count,
+		       (unsigned)flash_offs);
+		exit(1);
+	}
+	erases[(flash_offs - FLASH_CACHE_OFFSET) / FLASH_SECTOR_SIZE]++;
+	uint8_t *sector = sim_flash_memory + flash_offs;
+	if (power_budget >= 0 && power_budget-- == 0) {
+		// Partly erased, with bits left over anywhere
+		memset(sector, 0xff, rng() % count);
+		for (size_t i = 0; i < count; i++) {
+			if (rng() % 3 == 0) {
+				sector[i] = rng();
+			}
+		}
+		longjmp(power_cut, 1);
+	}
+	memset(sector, 0xff, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data,
+                         size_t count) {
+	if (flash_offs % FLASH_PAGE_SIZE != 0 || count % FLASH_PAGE_SIZE != 0 ||
+	    flash_offs < FLASH_CACHE_OFFSET ||
+	    flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+		printf("FAIL: program of %u bytes at %u\n", (unsigned)count,
+		       (unsigned)flash_offs);
+		exit(1);
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (power_budget >= 0 && power_budget-- == 0) {
+			longjmp(power_cut, 1);
+		}
+		sim_flash_memory[flash_offs + i] &= data[i];
+	}
+}
+
+// A clock the test moves on, so saves aren't held back by the interval
+static uint64_t clock_us = 1;
+uint64_t time_us_64(void) { return clock_us; }
+void sleep_ms(uint32_t ms) { (void)ms; }
+uint32_t get_rand_32(void) { return 4; }
+bool rtc_get_datetime(datetime_t *t) {
+	memset(t, 0, sizeof(*t));
+	return true;
+}
+
+// Everything runs on one thread with no scheduler, so the kernel calls the
+// watchlist and the flash lockout make have nothing to do
+extern "C" {
+QueueHandle_t xQueueCreateMutex(const uint8_t type) {
+	(void)type;
+	static uint8_t mutex;
+	return (QueueHandle_t)&mutex;
+}
+BaseType_t xQueueSemaphoreTake(QueueHandle_t queue, TickType_t ticks) {
+	(void)queue;
+	(void)ticks;
+	return pdTRUE;
+}
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void *item,
+                             TickType_t ticks, BaseType_t position) {
+	(void)queue;
+	(void)item;
+	(void)ticks;
+	(void)position;
+	return pdTRUE;
+}
+void vPortEnterCritical(void) {}
+void vPortExitCritical(void) {}
+}
+
+bool console_register(const char *name, const char *help,
+                      void (*handler)(int argc, char **argv)) {
+	(void)name;
+	(void)help;
+	(void)handler;
+	return true;
+}
+
+static const char *const symbols[] = {
+    "AAPL", "MSFT", "NVDA", "META", "GOOG", "IBM",  "AMD",  "TSLA",
+    "X",    "QQQ",  "SPY",  "DIA",  "ORCL", "SAP",  "INTC", "BRK.A"};
+static constexpr size_t SYMBOLS = sizeof(symbols) / sizeof(symbols[0]);
+static constexpr int ROUNDS = 10000;
+
+// Every save gets a new version number, written into each candle's open
+static void make_series(StockData &data, const char *symbol, int version,
+                        size_t candles) {
+	memset(&data, 0, sizeof(data));
+	snprintf(data.symbol, sizeof(data.symbol), "%s", symbol);
+	snprintf(data.duration, sizeof(data.duration), "1d");
+	clear_candles(data);
+	for (size_t i = 0; i < candles; i++) {
+		Candle candle = {};
+		candle.time = 1700000000 + i * 86400;
+		candle.open = version;
+		candle.high = 100 + i;
+		candle.low = i;
+		candle.close = 50 + i;
+		candle.volume = 1000;
+		append_candle(data, candle);
+	}
+	data.open_price = version;
+	data.current_price = version + 0.5f;
+}
+
+static int failures = 0;
+
+static void fail(int round, const char *symbol, const char *what) {
+	if (failures++ < 10) {
+		printf("FAIL: round %d, %s: %s\n", round, symbol, what);
+	}
+}
+
+// What a fresh scan of the flash finds must be what the cache holds
+static void check_scan(int round) {
+	LiveRecord held[WATCHLIST_MAX_SYMBOLS];
+	memcpy(held, live, sizeof(held));
+	uint32_t held_head = head;
+	uint32_t held_head_sector = head_sector;
+	uint32_t held_next_sequence = next_sequence;
+
+	for (size_t i = 0; i < num_live; i++) {
+		live[i].valid = false;
+	}
+	scan();
+	for (size_t i = 0; i < num_live; i++) {
+		if (live[i].valid != held[i].valid ||
+		    (held[i].valid && live[i].offset != held[i].offset)) {
+			fail(round, live[i].symbol, "scan disagrees with memory");
+		}
+	}
+	if (next_sequence != held_next_sequence) {
+		fail(round, "log", "scan finds a different newest record");
+	}
+
+	memcpy(live, held, sizeof(held));
+	head = held_head;
+	head_sector = held_head_sector;
+	next_sequence = held_next_sequence;
+}
+
+int main() {
+	// Junk in the region on first use, as if something else had been there
+	memset(sim_flash_memory, 0x5a, sizeof(sim_flash_memory));
+
+	std::string list;
+	for (const char *symbol : symbols) {
+		list += symbol;
+		list += ",";
+	}
+	watchlist_init(list.c_str());
+
+	static StockData data;
+	static StockData shown;
+	if (flash_cache_init(shown)) {
+		fail(0, symbols[0], "restored from junk");
+	}
+
+	// The oldest version of each symbol a reboot may bring back: its newest
+	// completed save, or a later one a reboot has already found. And the
+	// symbol and candle count of every version.
+	std::map<std::string, int> oldest_allowed;
+	std::map<int, std::string> owners;
+	std::map<int, size_t> counts;
+	int version = 0;
+	int cuts = 0;
+	int reboots = 0;
+
+	for (int round = 1; round <= ROUNDS; round++) {
+		bool cut = rng() % 10 == 0;
+		power_budget = cut ? rng() % 3000 : -1;
+
+		// Some symbols are saved far less often than others, so their
+		// records sit in sectors the head comes round to reclaim
+		size_t which = rng() % SYMBOLS;
+		if (which > 3) {
+			which = rng() % SYMBOLS;
+		}
+		const char *symbol = symbols[which];
+		size_t candles = 1 + rng() % 60;
+		make_series(data, symbol, ++version, candles);
+		owners[version] = symbol;
+		counts[version] = std::min(candles, (size_t)FLASH_CACHE_CANDLES);
+		clock_us += (uint64_t)(FLASH_CACHE_SAVE_INTERVAL_MS + 1000) * 1000;
+
+		if (setjmp(power_cut) == 0) {
+			if (!flash_cache_save(data)) {
+				fail(round, symbol, "save refused");
+			}
+			oldest_allowed[symbol] = version;
+			power_budget = -1;
+			check_scan(round);
+		} else {
+			cuts++;
+		}
+		power_budget = -1;
+
+		if (!cut && rng() % 50 != 0) {
+			continue;
+		}
+
+		// Reboot, and check what each symbol comes back with
+		reboots++;
+		clock_us = 1;
+		bool first = flash_cache_init(shown);
+		for (size_t i = 0; i < num_live; i++) {
+			auto allowed = oldest_allowed.find(live[i].symbol);
+			if (!live[i].valid) {
+				if (allowed != oldest_allowed.end()) {
+					fail(round, live[i].symbol, "series lost");
+				}
+				continue;
+			}
+			const CacheRecord *record = record_at(live[i].offset);
+			int restored = (int)record->open_price;
+			if (owners[restored] != live[i].symbol ||
+			    record->count != counts[restored] ||
+			    record->candles[0].open != restored) {
+				fail(round, live[i].symbol, "restored a wrong series");
+			} else if (allowed != oldest_allowed.end() &&
+			           restored < allowed->second) {
+				fail(round, live[i].symbol, "restored an old series");
+			} else {
+				oldest_allowed[live[i].symbol] = restored;
+			}
+		}
+		if (first != live[0].valid ||
+		    (first && shown.open_price != record_at(live[0].offset)
+		                                      ->open_price)) {
+			fail(round, symbols[0], "wrong series shown");
+		}
+		check_scan(round);
+	}
+
+	// A flipped bit anywhere in a record's header must fail its check, the
+	// sequence included, or a stale record could pass for the newest
+	if (live[0].valid) {
+		uint8_t *bytes = sim_flash_memory + FLASH_CACHE_OFFSET + live[0].offset;
+		const size_t fields[] = {offsetof(CacheRecord, magic),
+		                         offsetof(CacheRecord, sequence),
+		                         offsetof(CacheRecord, symbol)};
+		for (size_t field : fields) {
+			bytes[field] ^= 0x10;
+			if (record_valid(record_at(live[0].offset))) {
+				fail(ROUNDS, symbols[0], "corrupt header passed");
+			}
+			bytes[field] ^= 0x10;
+		}
+	}
+
+	// The head must have gone round every sector, evenly
+	uint32_t fewest = *std::min_element(erases, erases + FLASH_CACHE_SECTORS);
+	uint32_t most = *std::max_element(erases, erases + FLASH_CACHE_SECTORS);
+	printf("%d saves, %d power cuts, %d reboots, %u to %u erases per "
+	       "sector\n",
+	       ROUNDS, cuts, reboots, (unsigned)fewest, (unsigned)most);
+	if (fewest == 0 || most > fewest * 2) {
+		fail(ROUNDS, "log", "erases not spread over the sectors");
+	}
+
+	if (failures) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,182 @@
+// Check the fixed point indicators against the same formulas in double, over
+// random walks at very different price levels. A third of the candles are
+// first appended wrong and then corrected with revise(), as live bars are.
+//
+// Tolerances: prices within 1e-4 of the price level plus 1e-3, which covers
+// Q16.16 rounding and the precision fix_scale_shift() gives up on expensive
+// stocks. RSI within 0.05 of a point.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "indicators.hpp"
+
+static constexpr size_t CANDLES = 300;
+static constexpr double RSI_TOLERANCE = 0.05;
+
+struct Reference {
+	std::vector<Candle> candles;
+	double ema = 0;
+	double avg_gain = 0;
+	double avg_loss = 0;
+
+	// Mean and standard deviation of the last period closes
+	void close_stats(size_t period, double &mean, double &deviation) const {
+		size_t t = candles.size() - 1;
+		double sum = 0;
+		for (size_t k = 0; k < period; k++) {
+			sum += candles[t - k].close;
+		}
+		mean = sum / period;
+		double squares = 0;
+		for (size_t k = 0; k < period; k++) {
+			double d = candles[t - k].close - mean;
+			squares += d * d;
+		}
+		deviation = sqrt(squares / period);
+	}
+
+	double vwap(size_t period) const {
+		size_t t = candles.size() - 1;
+		double price_volume = 0;
+		double volume = 0;
+		for (size_t k = 0; k < period; k++) {
+			const Candle &c = candles[t - k];
+			double typical = ((double)c.high + c.low + c.close) / 3;
+			price_volume += typical * c.volume;
+			volume += c.volume;
+		}
+		return price_volume / volume;
+	}
+
+	double rsi() const {
+		double total = avg_gain + avg_loss;
+		return total == 0 ? 50 : 100 * avg_gain / total;
+	}
+
+	void append(const Candle &candle) {
+		candles.push_back(candle);
+		size_t t = candles.size() - 1;
+		if (t == 0) {
+			ema = candle.close;
+			return;
+		}
+		ema += (candle.close - ema) * 2.0 / (INDICATOR_EMA_PERIOD + 1);
+
+		double change = (double)candle.close - candles[t - 1].close;
+		double gain = change > 0 ? change : 0;
+		double loss = change < 0 ? -change : 0;
+		double weight = t <= INDICATOR_RSI_PERIOD ? t : INDICATOR_RSI_PERIOD;
+		avg_gain += (gain - avg_gain) / weight;
+		avg_loss += (loss - avg_loss) / weight;
+	}
+};
+
+static int failures = 0;
+
+static void check(const char *line, double base, size_t t, float got,
+                  double want, double tolerance) {
+	if (std::isnan(got) || fabs(got - want) > tolerance) {
+		if (failures++ < 10) {
+			printf("FAIL: base %g candle %zu %s %f, expected %f\n", base, t,
+			       line, got, want);
+		}
+	}
+}
+
+static void check_unset(const char *line, double base, size_t t, float got) {
+	if (!std::isnan(got)) {
+		if (failures++ < 10) {
+			printf("FAIL: base %g candle %zu %s %f before it is ready\n",
+			       base, t, line, got);
+		}
+	}
+}
+
+static void run(double base, bool whole_volumes, std::mt19937 &rng) {
+	static IndicatorSeries<64> series;
+	series.clear();
+	Reference ref;
+	std::uniform_real_distribution<double> step(-0.01, 0.01);
+	std::uniform_int_distribution<int> volume(whole_volumes ? 1 : 100000,
+	                                          whole_volumes ? 50 : 5000000);
+
+	double price = base;
+	for (size_t t = 0; t < CANDLES; t++) {
+		Candle candle = {};
+		candle.open = price;
+		price *= 1 + step(rng);
+		candle.close = price;
+		candle.high = fmax(candle.open, candle.close) * 1.002;
+		candle.low = fmin(candle.open, candle.close) * 0.998;
+		candle.volume = volume(rng);
+
+		if (t > 0 && rng() % 3 == 0) {
+			Candle wrong = candle;
+			wrong.close *= 1.05f;
+			wrong.volume *= 2;
+			series.append(wrong);
+			series.revise(candle);
+		} else {
+			series.append(candle);
+		}
+		ref.append(candle);
+
+		size_t i = series.size() - 1;
+		double tolerance = base * 1e-4 + 1e-3;
+		typedef IndicatorSeries<64> Series;
+
+		if (t + 1 >= INDICATOR_SMA_PERIOD) {
+			double mean, deviation;
+			ref.close_stats(INDICATOR_SMA_PERIOD, mean, deviation);
+			double band = INDICATOR_BOLLINGER_K * deviation;
+			check("SMA", base, t, series.value(Series::LINE_SMA, i), mean,
+			      tolerance);
+			check("upper band", base, t,
+			      series.value(Series::LINE_BOLLINGER_UPPER, i), mean + band,
+			      tolerance);
+			check("lower band", base, t,
+			      series.value(Series::LINE_BOLLINGER_LOWER, i), mean - band,
+			      tolerance);
+		} else {
+			check_unset("SMA", base, t, series.value(Series::LINE_SMA, i));
+		}
+		if (t + 1 >= INDICATOR_VWAP_PERIOD) {
+			check("VWAP", base, t, series.value(Series::LINE_VWAP, i),
+			      ref.vwap(INDICATOR_VWAP_PERIOD), tolerance);
+		} else {
+			check_unset("VWAP", base, t, series.value(Series::LINE_VWAP, i));
+		}
+		if (t + 1 >= INDICATOR_EMA_PERIOD) {
+			check("EMA", base, t, series.value(Series::LINE_EMA, i), ref.ema,
+			      tolerance);
+		} else {
+			check_unset("EMA", base, t, series.value(Series::LINE_EMA, i));
+		}
+		if (t >= INDICATOR_RSI_PERIOD) {
+			check("RSI", base, t, series.value(Series::LINE_RSI, i),
+			      ref.rsi(), RSI_TOLERANCE);
+		} else {
+			check_unset("RSI", base, t, series.value(Series::LINE_RSI, i));
+		}
+	}
+}
+
+int main() {
+	std::mt19937 rng(1);
+	// A penny stock, a typical one, and one expensive enough to need
+	// fix_scale_shift(), traded in whole shares
+	run(1.5, false, rng);
+	run(180, false, rng);
+	run(612000, true, rng);
+
+	if (failures) {
+		printf("%d values out of tolerance\n", failures);
+		return 1;
+	}
+	printf("indicators match the double references\n");
+	return 0;
+}
@@ -0,0 +1,82 @@
+// Stress SnapshotBuffer with a real producer and consumer thread. Every field
+// of a snapshot carries the producer's sequence number, so a torn read shows
+// up as fields that disagree, and a stale slot as a sequence going backwards.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "snapshot_buffer.hpp"
+
+// Big enough that copying it is far from a single store
+struct Snapshot {
+	uint32_t sequence;
+	uint32_t fields[255];
+};
+
+static constexpr uint32_t SNAPSHOTS = 1000000;
+
+// The producer yields this often, so the consumer gets to run between
+// publishes even on a single core
+static constexpr uint32_t YIELD_EVERY = 16;
+
+int main() {
+	static SnapshotBuffer<Snapshot> buffer;
+	std::atomic<bool> done{false};
+
+	std::thread producer([&] {
+		for (uint32_t sequence = 1; sequence <= SNAPSHOTS; sequence++) {
+			Snapshot &snapshot = buffer.write_buffer();
+			snapshot.sequence = sequence;
+			for (uint32_t &field : snapshot.fields) {
+				field = sequence;
+			}
+			buffer.publish();
+			if (sequence % YIELD_EVERY == 0) {
+				std::this_thread::yield();
+			}
+		}
+		done.store(true, std::memory_order_release);
+	});
+
+	uint32_t acquired = 0;
+	uint32_t torn = 0;
+	uint32_t backwards = 0;
+	uint32_t last = 0;
+	for (;;) {
+		// Read done first, so the final publish is never missed
+		bool finished = done.load(std::memory_order_acquire);
+		if (buffer.acquire()) {
+			// Give the producer a turn halfway through, as if preempted
+			const Snapshot &snapshot = buffer.read_buffer();
+			uint32_t sequence = snapshot.sequence;
+			bool consistent = true;
+			for (size_t i = 0; i < 255; i++) {
+				if (i == 128) {
+					std::this_thread::yield();
+				}
+				consistent &= snapshot.fields[i] == sequence;
+			}
+			torn += !consistent;
+			if (sequence <= last) {
+				backwards++;
+			}
+			last = sequence;
+			acquired++;
+		} else if (finished) {
+			break;
+		} else {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	printf("%u snapshots published, %u acquired, %u torn, %u out of order\n",
+	       SNAPSHOTS, acquired, torn, backwards);
+	if (torn || backwards || last != SNAPSHOTS) {
+		printf("FAIL: last sequence seen %u\n", last);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,204 @@
+// Check TimeSeries against a plain vector of every candle appended. Series
+// of several capacities are filled well past capacity, so the ring wraps and
+// every append evicts, and after each append every bucket of every pyramid
+// level is compared with the candles it covers merged from scratch. The
+// time index is checked against a linear scan the same way.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "time_series.hpp"
+
+static int failures = 0;
+
+static void fail(const char *what, size_t capacity, size_t appended,
+                 size_t level, size_t i) {
+	if (failures++ < 10) {
+		printf("FAIL: capacity %zu after %zu appends: %s (level %zu, "
+		       "index %zu)\n",
+		       capacity, appended, what, level, i);
+	}
+}
+
+static bool same(const Candle &a, const Candle &b) {
+	return a.time == b.time && a.open == b.open && a.high == b.high &&
+	       a.low == b.low && a.close == b.close && a.volume == b.volume;
+}
+
+// Candles first to last merged field by field. Volumes are whole numbers,
+// so the sums are exact in any order.
+static Candle merge_range(const std::vector<Candle> &all, size_t first,
+                          size_t last) {
+	Candle merged = all[first];
+	for (size_t k = first + 1; k <= last; k++) {
+		merged.high = std::max(merged.high, all[k].high);
+		merged.low = std::min(merged.low, all[k].low);
+		merged.close = all[k].close;
+		merged.volume += all[k].volume;
+	}
+	return merged;
+}
+
+template <size_t Capacity> static void check_pyramid(size_t appends) {
+	static TimeSeries<Capacity> series;
+	series.clear();
+	std::vector<Candle> all;
+	std::mt19937 rng(Capacity);
+
+	for (size_t n = 0; n < appends; n++) {
+		Candle candle = {};
+		candle.time = 1700000000 + n * 60;
+		candle.open = rng() % 100;
+		candle.close = rng() % 100;
+		candle.high = std::max(candle.open, candle.close) + rng() % 5;
+		candle.low = std::min(candle.open, candle.close) - rng() % 5;
+		candle.volume = rng() % 10;
+		series.append(candle);
+		all.push_back(candle);
+
+		size_t newest = n;
+		size_t oldest = n + 1 - series.size();
+		if (series.size() != std::min(n + 1, Capacity)) {
+			fail("wrong size", Capacity, n + 1, 0, 0);
+			continue;
+		}
+
+		Candle whole = merge_range(all, oldest, newest);
+		if (series.min_low() != whole.low || series.max_high() != whole.high) {
+			fail("wrong extremes", Capacity, n + 1, 0, 0);
+		}
+
+		for (size_t level = 0; level < series.levels(); level++) {
+			size_t buckets = (newest >> level) - (oldest >> level) + 1;
+			if (series.level_size(level) != buckets) {
+				fail("wrong bucket count", Capacity, n + 1, level, 0);
+				continue;
+			}
+			// The oldest and newest buckets are clipped to what is held
+			for (size_t i = 0; i < buckets; i++) {
+				size_t id = (oldest >> level) + i;
+				size_t first = std::max(id << level, oldest);
+				size_t last = std::min(((id + 1) << level) - 1, newest);
+				if (!same(series.bucket(level, i),
+				          merge_range(all, first, last))) {
+					fail("wrong bucket", Capacity, n + 1, level, i);
+				}
+			}
+		}
+	}
+}
+
+// Times step by 0 to 3 minutes, repeats included, with a gap now and then
+static void check_time_index() {
+	static TimeSeries<16> series;
+	series.clear();
+	std::vector<uint32_t> times;
+	std::mt19937 rng(49);
+	uint32_t time = 1700000000;
+
+	for (size_t n = 0; n < 100; n++) {
+		time += rng() % 20 == 0 ? 2 * 86400 : rng() % 4 * 60;
+		Candle candle = {time, 1, 1, 1, 1, 1};
+		series.append(candle);
+		times.push_back(time);
+
+		size_t oldest = n + 1 - series.size();
+		uint32_t from = series.time(0) - 120;
+		for (uint32_t t = from; t <= time + 120; t += 7) {
+			size_t want = 0;
+			while (want < series.size() && times[oldest + want] < t) {
+				want++;
+			}
+			if (series.lower_bound_time(t) != want) {
+				fail("wrong lower_bound_time", 16, n + 1, 0, want);
+			}
+		}
+		if (series.time_step(0) != 0) {
+			fail("time step before the oldest", 16, n + 1, 0, 0);
+		}
+		for (size_t i = 1; i < series.size(); i++) {
+			uint32_t want = times[oldest + i] - times[oldest + i - 1];
+			if (series.time_step(i) != want) {
+				fail("wrong time_step", 16, n + 1, 0, i);
+			}
+		}
+	}
+
+	// Candles without times have no step to or from them
+	series.clear();
+	series.append({0, 1, 1, 1, 1, 1});
+	series.append({1700000000, 1, 1, 1, 1, 1});
+	series.append({1700000060, 1, 1, 1, 1, 1});
+	if (series.time_step(1) != 0 || series.time_step(2) != 60) {
+		fail("time step from an untimed candle", 16, 3, 0, 1);
+	}
+}
+
+// The plain ring must hold the same newest candles as the full series, and
+// a series rebuilt from it the same buckets
+template <size_t Capacity> static void check_ring(size_t appends) {
+	static TimeSeries<Capacity> series;
+	static TimeSeries<Capacity> rebuilt;
+	static CandleRing<Capacity> ring;
+	series.clear();
+	ring.clear();
+	std::mt19937 rng(Capacity);
+
+	for (size_t n = 0; n < appends; n++) {
+		float price = 100 + rng() % 1000 / 10.0f;
+		Candle candle = {(uint32_t)n, price, price + 1, price - 1, price,
+		                 (float)(rng() % 500)};
+		series.append(candle);
+		ring.append(candle);
+
+		if (ring.size() != series.size()) {
+			fail("ring size", Capacity, n + 1, 0, 0);
+			continue;
+		}
+		for (size_t i = 0; i < ring.size(); i++) {
+			if (!same(ring.at(i), series.at(i))) {
+				fail("ring candle", Capacity, n + 1, 0, i);
+			}
+		}
+
+		rebuilt.clear(ring.oldest_sequence());
+		for (size_t i = 0; i < ring.size(); i++) {
+			rebuilt.append(ring.at(i));
+		}
+		for (size_t level = 0; level < series.levels(); level++) {
+			if (rebuilt.level_size(level) != series.level_size(level)) {
+				fail("rebuilt level size", Capacity, n + 1, level, 0);
+				continue;
+			}
+			for (size_t i = 0; i < series.level_size(level); i++) {
+				Candle a = rebuilt.bucket(level, i);
+				Candle b = series.bucket(level, i);
+				// Volumes may be summed in another order
+				a.volume = b.volume;
+				if (!same(a, b)) {
+					fail("rebuilt bucket", Capacity, n + 1, level, i);
+				}
+			}
+		}
+	}
+}
+
+int main() {
+	check_pyramid<2>(50);
+	check_pyramid<16>(300);
+	check_pyramid<256>(100);
+	check_pyramid<256>(2000);
+	check_time_index();
+	check_ring<2>(5);
+	check_ring<32>(100);
+
+	if (failures) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("time series match the reference\n");
+	return 0;
+}
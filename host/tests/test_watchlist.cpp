@@ -0,0 +1,112 @@
+// Check Watchlist against a vector of symbols in the order they were added,
+// through random adds, removes and lookups, including symbols that are
+// empty, too long, or prefixes of one another. Each slot is tagged when it
+// is added, so a remove that mixed up the slots it moves shows up too.
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "watchlist.hpp"
+
+static const char *const names[] = {
+    "AAPL", "MSFT", "A",    "AA",   "ZZZZZZZ", "NVDA", "META",
+    "GOOG", "BRK.A", "X",   "IBM",  "TSLA",    "AMD",  "INTC",
+    "ORCL", "SAP",  "QQQ",  "SPY",  "DIA",     "TOOLONGX", ""};
+static constexpr size_t NAMES = sizeof(names) / sizeof(names[0]);
+
+struct Entry {
+	std::string symbol;
+	float tag;
+};
+
+static std::vector<Entry>::iterator find_entry(std::vector<Entry> &model,
+                                              const char *symbol) {
+	for (auto it = model.begin(); it != model.end(); ++it) {
+		if (it->symbol == symbol) {
+			return it;
+		}
+	}
+	return model.end();
+}
+
+static int failures = 0;
+
+static void fail(int step, const char *symbol, const char *what) {
+	if (failures++ < 10) {
+		printf("FAIL: step %d, \"%s\": %s\n", step, symbol, what);
+	}
+}
+
+int main() {
+	typedef Watchlist<16, 32> List;
+	static List list;
+	std::vector<Entry> model;
+	std::mt19937 rng(46);
+	float next_tag = 1;
+
+	for (int step = 0; step < 20000; step++) {
+		const char *symbol = names[rng() % NAMES];
+		bool usable = strlen(symbol) > 0 &&
+		              strlen(symbol) <= List::MAX_SYMBOL_LENGTH;
+		auto held = find_entry(model, symbol);
+
+		switch (rng() % 3) {
+		case 0: {
+			List::Slot *slot = list.add(symbol);
+			bool expected =
+			    usable && (held != model.end() ||
+			               model.size() < List::capacity());
+			if ((slot != nullptr) != expected) {
+				fail(step, symbol, "add gave the wrong answer");
+			} else if (slot && held == model.end()) {
+				if (slot->updates != 0 || !slot->series.empty()) {
+					fail(step, symbol, "added slot not empty");
+				}
+				slot->current_price = next_tag;
+				slot->series.append({1, next_tag, 1, 1, 1, 1});
+				model.push_back({symbol, next_tag++});
+			}
+			break;
+		}
+		case 1:
+			if (list.remove(symbol) != (held != model.end())) {
+				fail(step, symbol, "remove gave the wrong answer");
+			} else if (held != model.end()) {
+				model.erase(held);
+			}
+			break;
+		default: {
+			const List::Slot *slot = list.find(symbol);
+			if ((slot != nullptr) != (held != model.end())) {
+				fail(step, symbol, "find gave the wrong answer");
+			} else if (slot && slot->current_price != held->tag) {
+				fail(step, symbol, "find gave the wrong slot");
+			}
+			break;
+		}
+		}
+
+		if (list.size() != model.size()) {
+			fail(step, symbol, "wrong size");
+			continue;
+		}
+		for (size_t i = 0; i < model.size(); i++) {
+			const List::Slot &slot = list.at(i);
+			if (model[i].symbol != slot.symbol ||
+			    slot.current_price != model[i].tag ||
+			    slot.series.back().open != model[i].tag) {
+				fail(step, slot.symbol, "slots out of order");
+			}
+		}
+	}
+
+	if (failures) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("watchlist matches the reference\n");
+	return 0;
+}
@@ -0,0 +1,413 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "time_series.hpp"
+
+// Streaming technical indicators in fixed point. The RP2040 has no FPU, so
+// each candle is converted once and every update after that is integer
+// arithmetic, O(1) per appended candle. revise() redoes the last update for
+// a candle that changed after it was appended, such as a live bar.
+
+#ifndef INDICATOR_SMA_PERIOD
+#define INDICATOR_SMA_PERIOD 20
+#endif
+#ifndef INDICATOR_EMA_PERIOD
+#define INDICATOR_EMA_PERIOD 9
+#endif
+#ifndef INDICATOR_RSI_PERIOD
+#define INDICATOR_RSI_PERIOD 14
+#endif
+#ifndef INDICATOR_VWAP_PERIOD
+#define INDICATOR_VWAP_PERIOD 20
+#endif
+// Bollinger bands sit this many standard deviations either side of the SMA
+#ifndef INDICATOR_BOLLINGER_K
+#define INDICATOR_BOLLINGER_K 2
+#endif
+
+// Prices in Q16.16 held in 64 bits, enough for six digit prices summed over
+// a long period
+typedef int64_t fix_t;
+#define FIX_SHIFT 16
+#define FIX_ONE ((fix_t)1 << FIX_SHIFT)
+
+static inline fix_t fix_from_float(float value) {
+	return (fix_t)llroundf(value * (float)FIX_ONE);
+}
+static inline float fix_to_float(fix_t value) {
+	return (float)value / (float)FIX_ONE;
+}
+
+// How far a price must be shifted right to fit in 24 bits. Products of
+// prices that size with each other, or with a 32 bit volume, can be summed
+// over a period without overflowing 64 bits, while cheap stocks keep all 16
+// fraction bits.
+static inline int fix_scale_shift(fix_t price) {
+	int shift = 0;
+	uint64_t magnitude = price < 0 ? -price : price;
+	while ((magnitude >> shift) >= ((uint64_t)1 << 24)) {
+		shift++;
+	}
+	return shift;
+}
+
+// Integer square root, rounded down
+static inline uint64_t fix_isqrt(uint64_t value) {
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+	while (bit > value) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+// The last Period inputs and their sum. A new input replaces the oldest.
+template <typename T, size_t Period> class FixWindow {
+  public:
+	void clear() {
+		next_ = 0;
+		count_ = 0;
+		sum_ = 0;
+	}
+	void append(T value) {
+		if (count_ == Period) {
+			sum_ -= values_[next_];
+		} else {
+			count_++;
+		}
+		values_[next_] = value;
+		sum_ += value;
+		next_ = next_ + 1 == Period ? 0 : next_ + 1;
+	}
+	void revise(T value) {
+		size_t last = next_ == 0 ? Period - 1 : next_ - 1;
+		sum_ += value - values_[last];
+		values_[last] = value;
+	}
+	size_t count() const { return count_; }
+	bool ready() const { return count_ == Period; }
+	T sum() const { return sum_; }
+
+  private:
+	T values_[Period];
+	size_t next_ = 0;
+	size_t count_ = 0;
+	T sum_ = 0;
+};
+
+// Simple moving average of the close
+template <size_t Period> class Sma {
+  public:
+	void clear() { window_.clear(); }
+	void append(fix_t close) { window_.append(close); }
+	void revise(fix_t close) { window_.revise(close); }
+	bool ready() const { return window_.ready(); }
+	fix_t value() const { return window_.sum() / (fix_t)window_.count(); }
+
+  private:
+	FixWindow<fix_t, Period> window_;
+};
+
+// Exponential moving average of the close, seeded with the first close
+template <size_t Period> class Ema {
+  public:
+	void clear() { count_ = 0; }
+	void append(fix_t close) {
+		previous_ = value_;
+		count_++;
+		update(close);
+	}
+	void revise(fix_t close) {
+		value_ = previous_;
+		update(close);
+	}
+	bool ready() const { return count_ >= Period; }
+	fix_t value() const { return value_; }
+
+  private:
+	// 2 / (Period + 1), rounded
+	static constexpr fix_t ALPHA =
+	    (2 * FIX_ONE + (Period + 1) / 2) / (Period + 1);
+
+	void update(fix_t close) {
+		if (count_ == 1) {
+			value_ = close;
+		} else {
+			value_ += ((close - value_) * ALPHA) >> FIX_SHIFT;
+		}
+	}
+
+	fix_t value_ = 0;
+	fix_t previous_ = 0;
+	size_t count_ = 0;
+};
+
+// Wilder's relative strength index, 0 to 100. The first Period changes are
+// averaged plainly, then each new one is smoothed in with weight 1/Period.
+// The averages carry 8 more fraction bits than prices, as the divisions
+// would otherwise wear small moves away.
+template <size_t Period> class Rsi {
+  public:
+	void clear() { state_ = State(); }
+	void append(fix_t close) {
+		previous_ = state_;
+		update(close);
+	}
+	void revise(fix_t close) {
+		state_ = previous_;
+		update(close);
+	}
+	bool ready() const { return state_.changes >= Period; }
+	fix_t value() const {
+		fix_t total = state_.avg_gain + state_.avg_loss;
+		if (total == 0) {
+			return 50 * FIX_ONE;
+		}
+		return state_.avg_gain * 100 * FIX_ONE / total;
+	}
+
+  private:
+	struct State {
+		fix_t last_close = 0;
+		fix_t avg_gain = 0;
+		fix_t avg_loss = 0;
+		size_t changes = 0;
+		bool started = false;
+	};
+
+	void update(fix_t close) {
+		State &s = state_;
+		if (!s.started) {
+			s.started = true;
+			s.last_close = close;
+			return;
+		}
+		fix_t change = (close - s.last_close) << 8;
+		fix_t gain = change > 0 ? change : 0;
+		fix_t loss = change < 0 ? -change : 0;
+		s.last_close = close;
+		s.changes++;
+		if (s.changes <= Period) {
+			// Running mean of the first Period changes
+			s.avg_gain += (gain - s.avg_gain) / (fix_t)s.changes;
+			s.avg_loss += (loss - s.avg_loss) / (fix_t)s.changes;
+		} else {
+			s.avg_gain += (gain - s.avg_gain) / (fix_t)Period;
+			s.avg_loss += (loss - s.avg_loss) / (fix_t)Period;
+		}
+	}
+
+	State state_;
+	State previous_;
+};
+
+// Volume-weighted average of the typical price (high + low + close) / 3
+// over the last Period candles. Prices are scaled down to 24 bits, as set by
+// the first one, before they are multiplied by the volume.
+template <size_t Period> class Vwap {
+  public:
+	void clear() {
+		price_volume_.clear();
+		volume_.clear();
+		shift_ = -1;
+	}
+	void append(fix_t typical, float volume) {
+		if (shift_ < 0) {
+			shift_ = fix_scale_shift(typical);
+		}
+		price_volume_.append(weigh(typical, volume));
+		volume_.append(to_volume(volume));
+	}
+	void revise(fix_t typical, float volume) {
+		price_volume_.revise(weigh(typical, volume));
+		volume_.revise(to_volume(volume));
+	}
+	// Needs a full period with some volume in it
+	bool ready() const { return volume_.ready() && volume_.sum() > 0; }
+	fix_t value() const {
+		return (price_volume_.sum() / volume_.sum()) << shift_;
+	}
+
+  private:
+	static int64_t to_volume(float volume) {
+		return volume > 0 ? (int64_t)volume : 0;
+	}
+	int64_t weigh(fix_t typical, float volume) const {
+		return (typical >> shift_) * to_volume(volume);
+	}
+
+	FixWindow<int64_t, Period> price_volume_;
+	FixWindow<int64_t, Period> volume_;
+	int shift_ = -1; // Set by the first price
+};
+
+// Bollinger bands: the SMA plus and minus K standard deviations. The
+// variance is taken from closes relative to the first close seen, scaled
+// down as in Vwap, so the squares stay in range and don't cancel out for
+// large prices.
+template <size_t Period, int K> class Bollinger {
+  public:
+	void clear() {
+		sma_.clear();
+		deviation_.clear();
+		squares_.clear();
+		shift_ = -1;
+	}
+	void append(fix_t close) {
+		int64_t d = offset(close);
+		sma_.append(close);
+		deviation_.append(d);
+		squares_.append(d * d);
+	}
+	void revise(fix_t close) {
+		int64_t d = offset(close);
+		sma_.revise(close);
+		deviation_.revise(d);
+		squares_.revise(d * d);
+	}
+	bool ready() const { return sma_.ready(); }
+	fix_t middle() const { return sma_.value(); }
+	fix_t upper() const { return middle() + K * deviation(); }
+	fix_t lower() const { return middle() - K * deviation(); }
+
+	// Population standard deviation, in Q16
+	fix_t deviation() const {
+		// n^2 times the variance is exact in integers
+		int64_t n = (int64_t)deviation_.count();
+		int64_t sum = deviation_.sum();
+		int64_t variance = (n * squares_.sum() - sum * sum) / (n * n);
+		if (variance <= 0) {
+			return 0;
+		}
+		return (fix_t)fix_isqrt((uint64_t)variance) << shift_;
+	}
+
+  private:
+	int64_t offset(fix_t close) {
+		if (shift_ < 0) {
+			anchor_ = close;
+			shift_ = fix_scale_shift(close);
+		}
+		return (close - anchor_) >> shift_;
+	}
+
+	Sma<Period> sma_;
+	FixWindow<int64_t, Period> deviation_;
+	FixWindow<int64_t, Period> squares_;
+	fix_t anchor_ = 0;
+	int shift_ = -1; // Set with the anchor by the first close
+};
+
+// The indicators for one series, fed candle by candle alongside its
+// TimeSeries. Each output line is a ring of the last Capacity values,
+// aligned with the newest candles, so the chart reads them next to the
+// candles it draws. Values are NAN until an indicator has seen enough
+// candles.
+template <size_t Capacity> class IndicatorSeries {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+	              "IndicatorSeries capacity must be a power of two");
+
+  public:
+	enum Line {
+		LINE_SMA,
+		LINE_EMA,
+		LINE_BOLLINGER_UPPER,
+		LINE_BOLLINGER_LOWER,
+		LINE_VWAP,
+		LINE_RSI,
+		LINE_COUNT
+	};
+
+	static constexpr size_t capacity() { return Capacity; }
+	size_t size() const { return count_; }
+
+	void clear() {
+		head_ = 0;
+		count_ = 0;
+		ema_.clear();
+		rsi_.clear();
+		vwap_.clear();
+		bollinger_.clear();
+	}
+
+	void append(const Candle &candle) {
+		size_t slot = (head_ + count_) & MASK;
+		if (count_ == Capacity) {
+			head_ = (head_ + 1) & MASK;
+		} else {
+			count_++;
+		}
+		fix_t close = fix_from_float(candle.close);
+		fix_t typical = typical_price(candle);
+		ema_.append(close);
+		rsi_.append(close);
+		vwap_.append(typical, candle.volume);
+		bollinger_.append(close);
+		store(slot);
+	}
+
+	// The newest candle changed since it was appended
+	void revise(const Candle &candle) {
+		if (count_ == 0) {
+			return;
+		}
+		fix_t close = fix_from_float(candle.close);
+		fix_t typical = typical_price(candle);
+		ema_.revise(close);
+		rsi_.revise(close);
+		vwap_.revise(typical, candle.volume);
+		bollinger_.revise(close);
+		store((head_ + count_ - 1) & MASK);
+	}
+
+	// Value by logical index, 0 being the oldest held
+	float value(Line line, size_t i) const {
+		return lines_[line][(head_ + i) & MASK];
+	}
+
+  private:
+	static constexpr size_t MASK = Capacity - 1;
+
+	static fix_t typical_price(const Candle &candle) {
+		return (fix_from_float(candle.high) + fix_from_float(candle.low) +
+		        fix_from_float(candle.close)) /
+		       3;
+	}
+
+	void store(size_t slot) {
+		bool bands = bollinger_.ready();
+		lines_[LINE_SMA][slot] =
+		    bands ? fix_to_float(bollinger_.middle()) : NAN;
+		lines_[LINE_BOLLINGER_UPPER][slot] =
+		    bands ? fix_to_float(bollinger_.upper()) : NAN;
+		lines_[LINE_BOLLINGER_LOWER][slot] =
+		    bands ? fix_to_float(bollinger_.lower()) : NAN;
+		lines_[LINE_EMA][slot] =
+		    ema_.ready() ? fix_to_float(ema_.value()) : NAN;
+		lines_[LINE_VWAP][slot] =
+		    vwap_.ready() ? fix_to_float(vwap_.value()) : NAN;
+		lines_[LINE_RSI][slot] =
+		    rsi_.ready() ? fix_to_float(rsi_.value()) : NAN;
+	}
+
+	float lines_[LINE_COUNT][Capacity];
+	size_t head_ = 0;
+	size_t count_ = 0;
+
+	Ema<INDICATOR_EMA_PERIOD> ema_;
+	Rsi<INDICATOR_RSI_PERIOD> rsi_;
+	Vwap<INDICATOR_VWAP_PERIOD> vwap_;
+	Bollinger<INDICATOR_SMA_PERIOD, INDICATOR_BOLLINGER_K> bollinger_;
+};
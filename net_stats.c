@@ -0,0 +1,153 @@
+#include "net_stats.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/sync.h"
+
+static NetHistogram histograms[NET_METRIC_COUNT];
+static uint32_t counters[NET_COUNTER_COUNT];
+
+// Samples come from lwIP callbacks and application tasks on either core
+static critical_section_t stats_lock;
+
+static const char *const metric_names[NET_METRIC_COUNT] = {
+    "dns",      "tcp_connect", "tls_handshake",  "rtt_auth",
+    "rtt_ping", "rtt_get_time", "rtt_get_stock", "rtt_other",
+};
+
+static const char *const counter_names[NET_COUNTER_COUNT] = {
+    "bytes_out", "bytes_in", "connects", "retries", "timeouts", "errors",
+};
+
+static void stats_lock_enter(void) {
+	critical_section_enter_blocking(&stats_lock);
+}
+
+static void stats_lock_exit(void) { critical_section_exit(&stats_lock); }
+
+static uint32_t bucket_for(uint32_t elapsed_us) {
+	if (elapsed_us == 0)
+		return 0;
+	uint32_t bucket = 32 - __builtin_clz(elapsed_us);
+	return bucket < NET_HIST_BUCKETS ? bucket : NET_HIST_BUCKETS - 1;
+}
+
+void net_stats_init(void) { critical_section_init(&stats_lock); }
+
+void net_stats_record(NetMetric metric, uint32_t elapsed_us) {
+	if (metric >= NET_METRIC_COUNT)
+		return;
+
+	stats_lock_enter();
+	NetHistogram *hist = &histograms[metric];
+	if (hist->count == 0 || elapsed_us < hist->min_us)
+		hist->min_us = elapsed_us;
+	if (elapsed_us > hist->max_us)
+		hist->max_us = elapsed_us;
+	hist->count++;
+	hist->sum_us += elapsed_us;
+	hist->buckets[bucket_for(elapsed_us)]++;
+	stats_lock_exit();
+}
+
+void net_stats_add(NetCounter counter, uint32_t amount) {
+	if (counter >= NET_COUNTER_COUNT)
+		return;
+
+	stats_lock_enter();
+	counters[counter] += amount;
+	stats_lock_exit();
+}
+
+NetMetric net_stats_rtt_metric(const char *command) {
+	if (strcmp(command, "ping") == 0)
+		return NET_METRIC_RTT_PING;
+	if (strcmp(command, "get_time") == 0)
+		return NET_METRIC_RTT_GET_TIME;
+	if (strcmp(command, "get_stock_data") == 0)
+		return NET_METRIC_RTT_GET_STOCK_DATA;
+	return NET_METRIC_RTT_OTHER;
+}
+
+void net_stats_get(NetMetric metric, NetHistogram *out) {
+	if (metric >= NET_METRIC_COUNT) {
+		memset(out, 0, sizeof(*out));
+		return;
+	}
+
+	stats_lock_enter();
+	*out = histograms[metric];
+	stats_lock_exit();
+}
+
+uint32_t net_stats_counter(NetCounter counter) {
+	if (counter >= NET_COUNTER_COUNT)
+		return 0;
+
+	stats_lock_enter();
+	uint32_t value = counters[counter];
+	stats_lock_exit();
+	return value;
+}
+
+uint32_t net_stats_percentile_us(const NetHistogram *hist, uint32_t percent) {
+	if (hist->count == 0)
+		return 0;
+
+	// Rank of the sample we're after, rounded up so p100 is the last sample
+	uint64_t target = ((uint64_t)hist->count * percent + 99) / 100;
+	if (target == 0)
+		target = 1;
+
+	uint64_t seen = 0;
+	for (uint32_t i = 0; i < NET_HIST_BUCKETS; i++) {
+		seen += hist->buckets[i];
+		if (seen >= target) {
+			if (i == NET_HIST_BUCKETS - 1)
+				return hist->max_us;
+			uint32_t upper = i == 0 ? 0 : (1u << i) - 1;
+			return upper < hist->max_us ? upper : hist->max_us;
+		}
+	}
+	return hist->max_us;
+}
+
+const char *net_stats_metric_name(NetMetric metric) {
+	return metric < NET_METRIC_COUNT ? metric_names[metric] : "?";
+}
+
+const char *net_stats_counter_name(NetCounter counter) {
+	return counter < NET_COUNTER_COUNT ? counter_names[counter] : "?";
+}
+
+void net_stats_print(void) {
+	printf("\nNetwork Stats (ms):\n");
+	printf("%-14s %6s %8s %8s %8s %8s\n", "metric", "count", "mean", "p50",
+	       "p95", "max");
+	for (int m = 0; m < NET_METRIC_COUNT; m++) {
+		NetHistogram hist;
+		net_stats_get((NetMetric)m, &hist);
+		if (hist.count == 0) {
+			printf("%-14s %6d\n", metric_names[m], 0);
+			continue;
+		}
+		printf("%-14s %6lu %8.1f %8.1f %8.1f %8.1f\n", metric_names[m],
+		       (unsigned long)hist.count,
+		       (double)hist.sum_us / hist.count / 1000.0,
+		       net_stats_percentile_us(&hist, 50) / 1000.0,
+		       net_stats_percentile_us(&hist, 95) / 1000.0,
+		       hist.max_us / 1000.0);
+	}
+	for (int c = 0; c < NET_COUNTER_COUNT; c++) {
+		printf("%-14s %lu\n", counter_names[c],
+		       (unsigned long)net_stats_counter((NetCounter)c));
+	}
+}
+
+void net_stats_reset(void) {
+	stats_lock_enter();
+	memset(histograms, 0, sizeof(histograms));
+	memset(counters, 0, sizeof(counters));
+	stats_lock_exit();
+}
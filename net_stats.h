@@ -0,0 +1,111 @@
+#ifndef NET_STATS_H
+#define NET_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Latency histograms use log2 buckets of microseconds: bucket i holds samples
+// in [2^(i-1), 2^i) us, and the last bucket collects everything slower.
+#define NET_HIST_BUCKETS 25
+
+typedef enum {
+	NET_METRIC_DNS = 0,
+	NET_METRIC_TCP_CONNECT,
+	NET_METRIC_TLS_HANDSHAKE,
+	NET_METRIC_RTT_AUTH,
+	NET_METRIC_RTT_PING,
+	NET_METRIC_RTT_GET_TIME,
+	NET_METRIC_RTT_GET_STOCK_DATA,
+	NET_METRIC_RTT_OTHER,
+	NET_METRIC_COUNT
+} NetMetric;
+
+typedef enum {
+	NET_COUNTER_BYTES_OUT = 0,
+	NET_COUNTER_BYTES_IN,
+	NET_COUNTER_CONNECTS,
+	NET_COUNTER_RETRIES,
+	NET_COUNTER_TIMEOUTS,
+	NET_COUNTER_ERRORS,
+	NET_COUNTER_COUNT
+} NetCounter;
+
+typedef struct {
+	uint32_t count;
+	uint32_t min_us;
+	uint32_t max_us;
+	uint64_t sum_us;
+	uint32_t buckets[NET_HIST_BUCKETS];
+} NetHistogram;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Set up the stats lock. Call once before any task records samples.
+ */
+void net_stats_init(void);
+
+/**
+ * Record one latency sample. Safe to call from any task or core, including
+ * lwIP callbacks.
+ * @param metric The histogram to add the sample to
+ * @param elapsed_us The measured duration in microseconds
+ */
+void net_stats_record(NetMetric metric, uint32_t elapsed_us);
+
+/**
+ * Add to one of the running counters
+ * @param counter The counter to increment
+ * @param amount The amount to add
+ */
+void net_stats_add(NetCounter counter, uint32_t amount);
+
+/**
+ * Map a command name to its round trip time histogram
+ * @param command The command name sent to the server
+ * @return The matching NET_METRIC_RTT_* value
+ */
+NetMetric net_stats_rtt_metric(const char *command);
+
+/**
+ * Copy a histogram out under the lock
+ * @param metric The histogram to copy
+ * @param out Receives the copy
+ */
+void net_stats_get(NetMetric metric, NetHistogram *out);
+
+/**
+ * Read a counter
+ * @param counter The counter to read
+ * @return The current value
+ */
+uint32_t net_stats_counter(NetCounter counter);
+
+/**
+ * Estimate a percentile from the log buckets
+ * @param hist The histogram to query
+ * @param percent The percentile, 0-100
+ * @return Upper bound of the bucket holding the percentile, in microseconds
+ */
+uint32_t net_stats_percentile_us(const NetHistogram *hist, uint32_t percent);
+
+const char *net_stats_metric_name(NetMetric metric);
+const char *net_stats_counter_name(NetCounter counter);
+
+/**
+ * Print every histogram and counter over stdio
+ */
+void net_stats_print(void);
+
+/**
+ * Clear all histograms and counters
+ */
+void net_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_STATS_H
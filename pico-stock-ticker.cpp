@@ -1,7 +1,24 @@
 #include "pico-stock-ticker.hpp"
 #include "ArduinoJson/Strings/JsonString.hpp"
+#include "boot_timeline.hpp"
+#include "button_events.hpp"
+#include "connection_manager.hpp"
+#include "console.hpp"
+#include "core_load.h"
 #include "display.hpp"
+#include "dlog.h"
+#include "flash_cache.hpp"
 #include "hardware/rtc.h"
+#include "net_stats.h"
+#include "power.hpp"
+#include "render_scheduler.hpp"
+#include "sleep_stats.h"
+#include "snapshot_buffer.hpp"
+#include "sys_monitor.hpp"
+#include "task_registry.hpp"
+#include "trace_buffer.h"
+#include "watchlist.hpp"
+#include "wifi_supervisor.hpp"
 #include "pico/util/datetime.h"
 #include "tls_client.h"
 #include <ArduinoJson.h>
@@ -14,63 +31,87 @@
 static const uint8_t cert_ok[] = ROOT_CERT;
 
 static SemaphoreHandle_t http_request_complete_sem = NULL;
-static SemaphoreHandle_t wifi_connected_sem = NULL; // To signal HTTP task
+#if STATIC_ALLOCATION
+static StaticSemaphore_t http_request_complete_sem_buffer;
+#endif
 
-volatile uint32_t ulIdleCycleCount = 0UL;
+// Given by the render core once the boot frame is on the panel, after which
+// the network core may write the snapshot
+static SemaphoreHandle_t boot_frame_ready_sem = NULL;
+#if STATIC_ALLOCATION
+static StaticSemaphore_t boot_frame_ready_sem_buffer;
+#endif
 
-// Define the number of tasks we're tracking
-const size_t NUM_TASKS = 4;  // main, blink, wifi, tls_client
+// Stock data published by the network core and drawn by the render core
+static SnapshotBuffer<StockData> stock_snapshot;
 
-// Initialize the stack usage tracking array
-TaskStackUsage task_stack_usage[NUM_TASKS] = {
-    {"MainThread", MAIN_TASK_STACK_SIZE, 0},
-    {"BlinkThread", BLINK_TASK_STACK_SIZE, 0},
-    {"WiFiThread", WIFI_TASK_STACK_SIZE, 0},
-    {"TLSClientThread", HTTP_GET_TASK_STACK_SIZE, 0}
-};
+// Pin a task created elsewhere, such as lwIP's tcpip thread
+static TaskHandle_t pin_task_by_name(const char *name, UBaseType_t core_mask) {
+	TaskHandle_t task = xTaskGetHandle(name);
+	if (task == NULL) {
+		printf("Cannot pin %s: task not found\n", name);
+		return NULL;
+	}
+#if configUSE_CORE_AFFINITY && configNUMBER_OF_CORES > 1
+	vTaskCoreAffinitySet(task, core_mask);
+#else
+	(void)core_mask;
+#endif
+	return task;
+}
+
+// Console command: network latency histograms and endpoint health
+static void cmd_net(int argc, char **argv) {
+	if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+		net_stats_reset();
+		printf("Network stats reset\n");
+		return;
+	}
+	wifi_supervisor_print_status();
+	net_stats_print();
+	connection_manager_print_status();
+}
 
-// Function to update stack usage for a task
-static void update_task_stack_usage(const char* task_name) {
-    TaskHandle_t task = xTaskGetHandle(task_name);
-    if (task != NULL) {
-        for (size_t i = 0; i < NUM_TASKS; i++) {
-            if (strcmp(task_stack_usage[i].task_name, task_name) == 0) {
-                task_stack_usage[i].high_water_mark = uxTaskGetStackHighWaterMark(task);
-                break;
-            }
-        }
-    }
+// Fetch as soon as an address is bound rather than sitting out a refresh or
+// backoff delay that began while the link was down
+static void on_wifi_event(WifiEvent event) {
+	if (event == WIFI_EVENT_LINK_UP) {
+		boot_timeline_mark(BOOT_MARK_LINK_UP);
+	}
+	if (event == WIFI_EVENT_IP_BOUND) {
+		boot_timeline_mark(BOOT_MARK_IP_BOUND);
+		power_request_refresh();
+	}
 }
 
-// Function to print stack usage for all tasks
-void print_task_stack_usage() {
-    printf("\nTask Stack Usage Report:\n");
-    printf("----------------------\n");
-    for (size_t i = 0; i < NUM_TASKS; i++) {
-        UBaseType_t stack_size_bytes = task_stack_usage[i].stack_size * sizeof(StackType_t);
-        UBaseType_t high_water_bytes = task_stack_usage[i].high_water_mark * sizeof(StackType_t);
-        UBaseType_t used_bytes = stack_size_bytes - high_water_bytes;
-        float usage_percent = (float)used_bytes / stack_size_bytes * 100.0f;
-        
-        printf("%s:\n", task_stack_usage[i].task_name);
-        printf("  Stack Size: %d bytes\n", stack_size_bytes);
-        printf("  High Water Mark: %d bytes\n", high_water_bytes);
-        printf("  Used: %d bytes (%.1f%%)\n", used_bytes, usage_percent);
-        printf("  Free: %d bytes\n", high_water_bytes);
-        printf("----------------------\n");
-    }
+// Console command: dump the kernel trace for tools/trace2json, or control it
+static void cmd_trace(int argc, char **argv) {
+	if (argc < 2) {
+		trace_buffer_dump();
+	} else if (strcmp(argv[1], "start") == 0) {
+		trace_buffer_enable(true);
+	} else if (strcmp(argv[1], "stop") == 0) {
+		trace_buffer_enable(false);
+	} else if (strcmp(argv[1], "clear") == 0) {
+		trace_buffer_clear();
+	} else {
+		printf("usage: trace [start|stop|clear]\n");
+	}
 }
 
+// With tickless idle the kernel suppresses the tick and sleeps once this
+// returns. Without it, as with two cores (see FreeRTOSConfig.h) or in the
+// simulator, each core's idle task waits for its next interrupt here.
 void vApplicationIdleHook(void) {
-	ulIdleCycleCount++;
-
-	/* Example: Enter a low-power sleep mode.
-	 * The specifics of HAL_PWR_EnterSLEEPMode are MCU-dependent.
-	 * Ensure interrupts can wake the MCU.
-	 */
-	// HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+#if !configUSE_TICKLESS_IDLE
+	sleep_stats_idle();
+#endif
 }
 
+#if configNUMBER_OF_CORES > 1
+void vApplicationPassiveIdleHook(void) { sleep_stats_idle(); }
+#endif
+
 void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName) {
 	(void)pcTaskName;
 	(void)xTask;
@@ -91,7 +132,7 @@ void vApplicationMallocFailedHook(void) {
 // Turn led on or off
 static void pico_set_led(bool led_on) {
 	const char *str = led_on ? "on" : "off";
-	printf("LED %s\n", str);
+	DLOG_DEBUG("LED %s\n", str);
 	cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, led_on);
 }
 
@@ -99,89 +140,22 @@ void blink_task(__unused void *params) {
 	bool on = false;
 	printf("blink_task starts\n");
 	while (true) {
-		static int last_core_id = -1;
-		if (portGET_CORE_ID() != last_core_id) {
-			last_core_id = portGET_CORE_ID();
-			printf("blink task is on core %d\n", last_core_id);
+		// Each toggle is a bus transaction to the Wi-Fi chip, so keep the
+		// LED dark and poll slowly while the market is closed
+		if (power_low_power()) {
+			if (on) {
+				pico_set_led(false);
+				on = false;
+			}
+			sleep_ms(LED_LOW_POWER_DELAY);
+			continue;
 		}
-		update_task_stack_usage("BlinkThread");
 		pico_set_led(on);
 		on = !on;
 		sleep_ms(LED_DELAY); // TODO: vary the LED with WiFi Connection
 	}
 }
 
-void wifi_task(__unused void *params) {
-	printf("wifi_task starts\n");
-
-	// Enable wifi station
-	cyw43_arch_enable_sta_mode();
-
-	bool notified_http_task =
-	    false; // Ensure we only signal once per connection
-
-	while (true) {
-		static int last_core_id = -1;
-
-		if (portGET_CORE_ID() != last_core_id) {
-			last_core_id = portGET_CORE_ID();
-			printf("wifi task is on core %d\n", last_core_id);
-		}
-
-		int status = cyw43_wifi_link_status(&cyw43_state, CYW43_ITF_STA);
-		switch (status) {
-		case CYW43_LINK_JOIN:
-			printf("WiFi is connected\n");
-			if (!notified_http_task && wifi_connected_sem != NULL) {
-				printf("wifi_task: Signaling http_get_task that Wi-Fi is "
-				       "connected.\n");
-				xSemaphoreGive(wifi_connected_sem);
-				notified_http_task = true;
-			}
-			break;
-		case CYW43_LINK_DOWN:
-			printf("WiFi disconnected\n");
-			notified_http_task = false; // Allow re-notification on next connect
-			break;
-		case CYW43_LINK_FAIL:
-			printf("Connection failed\n");
-			notified_http_task = false;
-			break;
-		case CYW43_LINK_NONET:
-			printf("WiFi not found\n");
-			break;
-		case CYW43_LINK_BADAUTH:
-			printf("WiFi authentication failed\n");
-			break;
-		default:
-			printf("WiFi link status is unknown\n");
-		}
-
-		printf("status: %d\n", status);
-
-		if (status == CYW43_LINK_FAIL || status == CYW43_LINK_DOWN ||
-		    status == CYW43_LINK_NONET) {
-			printf("Retrying...\n");
-			cyw43_arch_wifi_connect_timeout_ms(
-			    ssid, password, CYW43_AUTH_WPA2_AES_PSK, timeout);
-		} else if (status == CYW43_LINK_JOIN) {
-			printf("Connected.\n");
-			// Read the ip address in a human readable way
-			static uint8_t *ip_address =
-			    (uint8_t *)&(cyw43_state.netif[0].ip_addr.addr);
-			printf("IP address %d.%d.%d.%d\n", ip_address[0], ip_address[1],
-			       ip_address[2], ip_address[3]);
-		} else {
-			break; // * Error Unrecoverable. Kill the task
-		}
-
-		vTaskDelay(pdMS_TO_TICKS(status == CYW43_LINK_JOIN ? 10000 : 1000));
-		update_task_stack_usage("WiFiThread");
-	}
-
-	vTaskDelete(NULL);
-}
-
 // Buffer for MessagePack encoded messages
 static char message_buffer[1024]; // Larger buffer to hold all messages
 static uint8_t response_buffer[1024];
@@ -223,16 +197,21 @@ static CommandError send_command(TLS_CLIENT_HANDLE handle, const char *command,
 	    message_buffer, message_buffer_size, command, payload);
 	message_buffer[cmd_len] = '\0';
 
-	printf("Sending command '%s' (%d bytes)\n", command, cmd_len);
+	DLOG_DEBUG("Sending command '%s' (%d bytes)\n", command, cmd_len);
 
+	uint32_t start_us = time_us_32();
 	int recv_len =
 	    tls_client_send_and_recv(handle, (uint8_t *)message_buffer, cmd_len,
 	                             recv_buffer, recv_buffer_size,
 	                             5000 // 5 second timeout per command
 	    );
+	if (recv_len > 0) {
+		net_stats_record(net_stats_rtt_metric(command),
+		                 time_us_32() - start_us);
+	}
 
 	if (recv_len <= 0) {
-		printf("Error receiving command response: %d\n", recv_len);
+		DLOG_WARN("Error receiving command response: %d\n", recv_len);
 		return CMD_RECV_ERROR;
 	}
 
@@ -244,7 +223,7 @@ static CommandError send_command(TLS_CLIENT_HANDLE handle, const char *command,
 	message_buffer[0] = '\0';
 
 	if (error) {
-		printf("MessagePack deserialization failed: %s\n", error.c_str());
+		DLOG_WARN("MessagePack deserialization failed: %s\n", error.c_str());
 		return CMD_DESERIALIZE_ERROR;
 	}
 
@@ -257,11 +236,56 @@ static CommandError send_command(TLS_CLIENT_HANDLE handle, const char *command,
 	return CMD_SUCCESS;
 }
 
+// Day of the week, 0 = Sunday, for a Gregorian date (Sakamoto's method)
+static int day_of_week(int year, int month, int day) {
+	static const int offsets[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+	if (month < 3) {
+		year--;
+	}
+	return (year + year / 4 - year / 100 + year / 400 + offsets[month - 1] +
+	        day) %
+	       7;
+}
+
+// Days from 1970-01-01 to a Gregorian date
+static int32_t days_from_civil(int year, int month, int day) {
+	year -= month <= 2;
+	int era = (year >= 0 ? year : year - 399) / 400;
+	int year_of_era = year - era * 400;
+	int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 +
+	                 day_of_year;
+	return era * 146097 + day_of_era - 719468;
+}
+
+// A candle's "Date" as seconds since the epoch, parsed once as the data
+// arrives so nothing downstream handles strings. The server sends an integer;
+// "YYYY-MM-DD HH:MM:SS" text, as pandas writes it, is read as UTC. 0 when the
+// point has neither.
+static uint32_t parse_candle_time(JsonVariantConst date) {
+	if (date.is<uint32_t>()) {
+		return date.as<uint32_t>();
+	}
+	const char *text = date.as<const char *>();
+	if (text == nullptr) {
+		return 0;
+	}
+	int year, month, day;
+	int hour = 0, min = 0, sec = 0;
+	if (sscanf(text, "%d-%d-%d%*c%d:%d:%d", &year, &month, &day, &hour, &min,
+	           &sec) < 3 ||
+	    month < 1 || month > 12) {
+		return 0;
+	}
+	int64_t seconds = (int64_t)days_from_civil(year, month, day) * 86400 +
+	                  hour * 3600 + min * 60 + sec;
+	return seconds > 0 && seconds <= UINT32_MAX ? (uint32_t)seconds : 0;
+}
+
 // Function to parse server time string and set RTC time
 static bool parse_and_set_rtc_time(const char *time_str) {
 	// Expected format: "YYYY-MM-DD HH:MM:SS TZ"
 	int year, month, day, hour, min, sec;
-	int dotw = 1;
 	char tz[4];
 
 	// Parse the time string
@@ -270,6 +294,12 @@ static bool parse_and_set_rtc_time(const char *time_str) {
 		printf("Failed to parse time string: %s\n", time_str);
 		return false;
 	}
+	if (month < 1 || month > 12) {
+		printf("Invalid month in time string: %s\n", time_str);
+		return false;
+	}
+	// The low power schedule needs the weekday
+	int dotw = day_of_week(year, month, day);
 
 	// Create datetime_t struct
 	datetime_t t = {
@@ -288,8 +318,8 @@ static bool parse_and_set_rtc_time(const char *time_str) {
 		return false;
 	}
 
-	printf("Successfully set RTC time to: %04d-%02d-%02d %02d:%02d:%02d %s\n",
-	       t.year, t.month, t.day, t.hour, t.min, t.sec, tz);
+	DLOG_INFO("Set RTC time to %04d-%02d-%02d %02d:%02d:%02d\n", t.year,
+	          t.month, t.day, t.hour, t.min, t.sec);
 	return true;
 }
 
@@ -314,74 +344,100 @@ static bool parse_stock_data(JsonDocument &response_doc,
 	strncpy(stock_data.duration, duration, sizeof(stock_data.duration) - 1);
 	stock_data.duration[sizeof(stock_data.duration) - 1] = '\0';
 
-	// Clear existing history
-	stock_data.history_len = 0;
+	// Start a fresh series; past its capacity the oldest points give way, so
+	// a long series keeps its most recent stretch
+	const StockCandles &history = stock_data.history;
+	clear_candles(stock_data);
 
 	// Process each data point
 	for (const JsonObject &data_point : data_array) {
-		if (stock_data.history_len >= 30) { // Maximum history size
-			break;
-		}
-
-		OHLC &ohlc = stock_data.history[stock_data.history_len];
-		ohlc.open = data_point["Open"];
-		ohlc.high = data_point["High"];
-		ohlc.low = data_point["Low"];
-		ohlc.close = data_point["Close"];
-
-		// Store timestamp
-		const char *timestamp_str = data_point["Date"];
-		strncpy(stock_data.timestamp, timestamp_str,
-		        sizeof(stock_data.timestamp) - 1);
-		stock_data.timestamp[sizeof(stock_data.timestamp) - 1] = '\0';
-
-		// Update current price and other metrics
-		if (stock_data.history_len == 0) {
-			stock_data.open_price = ohlc.open;
-			stock_data.high_price = ohlc.high;
-			stock_data.low_price = ohlc.low;
-		} else {
-			stock_data.high_price = std::max(stock_data.high_price, ohlc.high);
-			stock_data.low_price = std::min(stock_data.low_price, ohlc.low);
-		}
+		Candle candle;
+		candle.time = parse_candle_time(data_point["Date"]);
+		candle.open = data_point["Open"];
+		candle.high = data_point["High"];
+		candle.low = data_point["Low"];
+		candle.close = data_point["Close"];
+		candle.volume = data_point["Volume"] | 0.0f;
+		append_candle(stock_data, candle);
+	}
 
-		stock_data.current_price = ohlc.close;
-		stock_data.history_len++;
+	if (history.empty()) {
+		return false;
 	}
 
+	// Summary figures over the points kept
+	stock_data.open_price = history.front().open;
+	stock_data.high_price = history.max_high();
+	stock_data.low_price = history.min_low();
+	stock_data.current_price = history.back().close;
+
 	// Calculate price changes
-	if (stock_data.history_len > 0) {
-		stock_data.price_change =
-		    stock_data.current_price - stock_data.open_price;
-		stock_data.percent_change =
-		    (stock_data.price_change / stock_data.open_price) * 100.0f;
+	stock_data.price_change = stock_data.current_price - stock_data.open_price;
+	stock_data.percent_change =
+	    (stock_data.price_change / stock_data.open_price) * 100.0f;
+
+	return true;
+}
+
+// Bring up the Wi-Fi chip and start joining the network. Runs on the network
+// core while the render core brings up the display, as loading the chip's
+// firmware takes a while.
+static bool start_network() {
+	// The driver task is pinned to the network core through
+	// ASYNC_CONTEXT_DEFAULT_FREERTOS_TASK_CORE_ID
+	if (cyw43_arch_init()) {
+		printf("Wi-Fi init failed\n");
+		return false;
 	}
+	boot_timeline_mark(BOOT_MARK_WIFI_CHIP);
+	task_registry_add(pin_task_by_name(TCPIP_THREAD_NAME, NETWORK_CORE_MASK),
+	                  TCPIP_THREAD_STACKSIZE);
 
-	return stock_data.history_len > 0;
+	// start the led blinking
+	task_registry_create(blink_task, "BlinkThread", BLINK_TASK_STACK_SIZE,
+	                     BLINK_TASK_PRIORITY, NETWORK_CORE_MASK, NULL);
+	wifi_supervisor_subscribe(on_wifi_event);
+	wifi_supervisor_init(ssid, password, NETWORK_CORE_MASK);
+	return true;
 }
 
 void tls_client_task(__unused void *params) {
 	printf("tls_client_task starts\n");
-	xSemaphoreTake(wifi_connected_sem, portMAX_DELAY);
+	if (!start_network()) {
+		vTaskDelete(NULL);
+		return;
+	}
+	wifi_supervisor_wait_connected();
+	// Never before the boot frame, which main publishes from this snapshot
+	xSemaphoreTake(boot_frame_ready_sem, portMAX_DELAY);
 	printf("WiFi connected, starting TLS client test\n");
 
+	connection_manager_add_endpoint(TLS_CLIENT_SERVER, TLS_CLIENT_PORT,
+	                                TLS_CLIENT_SNI);
+#ifdef TLS_CLIENT_FALLBACK_SERVER
+	connection_manager_add_endpoint(TLS_CLIENT_FALLBACK_SERVER,
+	                                TLS_CLIENT_FALLBACK_PORT, TLS_CLIENT_SNI);
+#endif
+
 	while (true) {
-		static int last_core_id = -1;
-		if (portGET_CORE_ID() != last_core_id) {
-			last_core_id = portGET_CORE_ID();
-			printf("tls client task is on core %d\n", last_core_id);
+		// Pause while the link is down. Failures during the outage say
+		// nothing about the servers, so start afresh once it is back.
+		if (!wifi_supervisor_connected()) {
+			DLOG_INFO("Wi-Fi down, pausing fetches\n");
+			wifi_supervisor_wait_connected();
+			connection_manager_reset_backoff();
 		}
-		update_task_stack_usage("TLSClientThread");
-		// Add stack usage report after each connection cycle
-		print_task_stack_usage();
 
-		// Initialize and connect to the server
-		TLS_CLIENT_HANDLE handle = tls_client_init_and_connect(
-		    TLS_CLIENT_SERVER, TLS_CLIENT_PORT, cert_ok, sizeof(cert_ok));
+		// Connect to the healthiest server, failing over if needed
+		TLS_CLIENT_HANDLE handle =
+		    connection_manager_connect(cert_ok, sizeof(cert_ok));
 
 		if (!handle) {
-			printf("Failed to connect to TLS server\n");
-			vTaskDelay(pdMS_TO_TICKS(5000)); // Wait before retry
+			uint32_t delay_ms = connection_manager_retry_delay_ms();
+			DLOG_WARN("Failed to connect to TLS server, retrying in %lu ms\n",
+			          delay_ms);
+			connection_manager_print_status();
+			power_wait_for_refresh(delay_ms);
 			continue;
 		}
 
@@ -390,19 +446,24 @@ void tls_client_task(__unused void *params) {
 		    generate_auth_request(message_buffer, sizeof(message_buffer));
 		message_buffer[auth_len] = '\0';
 
-		printf("Sending auth request (%d bytes)\n", auth_len);
+		DLOG_DEBUG("Sending auth request (%d bytes)\n", auth_len);
 
 		// Send auth request and receive response
+		uint32_t auth_start_us = time_us_32();
 		int recv_len = tls_client_send_and_recv(
 		    handle, (uint8_t *)message_buffer, auth_len, response_buffer,
 		    sizeof(response_buffer),
 		    5000 // 5 second timeout for auth
 		);
+		if (recv_len > 0) {
+			net_stats_record(NET_METRIC_RTT_AUTH, time_us_32() - auth_start_us);
+		}
 
 		if (recv_len <= 0) {
-			printf("Error receiving auth response: %d\n", recv_len);
+			DLOG_WARN("Error receiving auth response: %d\n", recv_len);
 			tls_client_close(handle);
-			vTaskDelay(pdMS_TO_TICKS(5000));
+			connection_manager_report_failure();
+			power_wait_for_refresh(connection_manager_retry_delay_ms());
 			continue;
 		}
 
@@ -415,13 +476,17 @@ void tls_client_task(__unused void *params) {
 		message_buffer[0] = '\0';
 
 		if (error) {
-			printf("MessagePack deserialization failed: %s\n", error.c_str());
-		} else {
+			DLOG_WARN("MessagePack deserialization failed: %s\n",
+			          error.c_str());
+		}
+#ifdef DEBUG
+		else {
 			printf("Deserialized response:\n");
 			serializeJsonPretty(response_doc, message_buffer,
 			                    sizeof(message_buffer));
 			printf("%s\n", message_buffer);
 		}
+#endif
 		response_doc.clear();
 
 		// Prepare array of commands to send
@@ -434,6 +499,7 @@ void tls_client_task(__unused void *params) {
 		                      {"get_time", JsonVariant()}};
 
 		// Send each command one by one
+		bool session_ok = true;
 		for (const auto &cmd : commands) {
 			CommandError err =
 			    send_command(handle, cmd.name, cmd.payload, response_buffer,
@@ -441,7 +507,8 @@ void tls_client_task(__unused void *params) {
 			                 message_buffer, sizeof(message_buffer));
 
 			if (err != CMD_SUCCESS) {
-				printf("Command '%s' failed with error %d\n", cmd.name, err);
+				DLOG_WARN("Command '%s' failed with error %d\n", cmd.name, err);
+				session_ok = false;
 				break;
 			}
 
@@ -449,7 +516,9 @@ void tls_client_task(__unused void *params) {
 			if (strcmp(cmd.name, "get_time") == 0) {
 				const char *server_time = response_doc["server_time"];
 				if (server_time) {
-					if (!parse_and_set_rtc_time(server_time)) {
+					if (parse_and_set_rtc_time(server_time)) {
+						render_scheduler_resync_clock();
+					} else {
 						printf("Failed to set RTC time from server response\n");
 					}
 				} else {
@@ -466,119 +535,285 @@ void tls_client_task(__unused void *params) {
 			vTaskDelay(pdMS_TO_TICKS(100));
 		}
 
-		// Send the get_stock_data command separately
-		JsonDocument doc;
-		doc["command"] = "get_stock_data";
-		doc["ticker"] = "AAPL";
-		doc["duration"] = "1d";
-		doc["interval"] = "1h";
-
-		CommandError err =
-		    send_command(handle, "get_stock_data", doc, response_buffer,
-		                 sizeof(response_buffer), response_doc, message_buffer,
-		                 sizeof(message_buffer));
-
-		if (err != CMD_SUCCESS) {
-			printf("Command 'get_stock_data' failed with error %d\n", err);
-		}
-		extern StockData stock_data;
+		// Then the watchlist, one get_stock_data per symbol. Each is parsed
+		// into the snapshot's write buffer and kept in the watchlist; only
+		// the first symbol's is published for the display.
+		size_t symbols = watchlist_size();
+		for (size_t i = 0; i < symbols; i++) {
+			char ticker[StockWatchlist::MAX_SYMBOL_LENGTH + 1];
+			if (!watchlist_symbol(i, ticker, sizeof(ticker))) {
+				break;
+			}
 
-		if (parse_stock_data(response_doc, stock_data)) {
-			printf("Received %d data points for %s\n", stock_data.history_len,
-			       stock_data.symbol);
+			JsonDocument doc;
+			doc["command"] = "get_stock_data";
+			doc["ticker"] = ticker;
+			doc["duration"] = "1d";
+			doc["interval"] = "1h";
 
-			// Process the stock data as needed
-			printf("Current Price: %.2f, Change: %.2f (%.2f%%)\n",
-			       stock_data.current_price, stock_data.price_change,
-			       stock_data.percent_change);
+			CommandError err =
+			    send_command(handle, "get_stock_data", doc, response_buffer,
+			                 sizeof(response_buffer), response_doc,
+			                 message_buffer, sizeof(message_buffer));
 
-			// Update the display with the new data
-			update_display(stock_data);
-		} else {
-			printf("Failed to parse stock data\n");
+			if (err != CMD_SUCCESS) {
+				DLOG_WARN("Command 'get_stock_data' failed with error %d\n",
+				          err);
+				session_ok = false;
+				break;
+			}
+			// The renderer only sees the slot once it is complete and
+			// published
+			StockData &fetched = stock_snapshot.write_buffer();
+
+			if (parse_stock_data(response_doc, fetched)) {
+				// The symbol lives in a buffer that gets reused, so it can't
+				// go into a deferred log record
+				DLOG_INFO("Received %d data points\n",
+				          (int)fetched.history.size());
+				DLOG_INFO("Current Price: %.2f, Change: %.2f (%.2f%%)\n",
+				          fetched.current_price, fetched.price_change,
+				          fetched.percent_change);
+				watchlist_record(fetched);
+				flash_cache_save(fetched);
+				boot_timeline_mark(BOOT_MARK_FIRST_FETCH);
+
+				// Let the render loop pick up the new data
+				if (i == 0) {
+					stock_snapshot.publish();
+					render_scheduler_notify(RENDER_EVENT_DATA_UPDATED);
+				}
+			} else {
+				DLOG_WARN("Failed to parse stock data\n");
+			}
+			response_doc.clear();
 		}
-		response_doc.clear();
 
 		// Close the connection
 		tls_client_close(handle);
 
-		// Wait before next attempt
-		vTaskDelay(pdMS_TO_TICKS(5000)); // 5 second delay between attempts
+		if (session_ok) {
+			connection_manager_report_success();
+		} else {
+			connection_manager_report_failure();
+		}
+
+		// Wait before next attempt, backing off while the server misbehaves.
+		// Outside trading hours the wait is much longer, cut short by the
+		// market opening or a button press.
+		uint32_t delay_ms =
+		    session_ok ? power_refresh_interval_ms(TLS_CLIENT_REFRESH_MS)
+		               : connection_manager_retry_delay_ms();
+		power_wait_for_refresh(delay_ms);
 	}
+	cyw43_arch_deinit();
 	vTaskDelete(NULL);
 }
 
-void main_task(__unused void *params) {
-	rtc_init();
+// What the buttons control, owned by the render loop
+struct UiState {
+	bool show_diagnostics = false;
+	ChartView view;
+	// Buttons whose current hold has been used up, by waking the screen or
+	// by a long press, and is ignored until they are released
+	uint8_t spent_holds = 0;
+	// Pan when Y went down, for taking back what its repeats did before the
+	// hold turned into a long press
+	int pan_before_y = 0;
+};
 
-	// Initialise the Wi-Fi chip
-	if (cyw43_arch_init()) {
-		printf("Wi-Fi init failed\n");
+// Apply one button event to the UI state. A and B zoom the chart in and
+// out, X and Y pan it back and forward, repeating while held, and holding Y
+// switches to the diagnostics page and back.
+static void handle_button_event(const ButtonEvent &event, UiState &ui) {
+	uint8_t bit = 1u << event.button;
+	if (event.type == BUTTON_EVENT_RELEASE) {
+		ui.spent_holds &= ~bit;
+		return;
+	}
+	if (ui.spent_holds & bit) {
+		return;
+	}
+	if (event.button == BUTTON_Y) {
+		if (event.type == BUTTON_EVENT_PRESS) {
+			ui.pan_before_y = ui.view.pan;
+		} else if (event.type == BUTTON_EVENT_LONG_PRESS) {
+			if (!ui.show_diagnostics) {
+				ui.view.pan = ui.pan_before_y;
+			}
+			ui.show_diagnostics = !ui.show_diagnostics;
+			ui.spent_holds |= bit;
+			return;
+		}
+	}
+	if (ui.show_diagnostics) {
 		return;
 	}
+	ChartView &view = ui.view;
+	bool press = event.type == BUTTON_EVENT_PRESS;
+	bool step = press || event.type == BUTTON_EVENT_REPEAT;
+
+	// Zooming keeps the right edge of the chart at about the same time. The
+	// view is clamped to the data before drawing.
+	switch (event.button) {
+	case BUTTON_A:
+		if (press) {
+			view.zoom++;
+			view.pan *= 2;
+		}
+		break;
+	case BUTTON_B:
+		if (press) {
+			view.zoom--;
+			view.pan /= 2;
+		}
+		break;
+	case BUTTON_X:
+		if (step) {
+			view.pan += CHART_PAN_STEP;
+		}
+		break;
+	case BUTTON_Y:
+		if (step) {
+			view.pan -= CHART_PAN_STEP;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void main_task(__unused void *params) {
+	boot_timeline_mark(BOOT_MARK_TASKS_STARTED);
+	rtc_init();
+	task_registry_add(xTimerGetTimerDaemonTaskHandle(),
+	                  configTIMER_TASK_STACK_DEPTH);
+
+	core_load_init();
+
+	net_stats_init();
+	dlog_init();
+
+	// Serial console on USB stdio, and the CPU/heap sampler behind it
+	console_init();
+	console_register("net", "network stats ('net reset' clears)", cmd_net);
+	console_register("trace", "dump kernel trace [start|stop|clear]",
+	                 cmd_trace);
+	sys_monitor_init();
+	power_init();
+	boot_timeline_init();
+	watchlist_init(WATCHLIST_SYMBOLS);
 
 	// Create semaphores before starting tasks that use them
+#if STATIC_ALLOCATION
+	http_request_complete_sem =
+	    xSemaphoreCreateBinaryStatic(&http_request_complete_sem_buffer);
+#else
 	http_request_complete_sem = xSemaphoreCreateBinary();
+#endif
 	if (http_request_complete_sem == NULL) {
 		printf("Failed to create http_request_complete_sem\n");
 	}
-
-	wifi_connected_sem = xSemaphoreCreateBinary();
-	if (wifi_connected_sem == NULL) {
-		printf("Failed to create wifi_connected_sem\n");
+	trace_buffer_name_object(http_request_complete_sem, "http_complete_sem");
+#if STATIC_ALLOCATION
+	boot_frame_ready_sem =
+	    xSemaphoreCreateBinaryStatic(&boot_frame_ready_sem_buffer);
+#else
+	boot_frame_ready_sem = xSemaphoreCreateBinary();
+#endif
+	if (boot_frame_ready_sem == NULL) {
+		printf("Failed to create boot_frame_ready_sem\n");
+	}
+	trace_buffer_name_object(boot_frame_ready_sem, "boot_frame_sem");
+
+	// The last data fetched before the reboot, or placeholder data if flash
+	// has none, until the first fetch. The cache is read back before the
+	// network task exists, so its first save can't race the scan.
+	StockData &boot_data = stock_snapshot.write_buffer();
+	if (!flash_cache_init(boot_data)) {
+		initialize_stock_data(boot_data);
 	}
+	boot_timeline_mark(BOOT_MARK_CACHE);
+
+	// The network core loads the Wi-Fi chip's firmware and starts joining
+	// while this core brings up the display and puts the cached data on it
+	task_registry_create(tls_client_task, "TLSClientThread",
+	                     HTTP_GET_TASK_STACK_SIZE, HTTP_GET_TASK_PRIORITY,
+	                     NETWORK_CORE_MASK, NULL);
 
 	// Initialize display
 	initialize_display();
+	boot_timeline_mark(BOOT_MARK_DISPLAY);
+	render_scheduler_init();
 
-	// Create stock data structure
-	extern StockData stock_data;
-	initialize_stock_data(stock_data);
+	// The boot data is drawn straight away, and only then is the TLS task
+	// let at the snapshot, so main is briefly the producer
+	stock_snapshot.publish();
+	stock_snapshot.acquire();
+	update_display(stock_snapshot.read_buffer(), ChartView());
+	boot_timeline_mark(BOOT_MARK_FIRST_PIXEL);
+	xSemaphoreGive(boot_frame_ready_sem);
 
-	// start the led blinking
-	xTaskCreate(blink_task, "BlinkThread", BLINK_TASK_STACK_SIZE, NULL,
-	            BLINK_TASK_PRIORITY, NULL);
-	xTaskCreate(wifi_task, "WiFiThread", WIFI_TASK_STACK_SIZE, NULL,
-	            WIFI_TASK_PRIORITY, NULL);
-	xTaskCreate(tls_client_task, "TLSClientThread", HTTP_GET_TASK_STACK_SIZE,
-	            NULL, HTTP_GET_TASK_PRIORITY, NULL);
+	button_events_init();
+
+	UiState ui;
+	// Set once a snapshot from the TLS task has been picked up
+	bool live = false;
 
 	while (true) {
-		static int last_core_id = -1;
-		if (portGET_CORE_ID() != last_core_id) {
-			last_core_id = portGET_CORE_ID();
-			printf("main task is on core %d\n", last_core_id);
+		// Sleep until something changes. The diagnostics page has no change
+		// events of its own, so refresh it once a second while it is shown.
+		TickType_t timeout = power_update();
+		if (ui.show_diagnostics &&
+		    timeout > pdMS_TO_TICKS(DIAGNOSTICS_REFRESH_MS)) {
+			timeout = pdMS_TO_TICKS(DIAGNOSTICS_REFRESH_MS);
 		}
+		EventBits_t events = render_scheduler_wait(timeout);
 
-		update_task_stack_usage("MainThread");
-		// Update the display with current stock data
-		update_display(stock_data);
+		// Switch to the newest stock data the network core has published
+		if ((events & RENDER_EVENT_DATA_UPDATED) && stock_snapshot.acquire()) {
+			live = true;
+		}
 
 		// Handle button inputs
-		if (button_a.raw()) {
-			// TODO: Implement button A functionality
-		}
-		if (button_b.raw()) {
-			// TODO: Implement button B functionality
-		}
-		if (button_x.raw()) {
-			// TODO: Implement button X functionality
+		if (events & RENDER_EVENT_BUTTON) {
+			ButtonEvent event;
+			while (button_events_get(event)) {
+				// A press on a dark screen only wakes it, repeats and all
+				if (event.type == BUTTON_EVENT_PRESS && power_user_activity()) {
+					ui.spent_holds |= 1u << event.button;
+					continue;
+				}
+				handle_button_event(event, ui);
+			}
 		}
-		if (button_y.raw()) {
-			// TODO: Implement button Y functionality
+
+		// Nothing to draw while the backlight is off
+		if (!power_display_on()) {
+			continue;
 		}
 
-		vTaskDelay(10);
+		// Update the display with current stock data, or the network
+		// diagnostics page while it is toggled on
+		if (ui.show_diagnostics) {
+			update_diagnostics_display();
+		} else {
+			const StockData &data = stock_snapshot.read_buffer();
+			clamp_chart_view(data, ui.view);
+			update_display(data, ui.view);
+			if (live && boot_timeline_mark(BOOT_MARK_FIRST_LIVE)) {
+				boot_timeline_print();
+			}
+		}
 	}
 
-	cyw43_arch_deinit();
 	vTaskDelete(NULL);
 }
 
 void vLaunch(void) {
 	TaskHandle_t task;
-	xTaskCreate(main_task, "MainThread", MAIN_TASK_STACK_SIZE, NULL,
-	            MAIN_TASK_PRIORITY, &task);
+	task_registry_create(main_task, "MainThread", MAIN_TASK_STACK_SIZE,
+	                     MAIN_TASK_PRIORITY, RENDER_CORE_MASK, &task);
 
 	/* Start the tasks and timer running. */
 	vTaskStartScheduler();
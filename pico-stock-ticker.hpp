@@ -14,6 +14,7 @@
 #include "FreeRTOS.h"
 #include "semphr.h"
 #include "task.h"
+#include "timers.h"
 
 #include "lwip/altcp_tls.h"
 #include "lwip/netif.h"
@@ -23,25 +24,51 @@ const char *password = WIFI_PASSWORD;
 const char *api_key = API_KEY;
 
 const uint32_t SPI_FREQ = 1000 * 1000;
-const uint32_t timeout = 30000;
 
 const uint32_t LED_DELAY = 100;
+const uint32_t LED_LOW_POWER_DELAY = 5000;
+
+// Diagnostics page refresh period
+#define DIAGNOSTICS_REFRESH_MS 1000
 
 // Priorities of our threads - higher numbers are higher priority
 #define MAIN_TASK_PRIORITY (tskIDLE_PRIORITY + 2UL)
 #define BLINK_TASK_PRIORITY (tskIDLE_PRIORITY + 1UL)
-#define WIFI_TASK_PRIORITY (tskIDLE_PRIORITY + 3UL)
 #define HTTP_GET_TASK_PRIORITY (tskIDLE_PRIORITY + 4UL)
 
+// Core placement: Wi-Fi, lwIP and TLS on one core, rendering, frame
+// conversion and display DMA on the other, so a handshake never stalls a frame
+#ifndef NETWORK_CORE
+#define NETWORK_CORE 0
+#endif
+#ifndef RENDER_CORE
+#define RENDER_CORE 1
+#endif
+#define NETWORK_CORE_MASK (1u << NETWORK_CORE)
+#define RENDER_CORE_MASK (1u << RENDER_CORE)
+
 // Stack sizes of our threads in words (4 bytes)
 #define MAIN_TASK_STACK_SIZE configMINIMAL_STACK_SIZE
 #define BLINK_TASK_STACK_SIZE configMINIMAL_STACK_SIZE
-#define WIFI_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
 #define HTTP_GET_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 8)
 
+// The simulator build points these at a local server
+#ifndef TLS_CLIENT_SERVER
 #define TLS_CLIENT_SERVER                                                      \
-	"192.168.0.41"           // Change this to your server's IP or hostname
+	"192.168.0.41" // Change this to your server's IP or hostname
+#endif
+#ifndef TLS_CLIENT_PORT
 #define TLS_CLIENT_PORT 8443 // Server listens on port 8443
+#endif
+#define TLS_CLIENT_SNI "server.local" // Must match the server certificate
+// Define TLS_CLIENT_FALLBACK_SERVER/PORT to fail over to a second server
+// #define TLS_CLIENT_FALLBACK_SERVER "192.168.0.42"
+// #define TLS_CLIENT_FALLBACK_PORT 8443
+#define TLS_CLIENT_REFRESH_MS 5000 // Delay between successful fetches
+// Comma separated tickers to fetch each refresh; the first is shown
+#ifndef WATCHLIST_SYMBOLS
+#define WATCHLIST_SYMBOLS "AAPL"
+#endif
 #define TLS_CLIENT_AUTH_TOKEN                                                  \
 	"supersecretclienttoken12345abcdef" // Must match server's CLIENT_AUTH_TOKEN
 
@@ -76,17 +103,3 @@ enum CommandError {
 	CMD_RECV_ERROR = -2,
 	CMD_DESERIALIZE_ERROR = -3
 };
-
-// Stack usage tracking structure
-struct TaskStackUsage {
-    const char* task_name;
-    UBaseType_t stack_size;
-    UBaseType_t high_water_mark;
-};
-
-// Global array to store stack usage data
-extern TaskStackUsage task_stack_usage[];
-extern const size_t NUM_TASKS;
-
-// Function to print stack usage
-void print_task_stack_usage();
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "power.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+#include "hardware/rtc.h"
+#include "pico/util/datetime.h"
+#include "task.h"
+
+#include "console.hpp"
+#include "display.hpp"
+#include "dlog.h"
+#include "render_scheduler.hpp"
+#include "sleep_stats.h"
+
+static std::atomic<bool> low_power{false};
+static std::atomic<bool> backlight_on{true};
+static std::atomic<TaskHandle_t> refresh_waiter{nullptr};
+
+// Only touched by the render loop
+static TickType_t backlight_off_tick = 0;
+static bool alarm_armed = false;
+
+// Baseline for the next "power" report, only touched by the console task
+static SleepStatsSnapshot last_report;
+
+// Until the RTC has been set there is no schedule to follow
+static bool market_hours() {
+	datetime_t now;
+	if (!rtc_running() || !rtc_get_datetime(&now)) {
+		return true;
+	}
+	if (now.dotw == 0 || now.dotw == 6) {
+		return false;
+	}
+	int minute = now.hour * 60 + now.min;
+	return minute >= POWER_MARKET_OPEN_MINUTE &&
+	       minute < POWER_MARKET_CLOSE_MINUTE;
+}
+
+static void set_backlight_on(bool on) {
+	set_backlight(on ? POWER_BACKLIGHT_LEVEL : 0);
+	backlight_on = on;
+	// Nobody reads the clock on a dark screen, so stop its minute timer
+	if (on) {
+		render_scheduler_resync_clock();
+	} else {
+		render_scheduler_stop_clock();
+	}
+}
+
+void power_request_refresh() {
+	TaskHandle_t waiter = refresh_waiter.load();
+	if (waiter != nullptr) {
+		xTaskNotifyGive(waiter);
+	}
+}
+
+// RTC interrupt. Wakes the render loop, whose power_update call switches to
+// full power and pulls in fresh prices.
+static void market_open_alarm() {
+	render_scheduler_notify_from_isr(RENDER_EVENT_CLOCK_MINUTE);
+}
+
+// Fires every day at the open; weekends are filtered by market_hours. Needs
+// the RTC running, so it is armed once the time has been set.
+static void arm_market_open_alarm() {
+	datetime_t alarm = {
+	    .year = -1,
+	    .month = -1,
+	    .day = -1,
+	    .dotw = -1,
+	    .hour = POWER_MARKET_OPEN_MINUTE / 60,
+	    .min = POWER_MARKET_OPEN_MINUTE % 60,
+	    .sec = 0,
+	};
+	rtc_set_alarm(&alarm, market_open_alarm);
+	alarm_armed = true;
+}
+
+// Console command: sleep statistics and the energy estimate
+static void cmd_power(int argc, char **argv) {
+	(void)argc;
+	(void)argv;
+	power_print_stats();
+}
+
+void power_init() {
+	sleep_stats_snapshot(&last_report);
+	console_register("power", "wake-ups and energy estimate", cmd_power);
+}
+
+TickType_t power_update() {
+	if (!alarm_armed && rtc_running()) {
+		arm_market_open_alarm();
+	}
+
+	bool low = !market_hours();
+	if (low != low_power.load()) {
+		low_power = low;
+		DLOG_INFO("Market %s, %s power\n", low ? "closed" : "open",
+		          low ? "low" : "full");
+		set_backlight_on(!low);
+		if (!low) {
+			power_request_refresh();
+		}
+	}
+
+	if (!low || !backlight_on) {
+		return portMAX_DELAY;
+	}
+
+	// Lit by a button press: turn it off again once the user has had a look
+	TickType_t left = backlight_off_tick - xTaskGetTickCount();
+	if ((int32_t)left <= 0) {
+		set_backlight_on(false);
+		return portMAX_DELAY;
+	}
+	return left;
+}
+
+bool power_user_activity() {
+	if (!low_power) {
+		return false;
+	}
+	backlight_off_tick =
+	    xTaskGetTickCount() + pdMS_TO_TICKS(POWER_WAKE_BACKLIGHT_MS);
+	if (backlight_on) {
+		return false;
+	}
+	set_backlight_on(true);
+	power_request_refresh();
+	return true;
+}
+
+bool power_low_power() { return low_power; }
+
+bool power_display_on() { return backlight_on; }
+
+uint32_t power_refresh_interval_ms(uint32_t market_hours_ms) {
+	return low_power ? POWER_OFF_HOURS_REFRESH_MS : market_hours_ms;
+}
+
+void power_wait_for_refresh(uint32_t ms) {
+	refresh_waiter = xTaskGetCurrentTaskHandle();
+	ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+}
+
+void power_print_stats() {
+	SleepStatsSnapshot now;
+	sleep_stats_snapshot(&now);
+	uint32_t elapsed_us = now.time_us - last_report.time_us;
+	if (elapsed_us == 0) {
+		return;
+	}
+
+	printf("Power: %s, backlight %s\n",
+	       low_power ? "low (market closed)" : "full (market open)",
+	       backlight_on ? "on" : "off");
+
+	// Supply current in uA, from the fraction of time each core was awake
+	uint64_t current_ua = POWER_BASE_MA * 1000;
+	uint32_t total_wakeups = 0;
+	for (int i = 0; i < configNUMBER_OF_CORES && i < SLEEP_STATS_MAX_CORES;
+	     i++) {
+		uint32_t wakeups = now.wakeups[i] - last_report.wakeups[i];
+		uint32_t asleep = now.sleep_us[i] - last_report.sleep_us[i];
+		if (asleep > elapsed_us)
+			asleep = elapsed_us;
+		uint32_t awake = elapsed_us - asleep;
+		total_wakeups += wakeups;
+		current_ua +=
+		    (uint64_t)POWER_CORE_ACTIVE_MA * 1000 * awake / elapsed_us;
+		printf("  core %d: asleep %lu%%, %lu wake-ups/s\n", i,
+		       (unsigned long)((uint64_t)asleep * 100 / elapsed_us),
+		       (unsigned long)((uint64_t)wakeups * 1000000 / elapsed_us));
+	}
+	if (backlight_on) {
+		current_ua += POWER_BACKLIGHT_MA * 1000 * POWER_BACKLIGHT_LEVEL / 255;
+	}
+
+	// At a constant supply voltage, mW drawn is mWh per hour
+	uint64_t power_uw = current_ua * POWER_SUPPLY_MV / 1000;
+	printf("  %lu wake-ups/s over the last %lus\n",
+	       (unsigned long)((uint64_t)total_wakeups * 1000000 / elapsed_us),
+	       (unsigned long)(elapsed_us / 1000000));
+	printf("  estimated %lu.%01lu mA, %lu.%01lu mWh per hour\n",
+	       (unsigned long)(current_ua / 1000),
+	       (unsigned long)(current_ua % 1000 / 100),
+	       (unsigned long)(power_uw / 1000),
+	       (unsigned long)(power_uw % 1000 / 100));
+
+	last_report = now;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include "FreeRTOS.h"
+
+// Trading hours in RTC time, Monday to Friday. The RTC is set from the
+// server's local clock, so run the server in the exchange's time zone.
+#define POWER_MARKET_OPEN_MINUTE (9 * 60 + 30)
+#define POWER_MARKET_CLOSE_MINUTE (16 * 60)
+
+// Outside trading hours prices barely move: refresh rarely, keep the
+// backlight off and only light it for a while after a button press
+#define POWER_OFF_HOURS_REFRESH_MS (15 * 60 * 1000)
+#define POWER_WAKE_BACKLIGHT_MS (30 * 1000)
+#define POWER_BACKLIGHT_LEVEL 200
+
+// Supply current model for the energy estimate, in mA at 5 V on VBUS. Rough
+// bench figures for a Pico W with the Wi-Fi chip in power save mode.
+#define POWER_SUPPLY_MV 5000
+#define POWER_BASE_MA 18        // both cores waiting for interrupts
+#define POWER_CORE_ACTIVE_MA 9  // extra for each core that is running
+#define POWER_BACKLIGHT_MA 25   // backlight at full brightness
+
+// Register the "power" console command and the RTC alarm that wakes the
+// device at market open. Call after rtc_init and render_scheduler_init.
+void power_init();
+
+// Re-evaluate the schedule: switch between full and low power and time out
+// the backlight. Call from the render loop whenever it wakes. Returns how
+// long it may sleep before the next call is due.
+TickType_t power_update();
+
+// A button was pressed. Keeps the backlight on for a while in low power mode;
+// if it was off, lights it, brings the next refresh forward and returns true
+// so the press isn't acted on.
+bool power_user_activity();
+
+// True while outside trading hours with the schedule in force
+bool power_low_power();
+
+// Whether there is any point drawing a frame
+bool power_display_on();
+
+// Delay between successful fetches: market_hours_ms while the market is
+// open, POWER_OFF_HOURS_REFRESH_MS otherwise
+uint32_t power_refresh_interval_ms(uint32_t market_hours_ms);
+
+// Block the calling task for up to ms, returning early at market open or
+// when power_request_refresh is called
+void power_wait_for_refresh(uint32_t ms);
+
+// Cut the current power_wait_for_refresh short, such as when the user asks
+// for fresh data or the network comes back
+void power_request_refresh();
+
+void power_print_stats();
@@ -0,0 +1,108 @@
+#include "render_scheduler.hpp"
+
+#include <cstdio>
+
+#include "hardware/rtc.h"
+#include "pico/util/datetime.h"
+#include "timers.h"
+
+#include "trace_buffer.h"
+
+static EventGroupHandle_t render_events = NULL;
+static TimerHandle_t clock_timer = NULL;
+static TickType_t last_frame_tick = 0;
+#if STATIC_ALLOCATION
+static StaticEventGroup_t render_events_buffer;
+static StaticTimer_t clock_timer_buffer;
+#endif
+
+// Milliseconds until the RTC minute rolls over; a plain minute if the RTC
+// hasn't been set yet
+static uint32_t ms_until_next_minute() {
+	datetime_t now;
+	if (!rtc_running() || !rtc_get_datetime(&now)) {
+		return 60 * 1000;
+	}
+	return (60 - now.sec) * 1000;
+}
+
+static void clock_timer_callback(TimerHandle_t timer) {
+	xEventGroupSetBits(render_events, RENDER_EVENT_CLOCK_MINUTE);
+	// Re-arm against the RTC each time so the timer can't drift
+	xTimerChangePeriod(timer, pdMS_TO_TICKS(ms_until_next_minute()), 0);
+}
+
+void render_scheduler_init() {
+#if STATIC_ALLOCATION
+	render_events = xEventGroupCreateStatic(&render_events_buffer);
+#else
+	render_events = xEventGroupCreate();
+#endif
+	if (render_events == NULL) {
+		printf("Failed to create render event group\n");
+		return;
+	}
+	trace_buffer_name_object(render_events, "render_events");
+
+#if STATIC_ALLOCATION
+	clock_timer = xTimerCreateStatic(
+	    "ClockTimer", pdMS_TO_TICKS(ms_until_next_minute()), pdFALSE, NULL,
+	    clock_timer_callback, &clock_timer_buffer);
+#else
+	clock_timer = xTimerCreate("ClockTimer",
+	                           pdMS_TO_TICKS(ms_until_next_minute()), pdFALSE,
+	                           NULL, clock_timer_callback);
+#endif
+	if (clock_timer == NULL || xTimerStart(clock_timer, 0) != pdPASS) {
+		printf("Failed to start clock timer\n");
+	}
+
+	// Draw the first frame straight away
+	xEventGroupSetBits(render_events, RENDER_EVENT_DATA_UPDATED);
+}
+
+void render_scheduler_notify(EventBits_t events) {
+	if (render_events != NULL) {
+		xEventGroupSetBits(render_events, events);
+	}
+}
+
+void render_scheduler_notify_from_isr(EventBits_t events) {
+	if (render_events == NULL) {
+		return;
+	}
+	BaseType_t higher_priority_woken = pdFALSE;
+	xEventGroupSetBitsFromISR(render_events, events, &higher_priority_woken);
+	portYIELD_FROM_ISR(higher_priority_woken);
+}
+
+void render_scheduler_resync_clock() {
+	if (clock_timer != NULL) {
+		xTimerChangePeriod(clock_timer, pdMS_TO_TICKS(ms_until_next_minute()),
+		                   0);
+	}
+	render_scheduler_notify(RENDER_EVENT_CLOCK_MINUTE);
+}
+
+void render_scheduler_stop_clock() {
+	if (clock_timer != NULL) {
+		xTimerStop(clock_timer, 0);
+	}
+}
+
+EventBits_t render_scheduler_wait(TickType_t timeout) {
+	EventBits_t events = xEventGroupWaitBits(render_events, RENDER_EVENT_ALL,
+	                                         pdTRUE, pdFALSE, timeout);
+
+	// Hold off until the frame slot opens; anything that arrives meanwhile
+	// is folded into this frame rather than triggering another one
+	TickType_t min_interval = pdMS_TO_TICKS(RENDER_MIN_FRAME_MS);
+	TickType_t since_last = xTaskGetTickCount() - last_frame_tick;
+	if (since_last < min_interval) {
+		vTaskDelay(min_interval - since_last);
+	}
+	events |= xEventGroupClearBits(render_events, RENDER_EVENT_ALL);
+
+	last_frame_tick = xTaskGetTickCount();
+	return events & RENDER_EVENT_ALL;
+}
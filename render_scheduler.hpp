@@ -0,0 +1,36 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "event_groups.h"
+
+// Reasons to redraw the screen. Producers set these bits; the render loop
+// waits on them and draws one frame for however many arrived.
+#define RENDER_EVENT_DATA_UPDATED (1u << 0)
+#define RENDER_EVENT_CLOCK_MINUTE (1u << 1)
+#define RENDER_EVENT_BUTTON (1u << 2)
+#define RENDER_EVENT_ANIMATION (1u << 3)
+#define RENDER_EVENT_ALL                                                       \
+	(RENDER_EVENT_DATA_UPDATED | RENDER_EVENT_CLOCK_MINUTE |                   \
+	 RENDER_EVENT_BUTTON | RENDER_EVENT_ANIMATION)
+
+// Minimum time between frames. Events that arrive while a frame is pending
+// are coalesced into it, which also caps the animation frame rate.
+#define RENDER_MIN_FRAME_MS 33
+
+// Create the event group and the clock timer. Call before any producer runs.
+void render_scheduler_init();
+
+// Request a redraw for the given RENDER_EVENT_* bits
+void render_scheduler_notify(EventBits_t events);
+void render_scheduler_notify_from_isr(EventBits_t events);
+
+// Re-align the minute timer after the RTC has been set. Also restarts it
+// after render_scheduler_stop_clock.
+void render_scheduler_resync_clock();
+
+// Stop the minute timer while nothing is on screen
+void render_scheduler_stop_clock();
+
+// Block until a frame is due. Returns the coalesced event bits, or 0 if the
+// timeout expired with nothing pending.
+EventBits_t render_scheduler_wait(TickType_t timeout = portMAX_DELAY);
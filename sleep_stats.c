@@ -0,0 +1,39 @@
+#include "sleep_stats.h"
+
+#include "FreeRTOS.h"
+#include "hardware/sync.h"
+#include "pico/stdlib.h"
+
+// Each core only writes its own entries, with interrupts masked
+static volatile uint32_t sleep_since_us[SLEEP_STATS_MAX_CORES];
+static volatile uint32_t sleep_total_us[SLEEP_STATS_MAX_CORES];
+static volatile uint32_t wakeup_count[SLEEP_STATS_MAX_CORES];
+
+void sleep_stats_pre_sleep(void) {
+	sleep_since_us[portGET_CORE_ID()] = time_us_32();
+}
+
+void sleep_stats_post_sleep(void) {
+	uint32_t core = portGET_CORE_ID();
+	sleep_total_us[core] += time_us_32() - sleep_since_us[core];
+	wakeup_count[core]++;
+}
+
+void sleep_stats_idle(void) {
+	// A pending interrupt still ends the wait with interrupts masked, so
+	// nothing can slip in between the timestamps and the sleep
+	__asm volatile("cpsid i" ::: "memory");
+	sleep_stats_pre_sleep();
+	__dsb();
+	__wfi();
+	sleep_stats_post_sleep();
+	__asm volatile("cpsie i" ::: "memory");
+}
+
+void sleep_stats_snapshot(SleepStatsSnapshot *snapshot) {
+	snapshot->time_us = time_us_32();
+	for (int i = 0; i < SLEEP_STATS_MAX_CORES; i++) {
+		snapshot->sleep_us[i] = sleep_total_us[i];
+		snapshot->wakeups[i] = wakeup_count[i];
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef SLEEP_STATS_H
+#define SLEEP_STATS_H
+
+#include <stdint.h>
+
+#define SLEEP_STATS_MAX_CORES 2
+
+// Cumulative time each core has spent asleep and how often it was woken, as
+// of time_us
+typedef struct {
+	uint32_t time_us;
+	uint32_t sleep_us[SLEEP_STATS_MAX_CORES];
+	uint32_t wakeups[SLEEP_STATS_MAX_CORES];
+} SleepStatsSnapshot;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Sleep the calling core until its next interrupt. For the idle hooks of an
+ * SMP build, where the kernel can't suppress the tick.
+ */
+void sleep_stats_idle(void);
+
+/**
+ * Tickless idle hooks, called from configPRE/POST_SLEEP_PROCESSING around
+ * the port's wait for interrupt, with interrupts masked
+ */
+void sleep_stats_pre_sleep(void);
+void sleep_stats_post_sleep(void);
+
+/**
+ * Read the sleep counters
+ * @param snapshot Receives the current totals
+ */
+void sleep_stats_snapshot(SleepStatsSnapshot *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SLEEP_STATS_H
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free triple buffer for handing a large value from one producer task to
+// one consumer task on another core. The producer fills its private slot and
+// publishes it with a single atomic swap; the consumer swaps the newest
+// published slot into its own private slot. Neither side ever waits, the
+// consumer always reads a completely written value, and intermediate values
+// the consumer never picked up are simply overwritten (latest wins).
+template <typename T> class SnapshotBuffer {
+  public:
+	// Producer side: the slot to fill before calling publish()
+	T &write_buffer() { return slots_[write_index_]; }
+
+	// Producer side: make the write buffer the newest snapshot
+	void publish() {
+		uint32_t prev = shared_.exchange(write_index_ | FRESH,
+		                                 std::memory_order_acq_rel);
+		write_index_ = prev & INDEX_MASK;
+	}
+
+	// Consumer side: switch to the newest snapshot if one was published since
+	// the last call. Returns false, keeping the current one, otherwise.
+	bool acquire() {
+		if ((shared_.load(std::memory_order_acquire) & FRESH) == 0) {
+			return false;
+		}
+		uint32_t prev =
+		    shared_.exchange(read_index_, std::memory_order_acq_rel);
+		read_index_ = prev & INDEX_MASK;
+		return true;
+	}
+
+	// Consumer side: the snapshot picked up by the last acquire()
+	const T &read_buffer() const { return slots_[read_index_]; }
+
+  private:
+	static constexpr uint32_t INDEX_MASK = 0x3;
+	static constexpr uint32_t FRESH = 0x4;
+
+	T slots_[3] = {};
+	uint32_t write_index_ = 0; // Owned by the producer
+	uint32_t read_index_ = 1;  // Owned by the consumer
+	std::atomic<uint32_t> shared_{2};
+};
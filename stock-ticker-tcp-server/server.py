@@ -103,14 +103,18 @@ def handle_client(secure_conn, client_address):
                             else:
                                 # Get stock data
                                 ticker = yf.Ticker(ticker_name)
-                                hist = ticker.history(period=duration, interval=interval)[['Open', 'High', 'Low', 'Close']]
+                                hist = ticker.history(period=duration, interval=interval)[['Open', 'High', 'Low', 'Close', 'Volume']]
                                 
-                                # Convert DataFrame to dict for JSON serialization
+                                # Convert DataFrame to dict for JSON serialization,
+                                # with each row's time as integer epoch seconds
+                                records = hist.to_dict(orient='records')
+                                for record, when in zip(records, hist.index):
+                                    record["Date"] = int(when.timestamp())
                                 stock_data = {
                                     "ticker": ticker_name,
                                     "duration": duration,
                                     "interval": interval,
-                                    "data": hist.to_dict(orient='records')
+                                    "data": records
                                 }
                                 
                                 response = {
@@ -0,0 +1,317 @@
+#include "sys_monitor.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <malloc.h>
+
+#include "FreeRTOS.h"
+#include "pico/stdlib.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "console.hpp"
+#include "core_load.h"
+#include "heap_stats.h"
+#include "task_registry.hpp"
+
+#define SYS_MONITOR_TASK_PRIORITY (tskIDLE_PRIORITY + 1UL)
+#define SYS_MONITOR_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+
+// Rolling CPU history for one task, matched across samples by task number
+struct TaskSample {
+	UBaseType_t number; // 0 marks a free slot
+	char name[configMAX_TASK_NAME_LEN];
+	UBaseType_t priority;
+	eTaskState state;
+	UBaseType_t core_mask;
+	configSTACK_DEPTH_TYPE stack_depth; // 0 if not in the task registry
+	configSTACK_DEPTH_TYPE stack_free_words;
+	bool stack_alerted;
+	configRUN_TIME_COUNTER_TYPE last_runtime;
+	uint32_t deltas_us[SYS_MONITOR_WINDOW];
+	bool seen;
+};
+
+static TaskSample task_samples[SYS_MONITOR_MAX_TASKS];
+static uint32_t interval_us[SYS_MONITOR_WINDOW];
+static CoreLoadSnapshot core_snapshots[SYS_MONITOR_WINDOW + 1];
+static uint32_t samples_taken = 0;
+static uint32_t last_sample_us = 0;
+
+// Kept off the monitor task's stack
+static TaskStatus_t status_buffer[SYS_MONITOR_MAX_TASKS];
+
+// The console task reads what the monitor task writes
+static SemaphoreHandle_t monitor_lock = NULL;
+
+extern "C" char __StackLimit, __bss_end__;
+
+static TaskSample *find_or_add(UBaseType_t number) {
+	TaskSample *free_slot = nullptr;
+	for (auto &sample : task_samples) {
+		if (sample.number == number)
+			return &sample;
+		if (sample.number == 0 && !free_slot)
+			free_slot = &sample;
+	}
+	if (free_slot) {
+		memset(free_slot, 0, sizeof(*free_slot));
+		free_slot->number = number;
+	}
+	return free_slot;
+}
+
+static uint32_t stack_used_percent(const TaskSample &sample) {
+	if (sample.stack_depth == 0 || sample.stack_free_words > sample.stack_depth)
+		return 0;
+	return (sample.stack_depth - sample.stack_free_words) * 100 /
+	       sample.stack_depth;
+}
+
+// The high water mark never recovers, so each task is reported at most once
+static void check_stack(TaskSample &sample) {
+	if (sample.stack_alerted)
+		return;
+
+	uint32_t free_bytes = sample.stack_free_words * sizeof(StackType_t);
+	if (free_bytes >= SYS_MONITOR_STACK_ALERT_FREE_BYTES &&
+	    stack_used_percent(sample) < SYS_MONITOR_STACK_ALERT_PERCENT)
+		return;
+
+	sample.stack_alerted = true;
+	if (sample.stack_depth) {
+		printf("Stack alert: %s has used %lu%% of its stack, %lu bytes free\n",
+		       sample.name, (unsigned long)stack_used_percent(sample),
+		       (unsigned long)free_bytes);
+	} else {
+		printf("Stack alert: %s has %lu bytes of stack free\n", sample.name,
+		       (unsigned long)free_bytes);
+	}
+}
+
+static void take_sample() {
+	configRUN_TIME_COUNTER_TYPE total_runtime;
+	UBaseType_t count = uxTaskGetSystemState(
+	    status_buffer, SYS_MONITOR_MAX_TASKS, &total_runtime);
+	if (count == 0) {
+		printf("sys_monitor: more than %d tasks, raise SYS_MONITOR_MAX_TASKS\n",
+		       SYS_MONITOR_MAX_TASKS);
+		return;
+	}
+
+	uint32_t now = time_us_32();
+	uint32_t slot = samples_taken % SYS_MONITOR_WINDOW;
+
+	xSemaphoreTake(monitor_lock, portMAX_DELAY);
+	for (auto &sample : task_samples) {
+		sample.seen = false;
+	}
+
+	for (UBaseType_t i = 0; i < count; i++) {
+		const TaskStatus_t &status = status_buffer[i];
+		TaskSample *sample = find_or_add(status.xTaskNumber);
+		if (!sample)
+			continue;
+
+		bool is_new = sample->name[0] == '\0';
+		if (is_new) {
+			strncpy(sample->name, status.pcTaskName, sizeof(sample->name) - 1);
+			sample->last_runtime = status.ulRunTimeCounter;
+			sample->stack_depth = task_registry_stack_depth(status.xHandle);
+		}
+		sample->deltas_us[slot] =
+		    (uint32_t)(status.ulRunTimeCounter - sample->last_runtime);
+		sample->last_runtime = status.ulRunTimeCounter;
+		sample->priority = status.uxCurrentPriority;
+		sample->state = status.eCurrentState;
+		sample->stack_free_words = status.usStackHighWaterMark;
+#if configUSE_CORE_AFFINITY && configNUMBER_OF_CORES > 1
+		sample->core_mask = status.uxCoreAffinityMask;
+#endif
+		sample->seen = true;
+		check_stack(*sample);
+	}
+
+	// Forget tasks that have been deleted
+	for (auto &sample : task_samples) {
+		if (sample.number != 0 && !sample.seen)
+			sample.number = 0;
+	}
+
+	interval_us[slot] = now - last_sample_us;
+	last_sample_us = now;
+	samples_taken++;
+	core_load_snapshot(&core_snapshots[samples_taken % (SYS_MONITOR_WINDOW + 1)]);
+	xSemaphoreGive(monitor_lock);
+}
+
+static void sys_monitor_task(__unused void *params) {
+	TickType_t last_wake = xTaskGetTickCount();
+	while (true) {
+		vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SYS_MONITOR_PERIOD_MS));
+		take_sample();
+	}
+}
+
+static uint32_t filled_samples() {
+	return samples_taken < SYS_MONITOR_WINDOW ? samples_taken
+	                                          : SYS_MONITOR_WINDOW;
+}
+
+void sys_monitor_print_stats() {
+	xSemaphoreTake(monitor_lock, portMAX_DELAY);
+	uint32_t filled = filled_samples();
+	if (filled == 0) {
+		xSemaphoreGive(monitor_lock);
+		printf("No samples yet\n");
+		return;
+	}
+
+	const CoreLoadSnapshot &newest =
+	    core_snapshots[samples_taken % (SYS_MONITOR_WINDOW + 1)];
+	const CoreLoadSnapshot &previous =
+	    core_snapshots[(samples_taken - 1) % (SYS_MONITOR_WINDOW + 1)];
+	const CoreLoadSnapshot &oldest =
+	    core_snapshots[(samples_taken - filled) % (SYS_MONITOR_WINDOW + 1)];
+
+	printf("CPU busy (last %lus / last 1s):\n", (unsigned long)filled);
+	for (uint32_t core = 0; core < configNUMBER_OF_CORES; core++) {
+		printf("  core%lu %3lu%% %3lu%%\n", (unsigned long)core,
+		       (unsigned long)core_load_busy_percent(&oldest, &newest, core),
+		       (unsigned long)core_load_busy_percent(&previous, &newest, core));
+	}
+	printf("Uptime %lu s, %lu samples\n",
+	       (unsigned long)(time_us_64() / 1000000),
+	       (unsigned long)samples_taken);
+	xSemaphoreGive(monitor_lock);
+}
+
+void sys_monitor_print_tasks() {
+	xSemaphoreTake(monitor_lock, portMAX_DELAY);
+	uint32_t filled = filled_samples();
+	uint64_t window_us = 0;
+	for (uint32_t i = 0; i < filled; i++) {
+		window_us += interval_us[(samples_taken - 1 - i) % SYS_MONITOR_WINDOW];
+	}
+
+	printf("%-16s %4s %5s %4s %6s %6s %6s\n", "task", "prio", "state", "core",
+	       "avg%", "peak%", "free");
+	for (const auto &sample : task_samples) {
+		if (sample.number == 0)
+			continue;
+
+		uint64_t busy_us = 0;
+		uint32_t peak_permille = 0;
+		for (uint32_t i = 0; i < filled; i++) {
+			uint32_t slot = (samples_taken - 1 - i) % SYS_MONITOR_WINDOW;
+			busy_us += sample.deltas_us[slot];
+			if (interval_us[slot] > 0) {
+				uint32_t permille = (uint32_t)(
+				    (uint64_t)sample.deltas_us[slot] * 1000 / interval_us[slot]);
+				if (permille > peak_permille)
+					peak_permille = permille;
+			}
+		}
+		uint32_t avg_permille =
+		    window_us ? (uint32_t)(busy_us * 1000 / window_us) : 0;
+
+		static const char state_chars[] = "XRBSDI";
+		char state = sample.state < (int)sizeof(state_chars) - 1
+		                 ? state_chars[sample.state]
+		                 : '?';
+		printf("%-16s %4lu %5c %4lx %4lu.%lu %4lu.%lu %6lu\n", sample.name,
+		       (unsigned long)sample.priority, state,
+		       (unsigned long)sample.core_mask,
+		       (unsigned long)(avg_permille / 10),
+		       (unsigned long)(avg_permille % 10),
+		       (unsigned long)(peak_permille / 10),
+		       (unsigned long)(peak_permille % 10),
+		       (unsigned long)(sample.stack_free_words * sizeof(StackType_t)));
+	}
+	printf("state: X=running R=ready B=blocked S=suspended D=deleted\n");
+	xSemaphoreGive(monitor_lock);
+}
+
+void sys_monitor_print_stack() {
+	xSemaphoreTake(monitor_lock, portMAX_DELAY);
+	printf("%-16s %6s %6s %6s %5s\n", "task", "size", "used", "free", "used%");
+	for (const auto &sample : task_samples) {
+		if (sample.number == 0)
+			continue;
+
+		unsigned long free_bytes = sample.stack_free_words * sizeof(StackType_t);
+		if (sample.stack_depth == 0) {
+			printf("%-16s %6s %6s %6lu %5s\n", sample.name, "?", "?", free_bytes,
+			       "?");
+			continue;
+		}
+		unsigned long size_bytes = sample.stack_depth * sizeof(StackType_t);
+		printf("%-16s %6lu %6lu %6lu %4lu%%%s\n", sample.name, size_bytes,
+		       size_bytes - free_bytes, free_bytes,
+		       (unsigned long)stack_used_percent(sample),
+		       sample.stack_alerted ? " !" : "");
+	}
+	xSemaphoreGive(monitor_lock);
+}
+
+void sys_monitor_print_heap() {
+	struct mallinfo info = mallinfo();
+	size_t total = &__StackLimit - &__bss_end__;
+	printf("newlib heap: %u total, %u used, %u free\n", (unsigned)total,
+	       (unsigned)info.uordblks, (unsigned)(total - info.uordblks));
+	printf("  arena %u, free in arena %u\n", (unsigned)info.arena,
+	       (unsigned)info.fordblks);
+	heap_stats_print();
+}
+
+static void cmd_stats(int argc, char **argv) {
+	(void)argc;
+	(void)argv;
+	sys_monitor_print_stats();
+}
+
+static void cmd_tasks(int argc, char **argv) {
+	(void)argc;
+	(void)argv;
+	sys_monitor_print_tasks();
+}
+
+static void cmd_stack(int argc, char **argv) {
+	(void)argc;
+	(void)argv;
+	sys_monitor_print_stack();
+}
+
+static void cmd_heap(int argc, char **argv) {
+	(void)argc;
+	(void)argv;
+	sys_monitor_print_heap();
+}
+
+void sys_monitor_init() {
+#if STATIC_ALLOCATION
+	static StaticSemaphore_t monitor_lock_buffer;
+	monitor_lock = xSemaphoreCreateMutexStatic(&monitor_lock_buffer);
+#else
+	monitor_lock = xSemaphoreCreateMutex();
+#endif
+	if (monitor_lock == NULL) {
+		printf("Failed to create sys_monitor lock\n");
+		return;
+	}
+
+	last_sample_us = time_us_32();
+	core_load_snapshot(&core_snapshots[0]);
+
+	if (task_registry_create(sys_monitor_task, "MonitorThread",
+	                         SYS_MONITOR_TASK_STACK_SIZE,
+	                         SYS_MONITOR_TASK_PRIORITY, tskNO_AFFINITY,
+	                         NULL) != pdPASS) {
+		return;
+	}
+
+	console_register("stats", "per-core CPU load", cmd_stats);
+	console_register("tasks", "per-task CPU load and stack", cmd_tasks);
+	console_register("stack", "stack high water marks", cmd_stack);
+	console_register("heap", "heap usage", cmd_heap);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+// Sampling period and how many samples make up the rolling window
+#define SYS_MONITOR_PERIOD_MS 1000
+#define SYS_MONITOR_WINDOW 10
+
+// Upper bound on tasks tracked, including the kernel's and lwIP's own
+#define SYS_MONITOR_MAX_TASKS 24
+
+// A task whose stack has come within either limit of overflowing is reported
+// once on the console. The percentage only applies to tasks whose stack depth
+// is known to the task registry.
+#define SYS_MONITOR_STACK_ALERT_PERCENT 90
+#define SYS_MONITOR_STACK_ALERT_FREE_BYTES 128
+
+// Start the low priority monitor task and register its console commands
+// (stats, tasks, stack, heap). Needs configGENERATE_RUN_TIME_STATS.
+void sys_monitor_init();
+
+void sys_monitor_print_stats();
+void sys_monitor_print_tasks();
+void sys_monitor_print_stack();
+void sys_monitor_print_heap();
@@ -0,0 +1,103 @@
+#include "task_registry.hpp"
+
+#include <cstdio>
+
+struct TaskRecord {
+	TaskHandle_t handle;
+	configSTACK_DEPTH_TYPE stack_depth;
+};
+
+static TaskRecord records[TASK_REGISTRY_MAX];
+static size_t num_records = 0;
+
+#if STATIC_ALLOCATION
+static StackType_t stack_pool[TASK_REGISTRY_STACK_POOL_WORDS];
+static size_t stack_pool_used = 0;
+static StaticTask_t task_buffers[TASK_REGISTRY_MAX];
+static size_t task_buffers_used = 0;
+
+static TaskHandle_t create_static(TaskFunction_t task, const char *name,
+                                  configSTACK_DEPTH_TYPE stack_depth,
+                                  UBaseType_t priority, UBaseType_t core_mask) {
+	StackType_t *stack = NULL;
+	StaticTask_t *tcb = NULL;
+	taskENTER_CRITICAL();
+	if (stack_pool_used + stack_depth <= TASK_REGISTRY_STACK_POOL_WORDS &&
+	    task_buffers_used < TASK_REGISTRY_MAX) {
+		stack = &stack_pool[stack_pool_used];
+		stack_pool_used += stack_depth;
+		tcb = &task_buffers[task_buffers_used++];
+	}
+	taskEXIT_CRITICAL();
+
+	if (!stack) {
+		printf("Static task pool exhausted creating %s (%lu words used)\n",
+		       name, (unsigned long)stack_pool_used);
+		return NULL;
+	}
+#if configUSE_CORE_AFFINITY && configNUMBER_OF_CORES > 1
+	return xTaskCreateStaticAffinitySet(task, name, stack_depth, NULL,
+	                                    priority, stack, tcb, core_mask);
+#else
+	(void)core_mask;
+	return xTaskCreateStatic(task, name, stack_depth, NULL, priority, stack,
+	                         tcb);
+#endif
+}
+#endif
+
+BaseType_t task_registry_create(TaskFunction_t task, const char *name,
+                                configSTACK_DEPTH_TYPE stack_depth,
+                                UBaseType_t priority, UBaseType_t core_mask,
+                                TaskHandle_t *handle) {
+	TaskHandle_t created = NULL;
+#if STATIC_ALLOCATION
+	created = create_static(task, name, stack_depth, priority, core_mask);
+	BaseType_t result =
+	    created ? pdPASS : errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+#elif configUSE_CORE_AFFINITY && configNUMBER_OF_CORES > 1
+	BaseType_t result = xTaskCreateAffinitySet(
+	    task, name, stack_depth, NULL, priority, core_mask, &created);
+#else
+	(void)core_mask;
+	BaseType_t result =
+	    xTaskCreate(task, name, stack_depth, NULL, priority, &created);
+#endif
+	if (result != pdPASS) {
+		printf("Failed to create %s\n", name);
+		return result;
+	}
+
+	task_registry_add(created, stack_depth);
+	if (handle)
+		*handle = created;
+	return result;
+}
+
+void task_registry_add(TaskHandle_t handle,
+                       configSTACK_DEPTH_TYPE stack_depth) {
+	if (handle == NULL)
+		return;
+
+	taskENTER_CRITICAL();
+	if (num_records < TASK_REGISTRY_MAX) {
+		records[num_records++] = {handle, stack_depth};
+	}
+	taskEXIT_CRITICAL();
+
+	if (task_registry_stack_depth(handle) != stack_depth)
+		printf("Task registry full, not tracking %s\n", pcTaskGetName(handle));
+}
+
+configSTACK_DEPTH_TYPE task_registry_stack_depth(TaskHandle_t handle) {
+	configSTACK_DEPTH_TYPE depth = 0;
+	taskENTER_CRITICAL();
+	for (size_t i = 0; i < num_records; i++) {
+		if (records[i].handle == handle) {
+			depth = records[i].stack_depth;
+			break;
+		}
+	}
+	taskEXIT_CRITICAL();
+	return depth;
+}
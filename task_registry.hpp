@@ -0,0 +1,27 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Most tasks the firmware knows the stack size of: our own, plus lwIP's and
+// the kernel's timer task
+#define TASK_REGISTRY_MAX 16
+
+// With STATIC_ALLOCATION, stacks of tasks created through the registry are
+// carved from a fixed pool at boot and never returned
+#ifndef TASK_REGISTRY_STACK_POOL_WORDS
+#define TASK_REGISTRY_STACK_POOL_WORDS (configMINIMAL_STACK_SIZE * 20)
+#endif
+
+// Create a task restricted to the cores in core_mask and record its handle
+// and stack depth. Same arguments and result as xTaskCreate.
+BaseType_t task_registry_create(TaskFunction_t task, const char *name,
+                                configSTACK_DEPTH_TYPE stack_depth,
+                                UBaseType_t priority, UBaseType_t core_mask,
+                                TaskHandle_t *handle);
+
+// Record a task created elsewhere. NULL handles are ignored.
+void task_registry_add(TaskHandle_t handle, configSTACK_DEPTH_TYPE stack_depth);
+
+// Stack depth in words the task was created with, or 0 if it is unknown
+configSTACK_DEPTH_TYPE task_registry_stack_depth(TaskHandle_t handle);
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// One candle, as handed to and read back from a TimeSeries
+struct Candle {
+	uint32_t time; // Seconds since the epoch, 0 if the server sent none
+	float open;
+	float high;
+	float low;
+	float close;
+	float volume;
+};
+
+// Running extremum of the last Window values written to a ring of Capacity
+// slots: a monotonic deque of slot numbers whose values only get worse from
+// front to back, so the front is always the best. Each slot is pushed and
+// popped at most once, making updates amortised O(1) and reads O(1).
+// Better(a, b) is true when a should win over b.
+template <size_t Capacity, size_t Window, typename Better>
+class ExtremumWindow {
+  public:
+	void clear() {
+		begin_ = 0;
+		end_ = 0;
+	}
+
+	// Before writing slot: drop what falls out of the window with it, the
+	// old occupant of the slot included
+	void expire(size_t slot) {
+		while (begin_ != end_) {
+			size_t oldest = queue_[begin_ & MASK];
+			size_t age = (slot - oldest) & MASK;
+			if (oldest != slot && age < Window) {
+				break;
+			}
+			begin_++;
+		}
+	}
+
+	// After writing slot: anything no better than it can never be the
+	// extremum again
+	void push(size_t slot, const float *values) {
+		while (end_ != begin_ &&
+		       !Better()(values[queue_[(end_ - 1) & MASK]], values[slot])) {
+			end_--;
+		}
+		queue_[end_ & MASK] = slot;
+		end_++;
+	}
+
+	bool empty() const { return begin_ == end_; }
+	size_t best_slot() const { return queue_[begin_ & MASK]; }
+
+  private:
+	static constexpr size_t MASK = Capacity - 1;
+
+	uint16_t queue_[Capacity];
+	size_t begin_ = 0; // Free-running; masked on use
+	size_t end_ = 0;
+};
+
+struct FloatGreater {
+	bool operator()(float a, float b) const { return a > b; }
+};
+struct FloatLess {
+	bool operator()(float a, float b) const { return a < b; }
+};
+
+// Fold a later candle into an earlier one: the earlier open and time, the
+// later close, the widest range and the total volume
+static inline void merge_candle(Candle &into, const Candle &later) {
+	if (later.high > into.high) {
+		into.high = later.high;
+	}
+	if (later.low < into.low) {
+		into.low = later.low;
+	}
+	into.close = later.close;
+	into.volume += later.volume;
+}
+
+// Floor of log2(n), for sizing at compile time
+static constexpr size_t log2_floor(size_t n) {
+	return n > 1 ? 1 + log2_floor(n / 2) : 0;
+}
+
+// Fixed-capacity ring of candles, oldest first. Appending to a full series
+// evicts the oldest candle, so a long fetch keeps its most recent points.
+//
+// Each field is stored in its own array (structure of arrays), so a pass over
+// one field, such as the closes for a line or the highs for scaling, walks
+// contiguous memory. Capacity must be a power of two so a logical index maps
+// to a slot with a mask.
+//
+// The lowest low and highest high are kept up to date as candles arrive, so
+// scaling a chart of the series needs no scan.
+//
+// Candle times are epoch seconds in order, so the times array doubles as an
+// index: finding the candle for a time is a binary search.
+//
+// Alongside the candles sits a pyramid of merged buckets for drawing the
+// series at any zoom. Level n holds buckets of 2^n candles aligned to the
+// candles' sequence numbers, so bucket k holds candles k * 2^n to
+// (k + 1) * 2^n - 1, and level 0 is the candles themselves. Appending merges
+// the new candle into one bucket per level. An eviction rebuilds the oldest
+// bucket of each level from the two below it, so both cost O(log Capacity),
+// and the pyramid takes about as much memory as the candles.
+template <size_t Capacity> class TimeSeries {
+	static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0,
+	              "TimeSeries capacity must be a power of two above 1");
+	static_assert(Capacity <= 65536, "Slot numbers are stored in 16 bits");
+
+  public:
+	static constexpr size_t capacity() { return Capacity; }
+	// Pyramid levels, level 0 included; the top one spans the whole series
+	static constexpr size_t levels() { return log2_floor(Capacity) + 1; }
+	size_t size() const { return count_; }
+	bool empty() const { return count_ == 0; }
+	bool full() const { return count_ == Capacity; }
+
+	// Empties the series. Buckets stay aligned to first_sequence, the
+	// sequence number the next candle gets, so a series rebuilt from a
+	// CandleRing is bucketed as one fed every candle the ring was.
+	void clear(uint32_t first_sequence = 0) {
+		head_ = 0;
+		count_ = 0;
+		next_sequence_ = first_sequence;
+		lowest_.clear();
+		highest_.clear();
+	}
+
+	// O(log Capacity); overwrites the oldest candle once full
+	void append(const Candle &candle) {
+		size_t slot = (head_ + count_) & MASK;
+		bool starting = empty();
+		bool evicting = full();
+		if (evicting) {
+			head_ = (head_ + 1) & MASK;
+		} else {
+			count_++;
+		}
+
+		lowest_.expire(slot);
+		highest_.expire(slot);
+
+		time_[slot] = candle.time;
+		open_[slot] = candle.open;
+		high_[slot] = candle.high;
+		low_[slot] = candle.low;
+		close_[slot] = candle.close;
+		volume_[slot] = candle.volume;
+
+		lowest_.push(slot, low_);
+		highest_.push(slot, high_);
+
+		// Merge into the newest bucket of each level, then, bottom up, redo
+		// the oldest buckets that lost a candle to the eviction
+		uint32_t sequence = next_sequence_++;
+		for (size_t level = 1; level < levels(); level++) {
+			Candle &bucket = bucket_slot(level, sequence >> level);
+			if (starting || (sequence & ((1u << level) - 1)) == 0) {
+				bucket = candle;
+			} else {
+				merge_candle(bucket, candle);
+			}
+		}
+		if (evicting) {
+			rebuild_oldest_buckets();
+		}
+	}
+
+	// Field access by logical index, 0 being the oldest candle held
+	uint32_t time(size_t i) const { return time_[slot(i)]; }
+	float open(size_t i) const { return open_[slot(i)]; }
+	float high(size_t i) const { return high_[slot(i)]; }
+	float low(size_t i) const { return low_[slot(i)]; }
+	float close(size_t i) const { return close_[slot(i)]; }
+	float volume(size_t i) const { return volume_[slot(i)]; }
+
+	Candle at(size_t i) const {
+		size_t s = slot(i);
+		return {time_[s], open_[s], high_[s], low_[s], close_[s], volume_[s]};
+	}
+
+	Candle front() const { return at(0); }
+	Candle back() const { return at(count_ - 1); }
+
+	// Extremes of the whole series; only valid when it isn't empty
+	float min_low() const { return low_[lowest_.best_slot()]; }
+	float max_high() const { return high_[highest_.best_slot()]; }
+
+	// Buckets held at a level, the oldest of which may be partial, as may the
+	// newest
+	size_t level_size(size_t level) const {
+		if (count_ == 0) {
+			return 0;
+		}
+		return ((next_sequence_ - 1) >> level) - (oldest_sequence() >> level) +
+		       1;
+	}
+
+	// Bucket i of a level by logical index, 0 being the oldest. Its time is
+	// that of its first candle still held.
+	Candle bucket(size_t level, size_t i) const {
+		if (level == 0) {
+			return at(i);
+		}
+		return pyramid_[bucket_index(level, (oldest_sequence() >> level) + i)];
+	}
+
+	// Logical index of the first candle at or after time, size() if there is
+	// none: a binary search, as the times of a fetch never decrease
+	size_t lower_bound_time(uint32_t time) const {
+		size_t low = 0;
+		size_t high = count_;
+		while (low < high) {
+			size_t mid = (low + high) / 2;
+			if (time_[slot(mid)] < time) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		return low;
+	}
+
+	// Seconds from candle i - 1 to candle i, 0 for the first candle or where
+	// either has no time. A step well over the series' interval is a gap,
+	// such as a night or a weekend.
+	uint32_t time_step(size_t i) const {
+		if (i == 0) {
+			return 0;
+		}
+		uint32_t before = time(i - 1);
+		uint32_t after = time(i);
+		return before != 0 && after > before ? after - before : 0;
+	}
+
+	// Logical index of the first of the most recent n candles, for drawing
+	// only as many as fit
+	size_t recent_start(size_t n) const { return n < count_ ? count_ - n : 0; }
+
+	// Calls fn(i, candle) for each of the most recent n candles, oldest first
+	template <typename Fn> void for_each_recent(size_t n, Fn fn) const {
+		for (size_t i = recent_start(n); i < count_; i++) {
+			fn(i, at(i));
+		}
+	}
+
+  private:
+	static constexpr size_t MASK = Capacity - 1;
+
+	size_t slot(size_t i) const { return (head_ + i) & MASK; }
+
+	uint32_t oldest_sequence() const {
+		return next_sequence_ - (uint32_t)count_;
+	}
+
+	// Level n >= 1 is a ring of Capacity / 2^n + 1 buckets, enough for a
+	// series whose oldest candle isn't aligned to a bucket. Rings are laid
+	// out one after another and indexed by bucket number.
+	static constexpr size_t level_offset(size_t level) {
+		return Capacity - (Capacity >> (level - 1)) + level - 1;
+	}
+	static constexpr size_t PYRAMID_SIZE =
+	    Capacity - 1 + log2_floor(Capacity);
+
+	static size_t bucket_index(size_t level, uint32_t id) {
+		return level_offset(level) + id % ((Capacity >> level) + 1);
+	}
+	Candle &bucket_slot(size_t level, uint32_t id) {
+		return pyramid_[bucket_index(level, id)];
+	}
+
+	// After an eviction the oldest bucket of a level is either gone, or
+	// straddles the oldest candle kept and is the merge of what remains of
+	// the one or two buckets under it
+	void rebuild_oldest_buckets() {
+		uint32_t oldest = oldest_sequence();
+		uint32_t newest = next_sequence_ - 1;
+		for (size_t level = 1; level < levels(); level++) {
+			if ((oldest & ((1u << level) - 1)) == 0) {
+				continue;
+			}
+			size_t below = level - 1;
+			uint32_t id = oldest >> level;
+			uint32_t last_child = std::min(id * 2 + 1, newest >> below);
+			Candle merged = bucket(below, 0);
+			if ((oldest >> below) < last_child) {
+				merge_candle(merged, bucket(below, 1));
+			}
+			bucket_slot(level, id) = merged;
+		}
+	}
+
+	uint32_t time_[Capacity];
+	float open_[Capacity];
+	float high_[Capacity];
+	float low_[Capacity];
+	float close_[Capacity];
+	float volume_[Capacity];
+	size_t head_ = 0;  // Slot of the oldest candle
+	size_t count_ = 0; // Candles held
+	uint32_t next_sequence_ = 0; // Sequence number of the next candle
+
+	Candle pyramid_[PYRAMID_SIZE];
+
+	ExtremumWindow<Capacity, Capacity, FloatLess> lowest_;
+	ExtremumWindow<Capacity, Capacity, FloatGreater> highest_;
+};
+
+// Just the candles of a TimeSeries: a ring that evicts the oldest, with no
+// extremes or pyramid to keep up, for series that are stored or handed on
+// rather than drawn. Under half the size of a TimeSeries of the same
+// capacity.
+template <size_t Capacity> class CandleRing {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+	              "CandleRing capacity must be a power of two");
+
+  public:
+	static constexpr size_t capacity() { return Capacity; }
+	size_t size() const { return count_; }
+	bool empty() const { return count_ == 0; }
+	bool full() const { return count_ == Capacity; }
+
+	void clear() {
+		head_ = 0;
+		count_ = 0;
+		next_sequence_ = 0;
+	}
+
+	// Overwrites the oldest candle once full
+	void append(const Candle &candle) {
+		candles_[(head_ + count_) & MASK] = candle;
+		next_sequence_++;
+		if (full()) {
+			head_ = (head_ + 1) & MASK;
+		} else {
+			count_++;
+		}
+	}
+
+	// By logical index, 0 being the oldest candle held
+	const Candle &at(size_t i) const { return candles_[(head_ + i) & MASK]; }
+	const Candle &front() const { return at(0); }
+	const Candle &back() const { return at(count_ - 1); }
+
+	// Extremes of the whole series by a scan; only valid when it isn't empty
+	float min_low() const {
+		float low = at(0).low;
+		for (size_t i = 1; i < count_; i++) {
+			low = std::min(low, at(i).low);
+		}
+		return low;
+	}
+	float max_high() const {
+		float high = at(0).high;
+		for (size_t i = 1; i < count_; i++) {
+			high = std::max(high, at(i).high);
+		}
+		return high;
+	}
+
+	// Candles appended since clear() before the oldest one held, to pass to
+	// TimeSeries::clear() when rebuilding from the ring
+	uint32_t oldest_sequence() const {
+		return next_sequence_ - (uint32_t)count_;
+	}
+
+	// As in TimeSeries
+	size_t recent_start(size_t n) const { return n < count_ ? count_ - n : 0; }
+	template <typename Fn> void for_each_recent(size_t n, Fn fn) const {
+		for (size_t i = recent_start(n); i < count_; i++) {
+			fn(i, at(i));
+		}
+	}
+
+  private:
+	static constexpr size_t MASK = Capacity - 1;
+
+	Candle candles_[Capacity];
+	uint32_t head_ = 0;
+	uint32_t count_ = 0;
+	uint32_t next_sequence_ = 0; // Sequence number of the next candle
+};
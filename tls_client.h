@@ -5,6 +5,8 @@
 #include <stddef.h> // for size_t
 #include <stdint.h>
 
+#include "lwip/ip_addr.h"
+
 // Opaque handle for TLS client
 typedef struct TLS_CLIENT_T_ *TLS_CLIENT_HANDLE;
 
@@ -25,6 +27,31 @@ TLS_CLIENT_HANDLE tls_client_init_and_connect(const char *server_hostname,
                                               const uint8_t *cert,
                                               size_t cert_len);
 
+/**
+ * Resolve a hostname, blocking until the DNS lookup completes
+ * @param hostname The hostname (or dotted IP string) to resolve
+ * @param out_addr Receives the resolved address
+ * @param timeout_ms Timeout in milliseconds
+ * @return true if the hostname was resolved, false otherwise
+ */
+bool tls_client_resolve(const char *hostname, ip_addr_t *out_addr,
+                        uint32_t timeout_ms);
+
+/**
+ * Open a TLS client connection to an already resolved address
+ * @param server_addr The address to connect to
+ * @param server_port The port to connect to
+ * @param sni The server name for the handshake (NULL for the default)
+ * @param cert The server certificate (can be NULL for no verification)
+ * @param cert_len Length of the certificate
+ * @return Handle to the TLS client if successful, NULL otherwise
+ */
+TLS_CLIENT_HANDLE tls_client_connect_addr(const ip_addr_t *server_addr,
+                                          uint16_t server_port,
+                                          const char *sni,
+                                          const uint8_t *cert,
+                                          size_t cert_len);
+
 /**
  * Send data and wait for response
  * @param handle The TLS client handle
@@ -16,7 +16,9 @@
 #include "pico/stdlib.h"
 #include "semphr.h"
 
+#include "dlog.h"
 #include "mbedtls/debug.h"
+#include "net_stats.h"
 #include "tls_client.h"
 
 // Error codes
@@ -25,6 +27,9 @@
 #define TLS_ERROR_MEMORY -3
 #define TLS_ERROR_CONNECTION -4
 
+// Server name sent in the TLS handshake when the caller doesn't supply one
+#define TLS_CLIENT_DEFAULT_SNI "server.local"
+
 typedef struct TLS_CLIENT_T_ {
 	struct altcp_pcb *pcb;
 	SemaphoreHandle_t complete_sem;
@@ -34,9 +39,41 @@ typedef struct TLS_CLIENT_T_ {
 	size_t recv_buffer_size;
 	size_t recv_len;
 	bool is_connected;
+	uint16_t port;
+	uint32_t connect_start_us;
+	uint32_t tcp_connected_us;
+#if STATIC_ALLOCATION
+	bool in_use;
+	StaticSemaphore_t complete_sem_buffer;
+	StaticSemaphore_t recv_sem_buffer;
+#endif
 } TLS_CLIENT_T;
 
+// State for a blocking DNS lookup. Only one lookup runs at a time, so a single
+// static request is enough and stays valid if a late callback arrives after
+// the caller has timed out.
+typedef struct TLS_DNS_REQUEST_T_ {
+	SemaphoreHandle_t done_sem;
+	ip_addr_t addr;
+	bool pending;
+	bool found;
+	uint32_t start_us;
+} TLS_DNS_REQUEST_T;
+
+static TLS_DNS_REQUEST_T dns_request;
+
+#if STATIC_ALLOCATION
+// The ticker only ever has one connection open
+#define TLS_CLIENT_POOL_SIZE 1
+static TLS_CLIENT_T client_pool[TLS_CLIENT_POOL_SIZE];
+static StaticSemaphore_t dns_sem_buffer;
+#endif
+
 static struct altcp_tls_config *tls_config = NULL;
+
+// altcp_tls's own connected callback on the inner TCP pcb, see
+// tls_client_hook_lower_connected()
+static altcp_connected_fn tls_lower_connected = NULL;
 #ifdef MBEDTLS_DEBUG_C
 // Example debug callback
 void my_debug(void *ctx, int level, const char *file, int line,
@@ -81,6 +118,13 @@ static err_t tls_client_connected(void *arg, struct altcp_pcb *pcb, err_t err) {
 		return tls_client_close_internal(state);
 	}
 
+	uint32_t now_us = time_us_32();
+	if (state->tcp_connected_us != 0) {
+		net_stats_record(NET_METRIC_TLS_HANDSHAKE,
+		                 now_us - state->tcp_connected_us);
+	}
+	net_stats_add(NET_COUNTER_CONNECTS, 1);
+
 	state->is_connected = true;
 	xSemaphoreGive(state->complete_sem);
 	return ERR_OK;
@@ -89,6 +133,7 @@ static err_t tls_client_connected(void *arg, struct altcp_pcb *pcb, err_t err) {
 static err_t tls_client_poll(void *arg, struct altcp_pcb *pcb) {
 	TLS_CLIENT_T *state = (TLS_CLIENT_T *)arg;
 	printf("timed out\n");
+	net_stats_add(NET_COUNTER_TIMEOUTS, 1);
 	state->error = TLS_ERROR_TIMEOUT;
 	return tls_client_close_internal(arg);
 }
@@ -96,6 +141,7 @@ static err_t tls_client_poll(void *arg, struct altcp_pcb *pcb) {
 static void tls_client_err(void *arg, err_t err) {
 	TLS_CLIENT_T *state = (TLS_CLIENT_T *)arg;
 	printf("tls_client_err %d\n", err);
+	net_stats_add(NET_COUNTER_ERRORS, 1);
 	state->error = TLS_ERROR_GENERIC;
 	tls_client_close_internal(state);
 }
@@ -104,12 +150,13 @@ static err_t tls_client_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p,
                              err_t err) {
 	TLS_CLIENT_T *state = (TLS_CLIENT_T *)arg;
 	if (!p) {
-		printf("connection closed\n");
+		DLOG_DEBUG("connection closed\n");
 		state->error = TLS_ERROR_CONNECTION;
 		return tls_client_close_internal(state);
 	}
 
 	if (p->tot_len > 0) {
+		net_stats_add(NET_COUNTER_BYTES_IN, p->tot_len);
 		if (state->recv_buffer && state->recv_buffer_size > 0) {
 			size_t copy_len = p->tot_len > state->recv_buffer_size
 			                      ? state->recv_buffer_size
@@ -124,6 +171,32 @@ static err_t tls_client_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p,
 	return ERR_OK;
 }
 
+// The outer TLS pcb only reports a connection once the handshake is done. To
+// time the TCP connect on its own, wrap the connected callback altcp_tls set
+// on the inner TCP pcb during altcp_connect; its arg is the outer pcb.
+static err_t tls_client_lower_connected_hook(void *arg,
+                                             struct altcp_pcb *inner_conn,
+                                             err_t err) {
+	struct altcp_pcb *conn = (struct altcp_pcb *)arg;
+	TLS_CLIENT_T *state = conn ? (TLS_CLIENT_T *)conn->arg : NULL;
+	if (state && err == ERR_OK) {
+		state->tcp_connected_us = time_us_32();
+		net_stats_record(NET_METRIC_TCP_CONNECT,
+		                 state->tcp_connected_us - state->connect_start_us);
+	}
+	return tls_lower_connected(arg, inner_conn, err);
+}
+
+static void tls_client_hook_lower_connected(TLS_CLIENT_T *state) {
+	struct altcp_pcb *inner_conn = state->pcb->inner_conn;
+	if (inner_conn == NULL || inner_conn->connected == NULL ||
+	    inner_conn->connected == tls_client_lower_connected_hook) {
+		return;
+	}
+	tls_lower_connected = inner_conn->connected;
+	inner_conn->connected = tls_client_lower_connected_hook;
+}
+
 static void tls_client_connect_to_server_ip(const ip_addr_t *ipaddr,
                                             TLS_CLIENT_T *state,
                                             uint16_t port) {
@@ -137,9 +210,15 @@ static void tls_client_connect_to_server_ip(const ip_addr_t *ipaddr,
 	mbedtls_debug_set_threshold(1);
 #endif
 
-	printf("connecting to server IP %s port %d\n", ipaddr_ntoa(ipaddr), port);
+	DLOG_INFO("connecting to server IP %d.%d.%d.%d port %d\n",
+	          ip4_addr1_16(ip_2_ip4(ipaddr)), ip4_addr2_16(ip_2_ip4(ipaddr)),
+	          ip4_addr3_16(ip_2_ip4(ipaddr)), ip4_addr4_16(ip_2_ip4(ipaddr)),
+	          port);
+	state->connect_start_us = time_us_32();
 	err = altcp_connect(state->pcb, ipaddr, port, tls_client_connected);
-	if (err != ERR_OK) {
+	if (err == ERR_OK) {
+		tls_client_hook_lower_connected(state);
+	} else {
 		printf("error initiating connect, err=%d\n", err);
 		state->error = TLS_ERROR_CONNECTION;
 		tls_client_close_internal(state);
@@ -151,8 +230,7 @@ static void tls_client_dns_found(const char *hostname, const ip_addr_t *ipaddr,
 	TLS_CLIENT_T *state = (TLS_CLIENT_T *)arg;
 	if (ipaddr) {
 		printf("DNS resolving complete\n");
-		tls_client_connect_to_server_ip(ipaddr, state,
-		                                8443); // TODO: Make port configurable
+		tls_client_connect_to_server_ip(ipaddr, state, state->port);
 	} else {
 		printf("error resolving hostname %s\n", hostname);
 		state->error = TLS_ERROR_CONNECTION;
@@ -160,10 +238,7 @@ static void tls_client_dns_found(const char *hostname, const ip_addr_t *ipaddr,
 	}
 }
 
-static bool tls_client_open(const char *hostname, TLS_CLIENT_T *state) {
-	err_t err;
-	ip_addr_t server_ip;
-
+static bool tls_client_create_pcb(TLS_CLIENT_T *state, const char *sni) {
 	state->pcb = altcp_tls_new(tls_config, IPADDR_TYPE_ANY);
 	if (!state->pcb) {
 		printf("failed to create pcb\n");
@@ -177,16 +252,24 @@ static bool tls_client_open(const char *hostname, TLS_CLIENT_T *state) {
 	altcp_err(state->pcb, tls_client_err);
 
 	/* Set SNI */
-	char *sni = "server.local";
 	mbedtls_ssl_set_hostname(altcp_tls_context(state->pcb), sni);
+	return true;
+}
+
+static bool tls_client_open(const char *hostname, TLS_CLIENT_T *state) {
+	err_t err;
+	ip_addr_t server_ip;
+
+	if (!tls_client_create_pcb(state, TLS_CLIENT_DEFAULT_SNI)) {
+		return false;
+	}
 
 	printf("resolving %s\n", hostname);
 
 	cyw43_arch_lwip_begin();
 	err = dns_gethostbyname(hostname, &server_ip, tls_client_dns_found, state);
 	if (err == ERR_OK) {
-		tls_client_connect_to_server_ip(&server_ip, state,
-		                                8443); // TODO: Make port configurable
+		tls_client_connect_to_server_ip(&server_ip, state, state->port);
 	} else if (err != ERR_INPROGRESS) {
 		printf("error initiating DNS resolving, err=%d\n", err);
 		state->error = TLS_ERROR_CONNECTION;
@@ -197,12 +280,70 @@ static bool tls_client_open(const char *hostname, TLS_CLIENT_T *state) {
 	return err == ERR_OK || err == ERR_INPROGRESS;
 }
 
-// New API Implementation
+static bool tls_client_open_addr(const ip_addr_t *server_addr,
+                                 const char *sni, TLS_CLIENT_T *state) {
+	if (!tls_client_create_pcb(state, sni)) {
+		return false;
+	}
 
-TLS_CLIENT_HANDLE tls_client_init_and_connect(const char *server_hostname,
-                                              uint16_t server_port,
-                                              const uint8_t *cert,
-                                              size_t cert_len) {
+	cyw43_arch_lwip_begin();
+	tls_client_connect_to_server_ip(server_addr, state, state->port);
+	cyw43_arch_lwip_end();
+
+	return state->error == 0;
+}
+
+static void tls_client_dns_request_found(const char *hostname,
+                                         const ip_addr_t *ipaddr, void *arg) {
+	TLS_DNS_REQUEST_T *request = (TLS_DNS_REQUEST_T *)arg;
+	if (!request->pending) {
+		return; // The caller already gave up on this lookup
+	}
+
+	request->pending = false;
+	request->found = ipaddr != NULL;
+	net_stats_record(NET_METRIC_DNS, time_us_32() - request->start_us);
+	if (ipaddr) {
+		ip_addr_copy(request->addr, *ipaddr);
+	} else {
+		printf("error resolving hostname %s\n", hostname);
+	}
+	xSemaphoreGive(request->done_sem);
+}
+
+#if STATIC_ALLOCATION
+// Take a client state and its semaphores from the static pool
+static TLS_CLIENT_T *tls_client_state_new(void) {
+	TLS_CLIENT_T *state = NULL;
+	taskENTER_CRITICAL();
+	for (int i = 0; i < TLS_CLIENT_POOL_SIZE; i++) {
+		if (!client_pool[i].in_use) {
+			state = &client_pool[i];
+			memset(state, 0, sizeof(*state));
+			state->in_use = true;
+			break;
+		}
+	}
+	taskEXIT_CRITICAL();
+	if (!state) {
+		printf("all TLS client states in use\n");
+		return NULL;
+	}
+
+	state->complete_sem =
+	    xSemaphoreCreateBinaryStatic(&state->complete_sem_buffer);
+	state->recv_sem = xSemaphoreCreateBinaryStatic(&state->recv_sem_buffer);
+	return state;
+}
+
+static void tls_client_state_delete(TLS_CLIENT_T *state) {
+	vSemaphoreDelete(state->complete_sem);
+	vSemaphoreDelete(state->recv_sem);
+	state->in_use = false;
+}
+#else
+// Allocate a client state and its semaphores
+static TLS_CLIENT_T *tls_client_state_new(void) {
 	TLS_CLIENT_T *state = calloc(1, sizeof(TLS_CLIENT_T));
 	if (!state) {
 		printf("failed to allocate state\n");
@@ -220,26 +361,42 @@ TLS_CLIENT_HANDLE tls_client_init_and_connect(const char *server_hostname,
 		free(state);
 		return NULL;
 	}
+	return state;
+}
 
-	tls_config = altcp_tls_create_config_client(cert, cert_len);
-	if (!tls_config) {
-		printf("failed to create TLS config\n");
+static void tls_client_state_delete(TLS_CLIENT_T *state) {
+	if (state->complete_sem)
 		vSemaphoreDelete(state->complete_sem);
+	if (state->recv_sem)
 		vSemaphoreDelete(state->recv_sem);
-		free(state);
+	free(state);
+}
+#endif
+
+// Allocate client state, its semaphores and the TLS config
+static TLS_CLIENT_T *tls_client_alloc(uint16_t server_port,
+                                      const uint8_t *cert, size_t cert_len) {
+	TLS_CLIENT_T *state = tls_client_state_new();
+	if (!state)
 		return NULL;
-	}
 
-	if (!tls_client_open(server_hostname, state)) {
-		vSemaphoreDelete(state->complete_sem);
-		vSemaphoreDelete(state->recv_sem);
-		free(state);
+	tls_config = altcp_tls_create_config_client(cert, cert_len);
+	if (!tls_config) {
+		printf("failed to create TLS config\n");
+		tls_client_state_delete(state);
 		return NULL;
 	}
 
+	state->port = server_port;
+	return state;
+}
+
+// Block until the connection attempt started on state completes
+static TLS_CLIENT_HANDLE tls_client_wait_connected(TLS_CLIENT_T *state) {
 	// Wait for connection with timeout
 	if (xSemaphoreTake(state->complete_sem, pdMS_TO_TICKS(10000)) != pdTRUE) {
 		printf("Connection timed out\n");
+		net_stats_add(NET_COUNTER_TIMEOUTS, 1);
 		state->error = TLS_ERROR_TIMEOUT;
 		tls_client_close((TLS_CLIENT_HANDLE)state);
 		return NULL;
@@ -253,6 +410,96 @@ TLS_CLIENT_HANDLE tls_client_init_and_connect(const char *server_hostname,
 	return (TLS_CLIENT_HANDLE)state;
 }
 
+// New API Implementation
+
+bool tls_client_resolve(const char *hostname, ip_addr_t *out_addr,
+                        uint32_t timeout_ms) {
+	if (dns_request.done_sem == NULL) {
+#if STATIC_ALLOCATION
+		dns_request.done_sem = xSemaphoreCreateBinaryStatic(&dns_sem_buffer);
+#else
+		dns_request.done_sem = xSemaphoreCreateBinary();
+#endif
+		if (dns_request.done_sem == NULL) {
+			printf("failed to create DNS semaphore\n");
+			return false;
+		}
+	}
+	// Drop any stale completion left over from a timed out lookup
+	xSemaphoreTake(dns_request.done_sem, 0);
+
+	printf("resolving %s\n", hostname);
+
+	cyw43_arch_lwip_begin();
+	dns_request.pending = true;
+	dns_request.found = false;
+	dns_request.start_us = time_us_32();
+	err_t err = dns_gethostbyname(hostname, &dns_request.addr,
+	                              tls_client_dns_request_found, &dns_request);
+	if (err != ERR_INPROGRESS) {
+		dns_request.pending = false;
+		dns_request.found = err == ERR_OK;
+	}
+	cyw43_arch_lwip_end();
+
+	if (err == ERR_INPROGRESS &&
+	    xSemaphoreTake(dns_request.done_sem, pdMS_TO_TICKS(timeout_ms)) !=
+	        pdTRUE) {
+		cyw43_arch_lwip_begin();
+		dns_request.pending = false;
+		cyw43_arch_lwip_end();
+		printf("DNS lookup for %s timed out\n", hostname);
+		net_stats_add(NET_COUNTER_TIMEOUTS, 1);
+		return false;
+	}
+
+	if (!dns_request.found) {
+		if (err != ERR_INPROGRESS) {
+			printf("error initiating DNS resolving, err=%d\n", err);
+		}
+		return false;
+	}
+
+	ip_addr_copy(*out_addr, dns_request.addr);
+	return true;
+}
+
+TLS_CLIENT_HANDLE tls_client_init_and_connect(const char *server_hostname,
+                                              uint16_t server_port,
+                                              const uint8_t *cert,
+                                              size_t cert_len) {
+	TLS_CLIENT_T *state = tls_client_alloc(server_port, cert, cert_len);
+	if (!state) {
+		return NULL;
+	}
+
+	if (!tls_client_open(server_hostname, state)) {
+		tls_client_close((TLS_CLIENT_HANDLE)state);
+		return NULL;
+	}
+
+	return tls_client_wait_connected(state);
+}
+
+TLS_CLIENT_HANDLE tls_client_connect_addr(const ip_addr_t *server_addr,
+                                          uint16_t server_port,
+                                          const char *sni,
+                                          const uint8_t *cert,
+                                          size_t cert_len) {
+	TLS_CLIENT_T *state = tls_client_alloc(server_port, cert, cert_len);
+	if (!state) {
+		return NULL;
+	}
+
+	if (!tls_client_open_addr(server_addr, sni ? sni : TLS_CLIENT_DEFAULT_SNI,
+	                          state)) {
+		tls_client_close((TLS_CLIENT_HANDLE)state);
+		return NULL;
+	}
+
+	return tls_client_wait_connected(state);
+}
+
 int tls_client_send_and_recv(TLS_CLIENT_HANDLE handle,
                              const uint8_t *send_buffer, size_t send_len,
                              uint8_t *recv_buffer, size_t recv_buffer_size,
@@ -270,12 +517,15 @@ int tls_client_send_and_recv(TLS_CLIENT_HANDLE handle,
 	    altcp_write(state->pcb, send_buffer, send_len, TCP_WRITE_FLAG_COPY);
 	if (err != ERR_OK) {
 		printf("error writing data, err=%d\n", err);
+		net_stats_add(NET_COUNTER_ERRORS, 1);
 		return TLS_ERROR_GENERIC;
 	}
+	net_stats_add(NET_COUNTER_BYTES_OUT, send_len);
 
 	// Wait for response with timeout
 	if (xSemaphoreTake(state->recv_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
 		printf("Receive timed out\n");
+		net_stats_add(NET_COUNTER_TIMEOUTS, 1);
 		return TLS_ERROR_TIMEOUT;
 	}
 
@@ -289,17 +539,10 @@ void tls_client_close(TLS_CLIENT_HANDLE handle) {
 	TLS_CLIENT_T *state = (TLS_CLIENT_T *)handle;
 	tls_client_close_internal(state);
 
-	if (state->complete_sem) {
-		vSemaphoreDelete(state->complete_sem);
-	}
-	if (state->recv_sem) {
-		vSemaphoreDelete(state->recv_sem);
-	}
-
 	if (tls_config) {
 		altcp_tls_free_config(tls_config);
 		tls_config = NULL;
 	}
 
-	free(state);
+	tls_client_state_delete(state);
 }
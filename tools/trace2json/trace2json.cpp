@@ -0,0 +1,267 @@
+// Convert a trace_buffer dump into Chrome trace event JSON.
+//
+// Usage: trace2json [dump.txt [trace.json]]
+//
+// The dump is the text printed by the "trace" console command, and may be a
+// whole serial log: everything outside TRACE BEGIN/END is ignored. The output
+// has one track per core showing which task ran, one track per task, and
+// instant events for queue, semaphore and event group activity.
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Event {
+	uint64_t time_us;
+	std::string type;
+	uint32_t object;
+};
+
+struct Trace {
+	int cores = 0;
+	std::map<uint32_t, std::string> task_names;
+	std::map<uint32_t, std::string> object_names;
+	std::vector<std::vector<Event>> events; // per core, oldest first
+};
+
+// Chrome trace process ids for the two views
+static const int CORE_PID = 1;
+static const int TASK_PID = 2;
+
+static bool parse_dump(std::istream &in, Trace &trace) {
+	std::string line;
+	bool inside = false;
+	bool found = false;
+	std::vector<uint64_t> last_time;
+
+	while (std::getline(in, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		std::istringstream fields(line);
+		std::string tag;
+		fields >> tag;
+
+		if (!inside) {
+			std::string word;
+			if (tag == "TRACE" && fields >> word && word == "BEGIN") {
+				// A later dump replaces an earlier one
+				trace = Trace();
+				fields >> trace.cores;
+				if (trace.cores <= 0)
+					trace.cores = 1;
+				trace.events.resize(trace.cores);
+				last_time.assign(trace.cores, 0);
+				inside = true;
+			}
+			continue;
+		}
+
+		if (tag == "TRACE") {
+			inside = false;
+			found = true;
+		} else if (tag == "T" || tag == "O") {
+			std::string handle, name;
+			fields >> handle;
+			std::getline(fields >> std::ws, name);
+			uint32_t id = (uint32_t)std::stoul(handle, nullptr, 16);
+			(tag == "T" ? trace.task_names : trace.object_names)[id] = name;
+		} else if (tag == "E") {
+			int core;
+			uint32_t time;
+			std::string type, object;
+			if (!(fields >> core >> time >> type >> object) || core < 0 ||
+			    core >= trace.cores)
+				continue;
+
+			// Timestamps are 32-bit microseconds; unwrap them per core
+			uint64_t full = (last_time[core] & ~0xffffffffull) | time;
+			if (full < last_time[core])
+				full += 1ull << 32;
+			last_time[core] = full;
+
+			trace.events[core].push_back(
+			    {full, type, (uint32_t)std::stoul(object, nullptr, 16)});
+		}
+	}
+	return found;
+}
+
+static std::string json_string(const std::string &s) {
+	std::string out = "\"";
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if ((unsigned char)c < 0x20) {
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			out += buf;
+		} else {
+			out += c;
+		}
+	}
+	return out + "\"";
+}
+
+static std::string hex_name(const char *prefix, uint32_t id) {
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%s %08x", prefix, id);
+	return buf;
+}
+
+class JsonWriter {
+  public:
+	explicit JsonWriter(std::ostream &out) : out_(out) {
+		out_ << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	}
+	~JsonWriter() { out_ << "\n]}\n"; }
+
+	void metadata(const char *kind, int pid, int tid, const std::string &name) {
+		begin();
+		out_ << "{\"ph\":\"M\",\"name\":\"" << kind << "\",\"pid\":" << pid
+		     << ",\"tid\":" << tid << ",\"args\":{\"name\":" << json_string(name)
+		     << "}}";
+	}
+
+	void slice(int pid, int tid, const std::string &name, uint64_t start,
+	           uint64_t end, const std::string &arg_name,
+	           const std::string &arg) {
+		begin();
+		out_ << "{\"ph\":\"X\",\"name\":" << json_string(name)
+		     << ",\"pid\":" << pid << ",\"tid\":" << tid << ",\"ts\":" << start
+		     << ",\"dur\":" << (end - start) << ",\"args\":{"
+		     << json_string(arg_name) << ":" << json_string(arg) << "}}";
+	}
+
+	void instant(int pid, int tid, const std::string &name, uint64_t time,
+	             const std::string &task) {
+		begin();
+		out_ << "{\"ph\":\"i\",\"s\":\"t\",\"name\":" << json_string(name)
+		     << ",\"pid\":" << pid << ",\"tid\":" << tid << ",\"ts\":" << time
+		     << ",\"args\":{\"task\":" << json_string(task) << "}}";
+	}
+
+  private:
+	void begin() {
+		if (!first_)
+			out_ << ",\n";
+		first_ = false;
+	}
+
+	std::ostream &out_;
+	bool first_ = true;
+};
+
+static void write_json(const Trace &trace, std::ostream &out) {
+	// Line the cores up on a shared time origin
+	uint64_t origin = UINT64_MAX;
+	for (const auto &core_events : trace.events) {
+		if (!core_events.empty() && core_events.front().time_us < origin)
+			origin = core_events.front().time_us;
+	}
+	if (origin == UINT64_MAX)
+		origin = 0;
+
+	std::map<uint32_t, int> task_tids;
+	auto task_name = [&](uint32_t id) {
+		auto it = trace.task_names.find(id);
+		return it != trace.task_names.end() ? it->second : hex_name("task", id);
+	};
+	auto task_tid = [&](uint32_t id) {
+		auto it = task_tids.find(id);
+		if (it != task_tids.end())
+			return it->second;
+		int tid = (int)task_tids.size() + 1;
+		task_tids[id] = tid;
+		return tid;
+	};
+	auto object_name = [&](uint32_t id) {
+		auto it = trace.object_names.find(id);
+		return it != trace.object_names.end() ? it->second
+		                                      : hex_name("object", id);
+	};
+
+	JsonWriter json(out);
+	json.metadata("process_name", CORE_PID, 0, "Cores");
+	json.metadata("process_name", TASK_PID, 0, "Tasks");
+
+	for (int core = 0; core < trace.cores; core++) {
+		json.metadata("thread_name", CORE_PID, core, "core" + std::to_string(core));
+
+		bool running = false;
+		uint32_t current = 0;
+		uint64_t since = 0;
+		auto end_slice = [&](uint64_t at) {
+			if (!running)
+				return;
+			std::string name = task_name(current);
+			json.slice(CORE_PID, core, name, since - origin, at - origin, "task",
+			           name);
+			json.slice(TASK_PID, task_tid(current), name, since - origin,
+			           at - origin, "core", std::to_string(core));
+			running = false;
+		};
+
+		for (const Event &event : trace.events[core]) {
+			if (event.type == "in") {
+				end_slice(event.time_us);
+				running = true;
+				current = event.object;
+				since = event.time_us;
+			} else if (event.type == "out") {
+				if (running && event.object == current)
+					end_slice(event.time_us);
+			} else {
+				json.instant(CORE_PID, core,
+				             event.type + " " + object_name(event.object),
+				             event.time_us - origin,
+				             running ? task_name(current) : "");
+			}
+		}
+		if (!trace.events[core].empty())
+			end_slice(trace.events[core].back().time_us);
+	}
+
+	for (const auto &entry : task_tids) {
+		json.metadata("thread_name", TASK_PID, entry.second,
+		              task_name(entry.first));
+	}
+}
+
+int main(int argc, char **argv) {
+	std::ifstream in_file;
+	std::istream *in = &std::cin;
+	if (argc > 1) {
+		in_file.open(argv[1]);
+		if (!in_file) {
+			fprintf(stderr, "Cannot open %s\n", argv[1]);
+			return 1;
+		}
+		in = &in_file;
+	}
+
+	Trace trace;
+	if (!parse_dump(*in, trace)) {
+		fprintf(stderr, "No complete TRACE BEGIN/END block found\n");
+		return 1;
+	}
+
+	std::ofstream out_file;
+	std::ostream *out = &std::cout;
+	if (argc > 2) {
+		out_file.open(argv[2]);
+		if (!out_file) {
+			fprintf(stderr, "Cannot open %s\n", argv[2]);
+			return 1;
+		}
+		out = &out_file;
+	}
+
+	write_json(trace, *out);
+	return 0;
+}
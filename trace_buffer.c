@@ -0,0 +1,118 @@
+#include "trace_buffer.h"
+
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define TRACE_BUFFER_MAX_TASKS 24
+
+typedef struct {
+	TraceEvent events[TRACE_BUFFER_EVENTS];
+	uint32_t count; // Total ever written; the ring holds the last few
+} TraceRing;
+
+typedef struct {
+	const void *object;
+	const char *name;
+} TraceName;
+
+// Each core only writes its own ring, with interrupts masked, so no lock
+static TraceRing rings[configNUMBER_OF_CORES];
+static volatile bool recording = true;
+
+static TraceName names[TRACE_BUFFER_MAX_NAMES];
+static size_t num_names = 0;
+
+static TaskStatus_t task_status[TRACE_BUFFER_MAX_TASKS];
+
+static const char *const event_names[TRACE_EVENT_COUNT] = {
+    "in",
+    "out",
+    "send",
+    "send_failed",
+    "receive",
+    "receive_failed",
+    "block_send",
+    "block_receive",
+    "set_bits",
+    "wait_bits",
+};
+
+void trace_buffer_record(TraceEventType type, const void *object) {
+	if (!recording)
+		return;
+
+	UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+	TraceRing *ring = &rings[portGET_CORE_ID()];
+	TraceEvent *event = &ring->events[ring->count % TRACE_BUFFER_EVENTS];
+	event->time_us = (uint32_t)portGET_RUN_TIME_COUNTER_VALUE();
+	event->object = (uint32_t)(uintptr_t)object;
+	event->type = (uint8_t)type;
+	ring->count++;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+void trace_buffer_task_switch(TraceEventType type) {
+	trace_buffer_record(type, xTaskGetCurrentTaskHandle());
+}
+
+void trace_buffer_name_object(const void *object, const char *name) {
+	taskENTER_CRITICAL();
+	if (num_names < TRACE_BUFFER_MAX_NAMES) {
+		names[num_names++] = (TraceName){object, name};
+	}
+	taskEXIT_CRITICAL();
+}
+
+void trace_buffer_enable(bool enable) { recording = enable; }
+
+void trace_buffer_clear(void) {
+	bool was_recording = recording;
+	recording = false;
+	for (int core = 0; core < configNUMBER_OF_CORES; core++) {
+		rings[core].count = 0;
+	}
+	recording = was_recording;
+}
+
+const char *trace_buffer_event_name(TraceEventType type) {
+	return type < TRACE_EVENT_COUNT ? event_names[type] : "unknown";
+}
+
+void trace_buffer_dump(void) {
+	bool was_recording = recording;
+	recording = false;
+
+	// Let a record that was in progress on the other core finish
+	vTaskDelay(1);
+
+	printf("TRACE BEGIN %d\n", configNUMBER_OF_CORES);
+
+	UBaseType_t num_tasks =
+	    uxTaskGetSystemState(task_status, TRACE_BUFFER_MAX_TASKS, NULL);
+	for (UBaseType_t i = 0; i < num_tasks; i++) {
+		printf("T %08lx %s\n", (unsigned long)(uintptr_t)task_status[i].xHandle,
+		       task_status[i].pcTaskName);
+	}
+	for (size_t i = 0; i < num_names; i++) {
+		printf("O %08lx %s\n", (unsigned long)(uintptr_t)names[i].object,
+		       names[i].name);
+	}
+
+	for (int core = 0; core < configNUMBER_OF_CORES; core++) {
+		const TraceRing *ring = &rings[core];
+		uint32_t first = ring->count > TRACE_BUFFER_EVENTS
+		                     ? ring->count - TRACE_BUFFER_EVENTS
+		                     : 0;
+		for (uint32_t i = first; i < ring->count; i++) {
+			const TraceEvent *event = &ring->events[i % TRACE_BUFFER_EVENTS];
+			printf("E %d %lu %s %08lx\n", core, (unsigned long)event->time_us,
+			       trace_buffer_event_name((TraceEventType)event->type),
+			       (unsigned long)event->object);
+		}
+	}
+
+	printf("TRACE END\n");
+	recording = was_recording;
+}
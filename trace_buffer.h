@@ -0,0 +1,92 @@
+#ifndef TRACE_BUFFER_H
+#define TRACE_BUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Kernel event recorder. The trace macros in trace_hooks.h append events to a
+// ring per core, oldest overwritten first, so the buffer always holds the
+// most recent stretch of scheduling history. trace_buffer_dump() prints it as
+// text for tools/trace2json to turn into Chrome/Perfetto trace JSON.
+
+// Events kept per core, 12 bytes each
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS 512
+#endif
+
+// Objects that can be given a readable name in the dump
+#define TRACE_BUFFER_MAX_NAMES 16
+
+typedef enum {
+	TRACE_EVENT_TASK_SWITCHED_IN = 0,
+	TRACE_EVENT_TASK_SWITCHED_OUT,
+	TRACE_EVENT_QUEUE_SEND,
+	TRACE_EVENT_QUEUE_SEND_FAILED,
+	TRACE_EVENT_QUEUE_RECEIVE,
+	TRACE_EVENT_QUEUE_RECEIVE_FAILED,
+	TRACE_EVENT_QUEUE_BLOCK_SEND,
+	TRACE_EVENT_QUEUE_BLOCK_RECEIVE,
+	TRACE_EVENT_EVENT_GROUP_SET,
+	TRACE_EVENT_EVENT_GROUP_BLOCK,
+	TRACE_EVENT_COUNT
+} TraceEventType;
+
+// Object is the task handle for task events and the queue, semaphore or
+// event group handle for the others
+typedef struct {
+	uint32_t time_us;
+	uint32_t object;
+	uint8_t type;
+} TraceEvent;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Append an event for the calling core. Called from the kernel's trace
+ * macros, possibly with interrupts already masked.
+ * @param type What happened
+ * @param object The task, queue or event group it happened to
+ */
+void trace_buffer_record(TraceEventType type, const void *object);
+
+/**
+ * Record a task switch for the task now current on this core
+ * @param type TRACE_EVENT_TASK_SWITCHED_IN or TRACE_EVENT_TASK_SWITCHED_OUT
+ */
+void trace_buffer_task_switch(TraceEventType type);
+
+/**
+ * Label a queue, semaphore or event group in the dump
+ * @param object The handle
+ * @param name A string that outlives the trace, such as a literal
+ */
+void trace_buffer_name_object(const void *object, const char *name);
+
+/**
+ * Pause or resume recording. Recording starts enabled.
+ */
+void trace_buffer_enable(bool enable);
+
+/**
+ * Forget all recorded events
+ */
+void trace_buffer_clear(void);
+
+/**
+ * Print the buffer and the task and object names to stdout. Recording is
+ * paused while printing.
+ */
+void trace_buffer_dump(void);
+
+/**
+ * @return A short name for an event type, as used in the dump
+ */
+const char *trace_buffer_event_name(TraceEventType type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_BUFFER_H
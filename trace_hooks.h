@@ -0,0 +1,48 @@
+#ifndef TRACE_HOOKS_H
+#define TRACE_HOOKS_H
+
+// FreeRTOS trace macros, pulled in at the end of FreeRTOSConfig.h. They run
+// inside the kernel with interrupts masked, so every hook must be short.
+
+#include "core_load.h"
+#include "heap_stats.h"
+#include "trace_buffer.h"
+
+#define traceTASK_SWITCHED_IN()                                                \
+	do {                                                                       \
+		core_load_task_switched_in();                                          \
+		trace_buffer_task_switch(TRACE_EVENT_TASK_SWITCHED_IN);                \
+	} while (0)
+#define traceTASK_SWITCHED_OUT()                                               \
+	do {                                                                       \
+		trace_buffer_task_switch(TRACE_EVENT_TASK_SWITCHED_OUT);               \
+		core_load_task_switched_out();                                         \
+	} while (0)
+
+// Semaphores and mutexes are queues, so these cover them too
+#define traceQUEUE_SEND(pxQueue)                                               \
+	trace_buffer_record(TRACE_EVENT_QUEUE_SEND, pxQueue)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)                                      \
+	trace_buffer_record(TRACE_EVENT_QUEUE_SEND, pxQueue)
+#define traceQUEUE_SEND_FAILED(pxQueue)                                        \
+	trace_buffer_record(TRACE_EVENT_QUEUE_SEND_FAILED, pxQueue)
+#define traceQUEUE_RECEIVE(pxQueue)                                            \
+	trace_buffer_record(TRACE_EVENT_QUEUE_RECEIVE, pxQueue)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)                                   \
+	trace_buffer_record(TRACE_EVENT_QUEUE_RECEIVE, pxQueue)
+#define traceQUEUE_RECEIVE_FAILED(pxQueue)                                     \
+	trace_buffer_record(TRACE_EVENT_QUEUE_RECEIVE_FAILED, pxQueue)
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue)                                   \
+	trace_buffer_record(TRACE_EVENT_QUEUE_BLOCK_SEND, pxQueue)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue)                                \
+	trace_buffer_record(TRACE_EVENT_QUEUE_BLOCK_RECEIVE, pxQueue)
+
+#define traceEVENT_GROUP_SET_BITS(xEventGroup, uxBitsToSet)                    \
+	trace_buffer_record(TRACE_EVENT_EVENT_GROUP_SET, xEventGroup)
+#define traceEVENT_GROUP_WAIT_BITS_BLOCK(xEventGroup, uxBitsToWaitFor)         \
+	trace_buffer_record(TRACE_EVENT_EVENT_GROUP_BLOCK, xEventGroup)
+
+#define traceMALLOC(pvAddress, uiSize) heap_stats_malloc(pvAddress, uiSize)
+#define traceFREE(pvAddress, uiSize) heap_stats_free(pvAddress, uiSize)
+
+#endif // TRACE_HOOKS_H
@@ -0,0 +1,133 @@
+#include "watchlist.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "FreeRTOS.h"
+#include "pico/stdlib.h"
+#include "semphr.h"
+
+#include "console.hpp"
+#include "display.hpp"
+
+static StockWatchlist watchlist;
+
+// The console task reads what the network task writes
+static SemaphoreHandle_t watchlist_lock = NULL;
+
+static uint32_t now_ms() { return to_ms_since_boot(get_absolute_time()); }
+
+static void cmd_watch(int argc, char **argv) {
+	(void)argc;
+	(void)argv;
+	watchlist_print();
+}
+
+size_t watchlist_init(const char *symbols) {
+#if STATIC_ALLOCATION
+	static StaticSemaphore_t watchlist_lock_buffer;
+	watchlist_lock = xSemaphoreCreateMutexStatic(&watchlist_lock_buffer);
+#else
+	watchlist_lock = xSemaphoreCreateMutex();
+#endif
+	if (watchlist_lock == NULL) {
+		printf("Failed to create watchlist lock\n");
+		return 0;
+	}
+
+	size_t added = 0;
+	const char *start = symbols;
+	while (*start != '\0') {
+		const char *end = strchr(start, ',');
+		size_t len = end ? (size_t)(end - start) : strlen(start);
+		char symbol[StockWatchlist::MAX_SYMBOL_LENGTH + 1];
+		if (len > 0 && len < sizeof(symbol)) {
+			memcpy(symbol, start, len);
+			symbol[len] = '\0';
+			if (watchlist.add(symbol)) {
+				added++;
+			} else {
+				printf("Watchlist full, skipping %s\n", symbol);
+			}
+		} else if (len > 0) {
+			printf("Watchlist symbol too long: %.*s\n", (int)len, start);
+		}
+		if (!end) {
+			break;
+		}
+		start = end + 1;
+	}
+
+	console_register("watch", "watchlist slots and memory", cmd_watch);
+	return added;
+}
+
+size_t watchlist_size() {
+	xSemaphoreTake(watchlist_lock, portMAX_DELAY);
+	size_t size = watchlist.size();
+	xSemaphoreGive(watchlist_lock);
+	return size;
+}
+
+bool watchlist_symbol(size_t i, char *symbol, size_t symbol_size) {
+	xSemaphoreTake(watchlist_lock, portMAX_DELAY);
+	bool found = i < watchlist.size();
+	if (found) {
+		snprintf(symbol, symbol_size, "%s", watchlist.at(i).symbol);
+	}
+	xSemaphoreGive(watchlist_lock);
+	return found;
+}
+
+bool watchlist_record(const StockData &data, bool fetched) {
+	xSemaphoreTake(watchlist_lock, portMAX_DELAY);
+	StockWatchlist::Slot *slot = watchlist.find(data.symbol);
+	if (slot) {
+		// The most recent candles only; the slot's series is the shorter
+		slot->series.clear();
+		data.history.for_each_recent(
+		    slot->series.capacity(),
+		    [&](size_t, const Candle &candle) { slot->series.append(candle); });
+		slot->open_price = data.open_price;
+		slot->high_price = data.high_price;
+		slot->low_price = data.low_price;
+		slot->current_price = data.current_price;
+		slot->price_change = data.price_change;
+		slot->percent_change = data.percent_change;
+		if (fetched) {
+			slot->updated_ms = now_ms();
+			slot->updates++;
+		}
+	}
+	xSemaphoreGive(watchlist_lock);
+	return slot != nullptr;
+}
+
+void watchlist_print() {
+	uint32_t now = now_ms();
+	xSemaphoreTake(watchlist_lock, portMAX_DELAY);
+	printf("%-8s %7s %10s %8s %8s %7s\n", "symbol", "candles", "price",
+	       "change%", "updates", "age s");
+	for (size_t i = 0; i < watchlist.size(); i++) {
+		const StockWatchlist::Slot &slot = watchlist.at(i);
+		if (slot.series.empty()) {
+			printf("%-8s %7s %10s %8s %8s %7s !\n", slot.symbol, "-", "-", "-",
+			       "0", "-");
+			continue;
+		}
+		char age[12] = "-";
+		if (slot.updates > 0) {
+			snprintf(age, sizeof(age), "%lu",
+			         (unsigned long)((now - slot.updated_ms) / 1000));
+		}
+		printf("%-8s %7u %10.2f %8.2f %8lu %7s%s\n", slot.symbol,
+		       (unsigned)slot.series.size(), slot.current_price,
+		       slot.percent_change, (unsigned long)slot.updates, age,
+		       slot.stale(now, WATCHLIST_STALE_MS) ? " !" : "");
+	}
+	printf("%u/%u slots of %u candles, %u bytes (budget %u), ! = stale\n",
+	       (unsigned)watchlist.size(), (unsigned)watchlist.capacity(),
+	       (unsigned)WATCHLIST_SERIES_CAPACITY, (unsigned)sizeof(watchlist),
+	       (unsigned)WATCHLIST_MEMORY_BUDGET);
+	xSemaphoreGive(watchlist_lock);
+}
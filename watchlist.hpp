@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "time_series.hpp"
+
+struct StockData;
+
+// Tickers the watchlist can follow, and the candles kept for each. The chart
+// keeps its own longer series for the symbol on screen.
+#ifndef WATCHLIST_MAX_SYMBOLS
+#define WATCHLIST_MAX_SYMBOLS 16
+#endif
+#ifndef WATCHLIST_SERIES_CAPACITY
+#define WATCHLIST_SERIES_CAPACITY 32
+#endif
+
+// Upper bound on the watchlist's RAM, checked at compile time
+#define WATCHLIST_MEMORY_BUDGET (32 * 1024)
+
+// A symbol is stale once this long has passed without an update
+#define WATCHLIST_STALE_MS (5 * 60 * 1000)
+
+// Fixed pool of per-symbol slots, each holding a short series and the
+// summary figures of the last fetch. Slots are kept in the order symbols
+// were added, and found through an index of symbol keys kept sorted, so a
+// lookup is a binary search over Slots integers. Nothing is allocated after
+// construction.
+template <size_t Slots, size_t SeriesCapacity> class Watchlist {
+	static_assert(Slots > 0 && Slots <= 256,
+	              "Slot numbers are stored in 8 bits");
+
+  public:
+	// Symbols are at most this long
+	static constexpr size_t MAX_SYMBOL_LENGTH = 7;
+
+	struct Slot {
+		char symbol[MAX_SYMBOL_LENGTH + 1];
+		CandleRing<SeriesCapacity> series;
+		float open_price;
+		float high_price;
+		float low_price;
+		float current_price;
+		float price_change;
+		float percent_change;
+		uint32_t updated_ms; // When the last update arrived
+		uint32_t updates;    // 0 until the first update
+
+		bool stale(uint32_t now_ms, uint32_t max_age_ms) const {
+			return updates == 0 || now_ms - updated_ms > max_age_ms;
+		}
+	};
+
+	static constexpr size_t capacity() { return Slots; }
+	size_t size() const { return count_; }
+	bool full() const { return count_ == Slots; }
+
+	void clear() { count_ = 0; }
+
+	// Slot i in the order symbols were added
+	Slot &at(size_t i) { return slots_[i]; }
+	const Slot &at(size_t i) const { return slots_[i]; }
+
+	// The symbol's slot, added empty if it has none. nullptr when the pool
+	// is full or the symbol is empty or too long.
+	Slot *add(const char *symbol) {
+		uint64_t key = key_of(symbol);
+		if (key == 0) {
+			return nullptr;
+		}
+		size_t pos = lower_bound(key);
+		if (pos < count_ && keys_[pos] == key) {
+			return &slots_[index_[pos]];
+		}
+		if (full()) {
+			return nullptr;
+		}
+
+		memmove(&keys_[pos + 1], &keys_[pos],
+		        (count_ - pos) * sizeof(keys_[0]));
+		memmove(&index_[pos + 1], &index_[pos],
+		        (count_ - pos) * sizeof(index_[0]));
+		keys_[pos] = key;
+		index_[pos] = (uint8_t)count_;
+
+		Slot &slot = slots_[count_++];
+		memset(slot.symbol, 0, sizeof(slot.symbol));
+		memcpy(slot.symbol, symbol, strlen(symbol));
+		slot.series.clear();
+		slot.open_price = slot.high_price = slot.low_price = 0;
+		slot.current_price = slot.price_change = slot.percent_change = 0;
+		slot.updated_ms = 0;
+		slot.updates = 0;
+		return &slot;
+	}
+
+	// Drop a symbol, closing the gap so the others keep their order.
+	// O(Slots) slot copies.
+	bool remove(const char *symbol) {
+		uint64_t key = key_of(symbol);
+		size_t pos = lower_bound(key);
+		if (key == 0 || pos == count_ || keys_[pos] != key) {
+			return false;
+		}
+		size_t slot = index_[pos];
+		count_--;
+		for (size_t i = slot; i < count_; i++) {
+			slots_[i] = slots_[i + 1];
+		}
+		for (size_t i = pos; i < count_; i++) {
+			keys_[i] = keys_[i + 1];
+			index_[i] = index_[i + 1];
+		}
+		for (size_t i = 0; i < count_; i++) {
+			if (index_[i] > slot) {
+				index_[i]--;
+			}
+		}
+		return true;
+	}
+
+	Slot *find(const char *symbol) {
+		uint64_t key = key_of(symbol);
+		size_t pos = lower_bound(key);
+		if (key == 0 || pos == count_ || keys_[pos] != key) {
+			return nullptr;
+		}
+		return &slots_[index_[pos]];
+	}
+	const Slot *find(const char *symbol) const {
+		return const_cast<Watchlist *>(this)->find(symbol);
+	}
+
+  private:
+	// The characters packed first-most-significant, so keys sort like the
+	// strings. 0 for a symbol that is empty or too long.
+	static uint64_t key_of(const char *symbol) {
+		uint64_t key = 0;
+		size_t len = 0;
+		for (; symbol[len] != '\0'; len++) {
+			if (len == MAX_SYMBOL_LENGTH) {
+				return 0;
+			}
+			key |= (uint64_t)(uint8_t)symbol[len] << (56 - 8 * len);
+		}
+		return key;
+	}
+
+	// Position of the first key not less than key
+	size_t lower_bound(uint64_t key) const {
+		size_t low = 0;
+		size_t high = count_;
+		while (low < high) {
+			size_t mid = (low + high) / 2;
+			if (keys_[mid] < key) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		return low;
+	}
+
+	Slot slots_[Slots];
+	uint64_t keys_[Slots];  // Sorted
+	uint8_t index_[Slots];  // Slot holding each key
+	size_t count_ = 0;
+};
+
+using StockWatchlist =
+    Watchlist<WATCHLIST_MAX_SYMBOLS, WATCHLIST_SERIES_CAPACITY>;
+static_assert(sizeof(StockWatchlist) <= WATCHLIST_MEMORY_BUDGET,
+              "Watchlist is over its memory budget");
+// Leave room to raise WATCHLIST_MAX_SYMBOLS to 30 without a new budget
+static_assert(sizeof(Watchlist<30, WATCHLIST_SERIES_CAPACITY>) <=
+                  WATCHLIST_MEMORY_BUDGET,
+              "30 symbols no longer fit the watchlist memory budget");
+
+// Add the symbols in a comma separated list, such as "AAPL,MSFT", to the
+// watchlist and register the 'watch' console command. Returns how many were
+// added.
+size_t watchlist_init(const char *symbols);
+
+// Symbols in the order added; the first one is shown on the display
+size_t watchlist_size();
+bool watchlist_symbol(size_t i, char *symbol, size_t symbol_size);
+
+// Store the newest stretch of a fetch in its symbol's slot. Symbols not on
+// the watchlist are ignored. Data that wasn't just fetched, such as a copy
+// kept from before a reboot, fills the slot but leaves it stale.
+bool watchlist_record(const StockData &data, bool fetched = true);
+
+// Print every slot, with its age and whether it is stale, and the memory
+// the watchlist takes
+void watchlist_print();
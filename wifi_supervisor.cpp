@@ -0,0 +1,209 @@
+#include "wifi_supervisor.hpp"
+
+#include <cstdio>
+
+#include "pico/cyw43_arch.h"
+#include "task.h"
+
+#include "lwip/netif.h"
+
+#include "dlog.h"
+#include "task_registry.hpp"
+#include "trace_buffer.h"
+
+#define WIFI_SUPERVISOR_TASK_PRIORITY (tskIDLE_PRIORITY + 3UL)
+#define WIFI_SUPERVISOR_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+
+static const char *wifi_ssid = nullptr;
+static const char *wifi_password = nullptr;
+
+static EventGroupHandle_t wifi_events = NULL;
+static TaskHandle_t supervisor_task_handle = NULL;
+#if STATIC_ALLOCATION
+static StaticEventGroup_t wifi_events_buffer;
+#endif
+
+static WifiEventHandler subscribers[WIFI_SUPERVISOR_MAX_SUBSCRIBERS];
+static volatile size_t num_subscribers = 0;
+
+// Only touched by the supervisor task, apart from the status report
+static TickType_t join_started = 0;
+static uint32_t link_drops = 0;
+static uint32_t joins = 0;
+static ip4_addr_t bound_addr;
+
+// lwIP callback, run in the driver's context with the lwIP lock held. Just
+// hands the change over to the supervisor task.
+static void netif_changed(struct netif *netif) {
+	(void)netif;
+	if (supervisor_task_handle != NULL) {
+		xTaskNotifyGive(supervisor_task_handle);
+	}
+}
+
+static void publish(WifiEvent event) {
+	for (size_t i = 0; i < num_subscribers; i++) {
+		subscribers[i](event);
+	}
+}
+
+// Joins in the background; the outcome arrives through the netif callbacks
+static void start_join() {
+	joins++;
+	join_started = xTaskGetTickCount();
+	int err = cyw43_arch_wifi_connect_async(wifi_ssid, wifi_password,
+	                                        CYW43_AUTH_WPA2_AES_PSK);
+	if (err) {
+		DLOG_WARN("Wi-Fi join failed to start: %d\n", err);
+	}
+}
+
+// Compare the netif against the published bits and announce any changes
+static void update_state() {
+	struct netif *netif = &cyw43_state.netif[CYW43_ITF_STA];
+	cyw43_arch_lwip_begin();
+	bool link_up = netif_is_link_up(netif);
+	ip4_addr_t addr = *netif_ip4_addr(netif);
+	bool bound = link_up && netif_is_up(netif) && !ip4_addr_isany_val(addr);
+	cyw43_arch_lwip_end();
+
+	EventBits_t bits = xEventGroupGetBits(wifi_events);
+	bool was_link_up = bits & WIFI_BIT_LINK_UP;
+	bool was_bound = bits & WIFI_BIT_CONNECTED;
+
+	if (was_bound && !bound) {
+		xEventGroupClearBits(wifi_events, WIFI_BIT_CONNECTED);
+		DLOG_WARN("Wi-Fi address lost\n");
+		publish(WIFI_EVENT_IP_LOST);
+	}
+	if (link_up && !was_link_up) {
+		xEventGroupSetBits(wifi_events, WIFI_BIT_LINK_UP);
+		DLOG_INFO("Wi-Fi link up\n");
+		publish(WIFI_EVENT_LINK_UP);
+	} else if (!link_up && was_link_up) {
+		xEventGroupClearBits(wifi_events, WIFI_BIT_LINK_UP);
+		link_drops++;
+		DLOG_WARN("Wi-Fi link down, rejoining\n");
+		publish(WIFI_EVENT_LINK_DOWN);
+		start_join();
+	}
+	if (bound && !was_bound) {
+		bound_addr = addr;
+		xEventGroupSetBits(wifi_events, WIFI_BIT_CONNECTED);
+		DLOG_INFO("Wi-Fi connected, IP %d.%d.%d.%d\n", ip4_addr1_16(&addr),
+		          ip4_addr2_16(&addr), ip4_addr3_16(&addr),
+		          ip4_addr4_16(&addr));
+		publish(WIFI_EVENT_IP_BOUND);
+	}
+}
+
+static void supervisor_task(__unused void *params) {
+	// Set before the callbacks can fire, rather than waiting for the creator
+	supervisor_task_handle = xTaskGetCurrentTaskHandle();
+	cyw43_arch_enable_sta_mode();
+
+	// The driver creates the netif when station mode is enabled
+	cyw43_arch_lwip_begin();
+	struct netif *netif = &cyw43_state.netif[CYW43_ITF_STA];
+	netif_set_link_callback(netif, netif_changed);
+	netif_set_status_callback(netif, netif_changed);
+	cyw43_arch_lwip_end();
+
+	start_join();
+
+	const TickType_t join_timeout =
+	    pdMS_TO_TICKS(WIFI_SUPERVISOR_JOIN_TIMEOUT_MS);
+	while (true) {
+		// Nothing to do while connected until a callback fires. While
+		// joining, also wake when the attempt runs out of time.
+		TickType_t wait = portMAX_DELAY;
+		if (!wifi_supervisor_connected()) {
+			TickType_t elapsed = xTaskGetTickCount() - join_started;
+			wait = elapsed < join_timeout ? join_timeout - elapsed : 0;
+		}
+		ulTaskNotifyTake(pdTRUE, wait);
+
+		update_state();
+
+		if (!wifi_supervisor_connected() &&
+		    xTaskGetTickCount() - join_started >= join_timeout) {
+			// Failures such as a wrong password or a missing network never
+			// reach the netif, so they only show in the driver's status
+			int status = cyw43_wifi_link_status(&cyw43_state, CYW43_ITF_STA);
+			if (status == CYW43_LINK_BADAUTH) {
+				DLOG_ERROR("Wi-Fi authentication failed, retrying\n");
+			} else {
+				DLOG_WARN("Wi-Fi join timed out (status %d), retrying\n",
+				          status);
+			}
+			start_join();
+		}
+	}
+}
+
+void wifi_supervisor_init(const char *ssid, const char *password,
+                          UBaseType_t core_mask) {
+	wifi_ssid = ssid;
+	wifi_password = password;
+
+#if STATIC_ALLOCATION
+	wifi_events = xEventGroupCreateStatic(&wifi_events_buffer);
+#else
+	wifi_events = xEventGroupCreate();
+#endif
+	if (wifi_events == NULL) {
+		printf("Failed to create Wi-Fi event group\n");
+		return;
+	}
+	trace_buffer_name_object(wifi_events, "wifi_events");
+
+	task_registry_create(supervisor_task, "WiFiThread",
+	                     WIFI_SUPERVISOR_TASK_STACK_SIZE,
+	                     WIFI_SUPERVISOR_TASK_PRIORITY, core_mask,
+	                     &supervisor_task_handle);
+}
+
+bool wifi_supervisor_subscribe(WifiEventHandler handler) {
+	bool added = false;
+	taskENTER_CRITICAL();
+	if (num_subscribers < WIFI_SUPERVISOR_MAX_SUBSCRIBERS) {
+		subscribers[num_subscribers] = handler;
+		num_subscribers = num_subscribers + 1;
+		added = true;
+	}
+	taskEXIT_CRITICAL();
+
+	if (!added) {
+		printf("Wi-Fi subscriber table full\n");
+	}
+	return added;
+}
+
+bool wifi_supervisor_wait_connected(TickType_t timeout) {
+	if (wifi_events == NULL) {
+		return false;
+	}
+	EventBits_t bits = xEventGroupWaitBits(wifi_events, WIFI_BIT_CONNECTED,
+	                                       pdFALSE, pdTRUE, timeout);
+	return bits & WIFI_BIT_CONNECTED;
+}
+
+bool wifi_supervisor_connected() {
+	return wifi_events != NULL &&
+	       (xEventGroupGetBits(wifi_events) & WIFI_BIT_CONNECTED);
+}
+
+void wifi_supervisor_print_status() {
+	EventBits_t bits = wifi_events ? xEventGroupGetBits(wifi_events) : 0;
+	if (bits & WIFI_BIT_CONNECTED) {
+		printf("Wi-Fi: connected, IP %d.%d.%d.%d\n", ip4_addr1_16(&bound_addr),
+		       ip4_addr2_16(&bound_addr), ip4_addr3_16(&bound_addr),
+		       ip4_addr4_16(&bound_addr));
+	} else {
+		printf("Wi-Fi: %s (driver status %d)\n",
+		       bits & WIFI_BIT_LINK_UP ? "waiting for DHCP" : "joining",
+		       cyw43_wifi_link_status(&cyw43_state, CYW43_ITF_STA));
+	}
+	printf("  %lu joins, %lu link drops\n", (unsigned long)joins,
+	       (unsigned long)link_drops);
+}
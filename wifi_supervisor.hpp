@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "FreeRTOS.h"
+#include "event_groups.h"
+
+// How long a join may take before it is abandoned and started again
+#define WIFI_SUPERVISOR_JOIN_TIMEOUT_MS 30000
+#define WIFI_SUPERVISOR_MAX_SUBSCRIBERS 4
+
+// State bits of the supervisor's event group. They stay set for as long as
+// the condition holds, so any number of tasks can wait on them.
+#define WIFI_BIT_LINK_UP (1u << 0)   // associated with the access point
+#define WIFI_BIT_CONNECTED (1u << 1) // link up and a DHCP lease bound
+
+enum WifiEvent : uint8_t {
+	WIFI_EVENT_LINK_UP,
+	WIFI_EVENT_LINK_DOWN,
+	WIFI_EVENT_IP_BOUND,
+	WIFI_EVENT_IP_LOST,
+};
+
+// Called from the supervisor task on every state change, so it must not
+// block for long
+typedef void (*WifiEventHandler)(WifiEvent event);
+
+// Start station mode and the supervisor task on the given cores. It joins
+// the network, follows the lwIP link and status callbacks and rejoins
+// whenever the link drops. ssid and password must outlive it.
+void wifi_supervisor_init(const char *ssid, const char *password,
+                          UBaseType_t core_mask);
+
+// Add a handler for link events. Register before wifi_supervisor_init to be
+// sure of seeing the first connection.
+bool wifi_supervisor_subscribe(WifiEventHandler handler);
+
+// Block until the link is up with an address. Returns false on timeout.
+bool wifi_supervisor_wait_connected(TickType_t timeout = portMAX_DELAY);
+
+bool wifi_supervisor_connected();
+
+// Link state, address and drop/rejoin counts over stdio
+void wifi_supervisor_print_status();